@@ -1,6 +1,6 @@
 #include <SFML/Graphics.hpp>
 #include <Box2D/Box2D.h>
-#include <iostream>
+#include "../include/Logger.hpp"
 using namespace std;
 
 int main()
@@ -72,7 +72,7 @@ int main()
         // Actualizar el mundo de Box2D
         // Ajustar el valor de 1.0 / 60.0 para cambiar la velocidad de la simulación física
         mundo.Step(1.0f / 60.0f, 6, 2);
-        cout << "Posicion de la bola: " << cuerpoBola->GetPosition().x << ", " << cuerpoBola->GetPosition().y << endl;
+        LOG_INFO("Posicion de la bola: {}, {}", cuerpoBola->GetPosition().x, cuerpoBola->GetPosition().y);
 
         // Limpiar la ventana
         ventana.clear();
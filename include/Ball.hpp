@@ -1,34 +1,52 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
 #include <chipmunk/chipmunk.h>
 
 class Ball {
 public:
-    Ball(cpSpace* space, float radius, float mass, const cpVect& position) {
+    Ball(cpSpace* space, float radius, float mass, const cpVect& position) : space(space), radius(radius) {
         cpFloat moment = cpMomentForCircle(mass, 0, radius, cpvzero);
         body = cpSpaceAddBody(space, cpBodyNew(mass, moment));
         cpBodySetPosition(body, position);
         shape = cpSpaceAddShape(space, cpCircleShapeNew(body, radius, cpvzero));
         cpShapeSetFriction(shape, 0.7);
+        ballShape.setRadius(radius);
+        ballShape.setOrigin(radius, radius);
+        ballShape.setFillColor(sf::Color::Red);
     }
 
-    sf::CircleShape GetShape() {
-        sf::CircleShape ballShape(20.0);
+    // The shape is kept between calls and only moved to the body's position.
+    // For many balls use PhysicsEntityStore, which draws them in one call.
+    const sf::CircleShape& GetShape() {
         cpVect ballPosition = cpBodyGetPosition(body);
         ballShape.setPosition(ballPosition.x, ballPosition.y);
-        ballShape.setFillColor(sf::Color::Red);
         return ballShape;
     }
 
+    // Must run before the space is freed
     ~Ball() {
+        if (cpSpaceContainsShape(space, shape)) cpSpaceRemoveShape(space, shape);
+        if (cpSpaceContainsBody(space, body)) cpSpaceRemoveBody(space, body);
         cpShapeFree(shape);
         cpBodyFree(body);
     }
 
+    Ball(const Ball&) = delete;
+    Ball& operator=(const Ball&) = delete;
+
     cpBody* getBody() {
         return body;
     }
 
+    float getRadius() const {
+        return radius;
+    }
+
 private:
-    int radius;
+    cpSpace* space;
+    float radius;
     cpBody* body;
     cpShape* shape;
-};
\ No newline at end of file
+    sf::CircleShape ballShape;
+};
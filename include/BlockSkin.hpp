@@ -0,0 +1,74 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <string>
+#include "PieceColors.hpp"
+#include "SpriteAtlas.hpp"
+
+// Block textures for the Tetris field, packed into one atlas: a tile per
+// cell value (pieces, specials and garbage) and a white one that the ghost
+// piece tints. Draw them through a SpriteBatch with region() and scale().
+class BlockSkin {
+public:
+    // "bevel" and "flat" are drawn at startup in the colors of the piece set
+    // in play. Anything else is a PNG with square tiles side by side, at any
+    // size (they are scaled to the block size): one per built-in piece in
+    // kTetrominoes order, then garbage. Pieces of a loaded set take the
+    // strip's piece tiles in turn.
+    bool load(const std::string& skin, int blockSize) {
+        atlas = SpriteAtlas();
+        int tileSize = blockSize;
+        if (skin == "bevel" || skin == "flat") {
+            for (int value = 1; value <= kGarbageCell; value++) {
+                if (value > pieceTable.count && value != kGarbageCell) continue;
+                regions[value] = atlas.add("block" + std::to_string(value), makeTile(pieceColor(value), blockSize, skin == "bevel"));
+            }
+        } else {
+            sf::Image strip;
+            if (!strip.loadFromFile(skin)) return false;
+            tileSize = (int)strip.getSize().y;
+            if (tileSize <= 0 || (int)strip.getSize().x < tileSize * (kPieceTypes + 1)) return false;
+            atlas.addFrames("block", strip, sf::IntRect(0, 0, tileSize, tileSize), kPieceTypes + 1, sf::Vector2i(tileSize, 0));
+            for (int value = 1; value <= pieceTable.count; value++) regions[value] = (value - 1) % kPieceTypes;
+            regions[kGarbageCell] = kPieceTypes;
+        }
+        ghost = atlas.add("ghost", makeTile(sf::Color::White, tileSize, false));
+        tileScale = (float)blockSize / tileSize;
+        return atlas.pack();
+    }
+
+    // Atlas region of a cell value (1..kGarbageCell)
+    int region(int value) const { return regions[value]; }
+    int ghostRegion() const { return ghost; }
+    float scale() const { return tileScale; }
+    const SpriteAtlas& getAtlas() const { return atlas; }
+
+private:
+    // A square of the color; beveled tiles get a lighter top-left and a
+    // darker bottom-right band and a dark outline
+    static sf::Image makeTile(const sf::Color& color, int size, bool bevel) {
+        sf::Image tile;
+        tile.create(size, size, color);
+        if (!bevel) return tile;
+        const int band = std::max(2, size / 8);
+        auto mix = [&](const sf::Color& to, float amount) {
+            return sf::Color((sf::Uint8)(color.r + (to.r - color.r) * amount), (sf::Uint8)(color.g + (to.g - color.g) * amount),
+                             (sf::Uint8)(color.b + (to.b - color.b) * amount));
+        };
+        const sf::Color light = mix(sf::Color::White, 0.45f), dark = mix(sf::Color::Black, 0.4f), outline = mix(sf::Color::Black, 0.6f);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                if (x == 0 || y == 0 || x == size - 1 || y == size - 1) tile.setPixel(x, y, outline);
+                else if (x < band || y < band) tile.setPixel(x, y, x + y < size - 1 ? light : dark);
+                else if (x >= size - band || y >= size - band) tile.setPixel(x, y, dark);
+            }
+        }
+        return tile;
+    }
+
+    SpriteAtlas atlas;
+    int regions[kGarbageCell + 1] = {};
+    int ghost = 0;
+    float tileScale = 1.0f;
+};
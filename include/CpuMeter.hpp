@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Measures how much CPU the whole process (all threads) used between samples,
+// as a fraction of one core.
+class CpuMeter {
+public:
+    CpuMeter() {
+        lastCpu = processCpuSeconds();
+        lastWall = std::chrono::steady_clock::now();
+    }
+
+    // Seconds of wall time since the last sample
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - lastWall).count();
+    }
+
+    double sample() {
+        double cpu = processCpuSeconds();
+        auto wall = std::chrono::steady_clock::now();
+        double wallSeconds = std::chrono::duration<double>(wall - lastWall).count();
+        double usage = wallSeconds > 0 ? (cpu - lastCpu) / wallSeconds : 0.0;
+        lastCpu = cpu;
+        lastWall = wall;
+        return usage;
+    }
+
+    static double processCpuSeconds() {
+#ifdef _WIN32
+        // clock() is wall time on Windows, ask the kernel instead
+        FILETIME created, exited, kernel, user;
+        GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+        auto toSeconds = [](const FILETIME& t) {
+            return (((unsigned long long)t.dwHighDateTime << 32) | t.dwLowDateTime) * 1e-7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+    }
+
+private:
+    double lastCpu;
+    std::chrono::steady_clock::time_point lastWall;
+};
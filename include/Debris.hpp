@@ -0,0 +1,166 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chipmunk/chipmunk.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Ground.hpp"
+#include "PhysicsSpace.hpp"
+
+// Falling debris: blocks removed by line clears, Electrical wipes and Fire
+// explosions become short-lived rigid bodies that tumble, bounce off a floor
+// and fade out.
+//
+// Every body and box shape is created once, up front; spawning a block only
+// positions a pooled body and adds it to the space, and despawning removes it
+// again, so a burst never allocates. When the pool is full new blocks are
+// skipped (and counted) rather than growing it. All live debris is drawn
+// with one vertex array.
+class DebrisField {
+public:
+    static const int kMaxDebris = 256;
+    static constexpr float kLife = 1.6f;        // seconds a block lives
+    static constexpr float kFadeTime = 0.5f;    // fades out over the last part of its life
+    static constexpr float kStep = 1.0f / 120.0f;
+    static const int kMaxStepsPerFrame = 4;     // after a long stall the simulation slows down instead
+
+    // blockSize is the side of a field cell; the floor spans left..right at floorY
+    DebrisField(float blockSize, float left, float right, float floorY)
+        : space(physicsSettings()), floor(space.getSpace(), cpv(left, floorY), cpv(right, floorY)) {
+        cpShapeSetElasticity(floor.getShape(), 0.5);
+        // Slightly smaller than a cell so blocks spawned side by side do not
+        // start out overlapping
+        float size = blockSize * 0.9f;
+        pool.resize(kMaxDebris);
+        freeList.reserve(kMaxDebris);
+        active.reserve(kMaxDebris);
+        for (int i = kMaxDebris - 1; i >= 0; i--) {
+            Debris& d = pool[i];
+            d.body = cpBodyNew(1.0, cpMomentForBox(1.0, size, size));
+            d.shape = cpBoxShapeNew(d.body, size, size, 0.0);
+            cpShapeSetFriction(d.shape, 0.6);
+            cpShapeSetElasticity(d.shape, 0.4);
+            freeList.push_back(i);
+        }
+        halfSize = size * 0.5f;
+        vertices.reserve(kMaxDebris * 4);
+    }
+
+    ~DebrisField() {
+        clear();
+        for (Debris& d : pool) {
+            cpShapeFree(d.shape);
+            cpBodyFree(d.body);
+        }
+    }
+
+    // Launches a block from the center of a cell with a velocity in pixels
+    // per second and a spin in radians per second. False when the pool is full.
+    bool spawn(float x, float y, const sf::Color& color, float vx, float vy, float spin) {
+        if (freeList.empty()) {
+            dropped++;
+            return false;
+        }
+        int index = freeList.back();
+        freeList.pop_back();
+        Debris& d = pool[index];
+        cpBodySetPosition(d.body, cpv(x, y));
+        cpBodySetVelocity(d.body, cpv(vx, vy));
+        cpBodySetAngle(d.body, 0.0);
+        cpBodySetAngularVelocity(d.body, spin);
+        cpSpaceAddBody(space.getSpace(), d.body);
+        cpSpaceAddShape(space.getSpace(), d.shape);
+        d.life = kLife;
+        d.color = color;
+        active.push_back(index);
+        return true;
+    }
+
+    void update(float dt) {
+        for (size_t i = 0; i < active.size();) {
+            Debris& d = pool[active[i]];
+            d.life -= dt;
+            if (d.life > 0.0f) {
+                i++;
+                continue;
+            }
+            release(active[i]);
+            active[i] = active.back();
+            active.pop_back();
+        }
+        if (active.empty()) {
+            accumulator = 0.0f;
+            return;
+        }
+        accumulator += dt;
+        int steps = 0;
+        while (accumulator >= kStep && steps < kMaxStepsPerFrame) {
+            space.step(kStep);
+            accumulator -= kStep;
+            steps++;
+        }
+        if (steps == kMaxStepsPerFrame) accumulator = 0.0f;
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (active.empty()) return;
+        vertices.clear();
+        for (int index : active) {
+            const Debris& d = pool[index];
+            cpVect p = cpBodyGetPosition(d.body);
+            cpVect r = cpBodyGetRotation(d.body); // (cos, sin) of the angle
+            float ax = (float)r.x * halfSize, ay = (float)r.y * halfSize;
+            sf::Color color = d.color;
+            if (d.life < kFadeTime) color.a = (sf::Uint8)(color.a * d.life / kFadeTime);
+            float cx = (float)p.x, cy = (float)p.y;
+            vertices.emplace_back(sf::Vector2f(cx - ax + ay, cy - ay - ax), color);
+            vertices.emplace_back(sf::Vector2f(cx + ax + ay, cy + ay - ax), color);
+            vertices.emplace_back(sf::Vector2f(cx + ax - ay, cy + ay + ax), color);
+            vertices.emplace_back(sf::Vector2f(cx - ax - ay, cy - ay + ax), color);
+        }
+        target.draw(vertices.data(), vertices.size(), sf::Quads);
+    }
+
+    void clear() {
+        for (int index : active) release(index);
+        active.clear();
+        accumulator = 0.0f;
+    }
+
+    bool empty() const { return active.empty(); }
+    int count() const { return (int)active.size(); }
+
+    uint64_t dropped = 0; // blocks skipped because the pool was full
+
+private:
+    // A few hundred small boxes settle well with fewer solver iterations
+    static PhysicsSettings physicsSettings() {
+        PhysicsSettings settings;
+        settings.iterations = 6;
+        return settings;
+    }
+
+    struct Debris {
+        cpBody* body = nullptr;
+        cpShape* shape = nullptr;
+        float life = 0.0f;
+        sf::Color color;
+    };
+
+    void release(int index) {
+        Debris& d = pool[index];
+        cpSpaceRemoveShape(space.getSpace(), d.shape);
+        cpSpaceRemoveBody(space.getSpace(), d.body);
+        freeList.push_back(index);
+    }
+
+    PhysicsSpace space;
+    Suelo floor;
+    std::vector<Debris> pool;
+    std::vector<int> freeList;
+    std::vector<int> active;
+    std::vector<sf::Vertex> vertices;
+    float halfSize = 0.0f;
+    float accumulator = 0.0f;
+};
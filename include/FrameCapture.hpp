@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CAPTURE_SSE2 1
+#endif
+
+// Gameplay recorder. The game thread copies each rendered frame into a slot
+// of a fixed ring of reusable RGBA buffers and moves on; a worker thread
+// converts the frames and writes them out. When every slot is still waiting
+// for the worker the frame is dropped and counted instead of waiting, so
+// recording never stalls the game loop.
+//
+// Files ending in .y4m get an uncompressed YUV 4:2:0 stream (full range
+// BT.601) that ffmpeg and most players read directly; anything else gets raw
+// RGBA frames, top row first.
+
+// RGBA rows to the Y plane: Y = (77 R + 150 G + 29 B + 128) >> 8
+inline void rgbaToLuma(const uint8_t* rgba, uint8_t* y, int width)
+{
+    int x = 0;
+#ifdef CAPTURE_SSE2
+    // Four pixels per register as 32-bit lanes; the weighted sum stays below
+    // 65536, so 16-bit multiplies on the low halves are exact
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i kr = _mm_set1_epi32(77), kg = _mm_set1_epi32(150), kb = _mm_set1_epi32(29);
+    const __m128i round = _mm_set1_epi32(128);
+    auto luma4 = [&](const uint8_t* p) {
+        __m128i px = _mm_loadu_si128((const __m128i*)p);
+        __m128i r = _mm_and_si128(px, mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+        __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi16(r, kr), _mm_mullo_epi16(g, kg)),
+                                    _mm_add_epi32(_mm_mullo_epi16(b, kb), round));
+        return _mm_srli_epi32(sum, 8);
+    };
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* p = rgba + x * 4;
+        __m128i lo = _mm_packs_epi32(luma4(p), luma4(p + 16));
+        __m128i hi = _mm_packs_epi32(luma4(p + 32), luma4(p + 48));
+        _mm_storeu_si128((__m128i*)(y + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < width; x++) {
+        const uint8_t* p = rgba + x * 4;
+        y[x] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+    }
+}
+
+// Two RGBA rows to one row of each chroma plane, averaging 2x2 blocks
+inline void rgbaToChroma(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v, int width)
+{
+    for (int x = 0; x < width / 2; x++) {
+        const uint8_t* a = row0 + x * 8;
+        const uint8_t* b = row1 + x * 8;
+        int r = a[0] + a[4] + b[0] + b[4];
+        int g = a[1] + a[5] + b[1] + b[5];
+        int bl = a[2] + a[6] + b[2] + b[6];
+        u[x] = (uint8_t)(((-43 * r - 85 * g + 128 * bl + 512) >> 10) + 128);
+        v[x] = (uint8_t)(((128 * r - 107 * g - 21 * bl + 512) >> 10) + 128);
+    }
+}
+
+class FrameCapture {
+public:
+    static const int kSlots = 8; // must be a power of two
+
+    FrameCapture(const std::string& path, int width, int height, int fps = 60)
+        : width(width), height(height), y4m(path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0) {
+        // 4:2:0 needs even sizes, the last row or column is cropped
+        if (y4m) {
+            outWidth = width & ~1;
+            outHeight = height & ~1;
+        } else {
+            outWidth = width;
+            outHeight = height;
+        }
+        file = fopen(path.c_str(), "wb");
+        if (!file) return;
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        if (y4m) fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", outWidth, outHeight, fps);
+        for (auto& s : slots) s.pixels.resize((size_t)width * height * 4);
+        planes.resize((size_t)outWidth * outHeight * 3 / 2);
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~FrameCapture() { finish(); }
+
+    // Writes the frames still queued and closes the file
+    void finish() {
+        running.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Game thread: a free slot of width * height * 4 bytes to fill, or null
+    // when the worker is behind (the frame is counted as dropped)
+    uint8_t* beginFrame() {
+        uint32_t head = queueHead.load(std::memory_order_relaxed);
+        uint32_t tail = queueTail.load(std::memory_order_acquire);
+        if (!file || head - tail >= (uint32_t)kSlots) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return slots[head & (kSlots - 1)].pixels.data();
+    }
+
+    // Hands the slot from beginFrame() to the worker. bottomUp is set for
+    // OpenGL readbacks, which return the last row first.
+    void endFrame(bool bottomUp) {
+        uint32_t head = queueHead.load(std::memory_order_relaxed);
+        slots[head & (kSlots - 1)].bottomUp = bottomUp;
+        queueHead.store(head + 1, std::memory_order_seq_cst);
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        if (workerIdle.load(std::memory_order_seq_cst)) wake.notify_one();
+    }
+
+    // Time the game thread spent on a frame for capture (readback and copy)
+    void addSubmitTime(double seconds) {
+        submitUs.fetch_add((uint64_t)(seconds * 1e6), std::memory_order_relaxed);
+        submitFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::string report() const {
+        uint64_t frames = submitFrames.load();
+        uint64_t done = written.load();
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "capture: %llu frames written, %llu dropped, %.0f us/frame on the game thread, %.0f us/frame convert + write",
+                 (unsigned long long)done, (unsigned long long)dropped.load(), frames ? (double)submitUs.load() / frames : 0.0,
+                 done ? (double)workerUs.load() / done : 0.0);
+        return line;
+    }
+
+    // Counters are updated with relaxed atomics and can be read at any time
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> submitUs{0};
+    std::atomic<uint64_t> submitFrames{0};
+    std::atomic<uint64_t> workerUs{0};
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        bool bottomUp = false;
+    };
+
+    const uint8_t* sourceRow(const Slot& s, int y) const {
+        return s.pixels.data() + (size_t)(s.bottomUp ? height - 1 - y : y) * width * 4;
+    }
+
+    void writeFrame(const Slot& s) {
+        if (!y4m) {
+            for (int y = 0; y < outHeight; y++) fwrite(sourceRow(s, y), 1, (size_t)outWidth * 4, file);
+            return;
+        }
+        uint8_t* yPlane = planes.data();
+        uint8_t* uPlane = yPlane + (size_t)outWidth * outHeight;
+        uint8_t* vPlane = uPlane + (size_t)outWidth * outHeight / 4;
+        for (int y = 0; y < outHeight; y += 2) {
+            const uint8_t* row0 = sourceRow(s, y);
+            const uint8_t* row1 = sourceRow(s, y + 1);
+            rgbaToLuma(row0, yPlane + (size_t)y * outWidth, outWidth);
+            rgbaToLuma(row1, yPlane + (size_t)(y + 1) * outWidth, outWidth);
+            rgbaToChroma(row0, row1, uPlane + (size_t)y / 2 * outWidth / 2, vPlane + (size_t)y / 2 * outWidth / 2, outWidth);
+        }
+        fputs("FRAME\n", file);
+        fwrite(planes.data(), 1, planes.size(), file);
+    }
+
+    void run() {
+        for (;;) {
+            uint32_t tail = queueTail.load(std::memory_order_relaxed);
+            if (tail != queueHead.load(std::memory_order_acquire)) {
+                auto start = std::chrono::steady_clock::now();
+                writeFrame(slots[tail & (kSlots - 1)]);
+                queueTail.store(tail + 1, std::memory_order_release);
+                workerUs.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - start).count(),
+                                   std::memory_order_relaxed);
+                written.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (!running.load(std::memory_order_relaxed)) break;
+            // Nothing queued: sleep until endFrame() wakes us (the timeout
+            // covers a wakeup that races with going idle)
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            workerIdle.store(true, std::memory_order_seq_cst);
+            wake.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+                return !running.load(std::memory_order_relaxed) ||
+                       queueHead.load(std::memory_order_seq_cst) != queueTail.load(std::memory_order_relaxed);
+            });
+            workerIdle.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    int width, height;
+    int outWidth = 0, outHeight = 0;
+    bool y4m;
+    FILE* file = nullptr;
+    Slot slots[kSlots];
+    std::vector<uint8_t> planes;
+    std::atomic<uint32_t> queueHead{0};
+    std::atomic<uint32_t> queueTail{0};
+    std::atomic<bool> running{true};
+    std::atomic<bool> workerIdle{false};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread worker;
+};
@@ -1,37 +1,208 @@
-class GameWindow {
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+// How presented frames are spaced out:
+//   PACING_VSYNC     the driver blocks in display() until the next refresh
+//   PACING_HYBRID    sleeps until shortly before the frame is due, then spins
+//                    on the clock for the rest, so every frame lands on an
+//                    exact period instead of sf::Window's millisecond sleeps
+//   PACING_UNCAPPED  as fast as possible, only measured
+enum PacingMode { PACING_VSYNC, PACING_HYBRID, PACING_UNCAPPED };
+
+// Intervals between presented frames. Jitter is how much an interval
+// differs from the one before it, which is what the eye sees as stutter.
+struct FrameStats {
+    uint64_t frames = 0;         // intervals measured
+    uint64_t missed = 0;         // frames that came half a period or more late
+    double meanMs = 0.0;
+    double worstMs = 0.0;
+    double jitterTotalMs = 0.0;
+    double worstJitterMs = 0.0;
+    double m2 = 0.0;             // running sum of squared deviations (Welford)
+
+    void add(double ms, double previousMs, bool late) {
+        frames++;
+        if (late) missed++;
+        double delta = ms - meanMs;
+        meanMs += delta / frames;
+        m2 += delta * (ms - meanMs);
+        worstMs = std::max(worstMs, ms);
+        if (frames > 1) {
+            double jitter = std::fabs(ms - previousMs);
+            jitterTotalMs += jitter;
+            worstJitterMs = std::max(worstJitterMs, jitter);
+        }
+    }
+
+    double varianceMs() const { return frames > 1 ? m2 / (frames - 1) : 0.0; }
+    double stddevMs() const { return std::sqrt(varianceMs()); }
+    double jitterMs() const { return frames > 1 ? jitterTotalMs / (frames - 1) : 0.0; }
+};
+
+// Frame timing without a window, so the bench can measure it headless. Call
+// wait() right before presenting and presented() right after; a loop that
+// skips presenting a frame calls skipFrame() instead.
+class FramePacer {
 public:
-    GameWindow(int width, int height, const std::string& title) {
-        window.create(sf::VideoMode(width, height), title);
+    typedef std::chrono::steady_clock Clock;
+
+    void setMode(PacingMode newMode, double hz = 60.0) {
+        mode = newMode;
+        period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(1.0, hz)));
+        spinMargin = std::min<Clock::duration>(std::chrono::milliseconds(2), period / 2);
+        overshoot = std::chrono::milliseconds(1);
+        scheduled = false;
+        restart();
     }
 
-    bool isOpen() {
-        return window.isOpen();
+    // Hybrid mode: blocks until the frame is due
+    void wait() {
+        if (mode != PACING_HYBRID) return;
+        Clock::time_point now = Clock::now();
+        if (!scheduled) {
+            deadline = now;
+            scheduled = true;
+        }
+        if (deadline - now > spinMargin) sleepUntil(deadline - spinMargin);
+        Clock::time_point spinStart = Clock::now();
+        while ((now = Clock::now()) < deadline) {
+        }
+        spinSeconds += std::chrono::duration<double>(now - spinStart).count();
+        late = now - deadline >= period / 2;
+        // Keep the phase after a small miss; after missing a whole period
+        // start over from now rather than rushing frames to catch up
+        deadline += period;
+        if (deadline <= now) deadline = now + period;
     }
 
-    void close() {
-        window.close();
+    void presented() {
+        Clock::time_point now = Clock::now();
+        if (hasLast) {
+            double ms = std::chrono::duration<double, std::milli>(now - last).count();
+            bool missed = false;
+            if (mode == PACING_HYBRID) missed = late;
+            else if (mode == PACING_VSYNC) missed = now - last >= period + period / 2;
+            frameStats.add(ms, previousMs, missed);
+            previousMs = ms;
+        }
+        last = now;
+        hasLast = true;
+        late = false;
+        if (mode == PACING_VSYNC) {
+            deadline = now + period;
+            scheduled = true;
+        }
     }
 
-    void clear() {
-        window.clear();
+    // Keeps the frame rate on a frame that is not presented. Nobody sees
+    // this frame, so it only sleeps (no spinning) and breaks the chain of
+    // intervals: the next presented frame starts a new one.
+    void skipFrame() {
+        if (mode != PACING_UNCAPPED) {
+            Clock::time_point now = Clock::now();
+            if (!scheduled || deadline <= now) {
+                deadline = now + period;
+                scheduled = true;
+            }
+            sleepUntil(deadline);
+            deadline += period;
+        }
+        restart();
     }
 
-    void display() {
-        window.display();
+    // The next interval is not measured, e.g. after blocking on input
+    void restart() {
+        hasLast = false;
+        late = false;
     }
 
-    void draw(sf::Shape& shape) {
-        window.draw(shape);
+    void resetStats() {
+        frameStats = FrameStats();
+        spinSeconds = 0.0;
     }
 
-    bool pollEvent(sf::Event& event) {
-        return window.pollEvent(event);
+    const FrameStats& stats() const { return frameStats; }
+    PacingMode getMode() const { return mode; }
+    double periodMs() const { return std::chrono::duration<double, std::milli>(period).count(); }
+    double spinMarginMs() const { return std::chrono::duration<double, std::milli>(spinMargin).count(); }
+    double spunSeconds() const { return spinSeconds; } // CPU time spent spinning since resetStats()
+
+private:
+    // Sleeps until about the given time and learns how late sleeps wake up.
+    // The estimate steps up 19 times as far when a sleep overshoots it as it
+    // steps down otherwise, so it settles where one sleep in 20 oversleeps
+    // it; a rare long stall of the scheduler barely moves it. The spin
+    // margin is that plus a little, capped at half a period.
+    void sleepUntil(Clock::time_point when) {
+        Clock::time_point now = Clock::now();
+        if (when <= now) return;
+        sf::sleep(sf::microseconds((sf::Int64)std::chrono::duration_cast<std::chrono::microseconds>(when - now).count()));
+        const Clock::duration step = std::chrono::microseconds(5);
+        if (Clock::now() - when > overshoot) overshoot += step * 19;
+        else overshoot = std::max(Clock::duration::zero(), overshoot - step);
+        spinMargin = std::min<Clock::duration>(
+            std::max<Clock::duration>(overshoot + std::chrono::microseconds(250), std::chrono::microseconds(500)), period / 2);
     }
 
-    sf::Vector2u getSize() {
-        return window.getSize();
+    PacingMode mode = PACING_UNCAPPED;
+    Clock::duration period = std::chrono::microseconds(16667);
+    Clock::duration spinMargin = std::chrono::milliseconds(2);
+    Clock::duration overshoot = std::chrono::milliseconds(1); // about the 95th percentile of sleep overshoot
+    Clock::time_point deadline;
+    Clock::time_point last;
+    bool scheduled = false;
+    bool hasLast = false;
+    bool late = false;
+    double previousMs = 0.0;
+    double spinSeconds = 0.0;
+    FrameStats frameStats;
+};
+
+// sf::RenderWindow whose display() goes through a FramePacer. Use
+// setPacing() rather than setFramerateLimit()/setVerticalSyncEnabled(); the
+// hidden setFramerateLimit() maps onto it.
+class GameWindow : public sf::RenderWindow {
+public:
+    GameWindow(int width, int height, const std::string& title, PacingMode mode = PACING_HYBRID, double hz = 60.0)
+        : sf::RenderWindow(sf::VideoMode(width, height), title) {
+        setPacing(mode, hz);
+    }
+
+    // hz is the frame rate for hybrid pacing, and for vsync the refresh
+    // rate deadlines are checked against (SFML cannot query it)
+    void setPacing(PacingMode mode, double hz = 60.0) {
+        sf::RenderWindow::setFramerateLimit(0);
+        sf::RenderWindow::setVerticalSyncEnabled(mode == PACING_VSYNC);
+        pacer.setMode(mode, hz);
+    }
+
+    void setFramerateLimit(unsigned limit) { setPacing(limit ? PACING_HYBRID : PACING_UNCAPPED, limit ? limit : 60.0); }
+
+    void display() {
+        pacer.wait();
+        sf::RenderWindow::display();
+        pacer.presented();
     }
 
+    FramePacer& getPacer() { return pacer; }
+    const FrameStats& frameStats() const { return pacer.stats(); }
+
 private:
-    sf::RenderWindow window;
-};
\ No newline at end of file
+    FramePacer pacer;
+};
+
+// "vsync", "hybrid" or "uncapped"; false for anything else
+inline bool parsePacingMode(const std::string& name, PacingMode& mode)
+{
+    if (name == "vsync") mode = PACING_VSYNC;
+    else if (name == "hybrid") mode = PACING_HYBRID;
+    else if (name == "uncapped") mode = PACING_UNCAPPED;
+    else return false;
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include "FrameCapture.hpp"
+
+// Reads the rendered frame back from the GPU without waiting for it.
+// glReadPixels into a pixel buffer object only queues the copy; the buffer is
+// mapped kLatency frames later, when the copy has long finished, and handed
+// to FrameCapture. Falls back to a plain (blocking) glReadPixels when pixel
+// buffer objects are not available. Every GL entry point is looked up at run
+// time, so nothing extra has to be linked.
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+class GpuReadback {
+public:
+    static const int kLatency = 2;
+    static const int kBuffers = kLatency + 1;
+
+    GpuReadback(int width, int height) : width(width), height(height) {
+        genBuffers = (GenBuffersFn)sf::Context::getFunction("glGenBuffers");
+        deleteBuffers = (DeleteBuffersFn)sf::Context::getFunction("glDeleteBuffers");
+        bindBuffer = (BindBufferFn)sf::Context::getFunction("glBindBuffer");
+        bufferData = (BufferDataFn)sf::Context::getFunction("glBufferData");
+        mapBuffer = (MapBufferFn)sf::Context::getFunction("glMapBuffer");
+        unmapBuffer = (UnmapBufferFn)sf::Context::getFunction("glUnmapBuffer");
+        readPixels = (ReadPixelsFn)sf::Context::getFunction("glReadPixels");
+        pixelStore = (PixelStoreFn)sf::Context::getFunction("glPixelStorei");
+        if (!readPixels || !pixelStore) return;
+        asynchronous = genBuffers && deleteBuffers && bindBuffer && bufferData && mapBuffer && unmapBuffer;
+        if (!asynchronous) return;
+        genBuffers(kBuffers, buffers);
+        for (GLuint b : buffers) {
+            bindBuffer(GL_PIXEL_PACK_BUFFER, b);
+            bufferData(GL_PIXEL_PACK_BUFFER, (ptrdiff_t)width * height * 4, nullptr, GL_STREAM_READ);
+        }
+        bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    ~GpuReadback() {
+        if (asynchronous) deleteBuffers(kBuffers, buffers);
+    }
+
+    bool isAsynchronous() const { return asynchronous; }
+    bool isAvailable() const { return readPixels && pixelStore; }
+
+    // Call with the window's context active, after drawing and before
+    // display(). Queues the read of this frame and delivers the one queued
+    // kLatency frames ago.
+    void capture(FrameCapture& out) {
+        if (!isAvailable()) return;
+        auto start = std::chrono::steady_clock::now();
+        pixelStore(GL_PACK_ALIGNMENT, 4);
+        if (!asynchronous) {
+            uint8_t* slot = out.beginFrame();
+            if (slot) {
+                readPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, slot);
+                out.endFrame(true);
+            }
+        } else {
+            int index = (int)(frame % kBuffers);
+            bindBuffer(GL_PIXEL_PACK_BUFFER, buffers[index]);
+            readPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            if (frame >= (uint64_t)kLatency) {
+                // The oldest buffer in the ring, read kLatency frames ago
+                bindBuffer(GL_PIXEL_PACK_BUFFER, buffers[(index + 1) % kBuffers]);
+                uint8_t* slot = out.beginFrame();
+                const void* mapped = slot ? mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY) : nullptr;
+                if (mapped) {
+                    std::memcpy(slot, mapped, (size_t)width * height * 4);
+                    unmapBuffer(GL_PIXEL_PACK_BUFFER);
+                    out.endFrame(true);
+                }
+            }
+            bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        frame++;
+        out.addSubmitTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    typedef void(APIENTRY* GenBuffersFn)(GLsizei, GLuint*);
+    typedef void(APIENTRY* DeleteBuffersFn)(GLsizei, const GLuint*);
+    typedef void(APIENTRY* BindBufferFn)(GLenum, GLuint);
+    typedef void(APIENTRY* BufferDataFn)(GLenum, ptrdiff_t, const void*, GLenum);
+    typedef void*(APIENTRY* MapBufferFn)(GLenum, GLenum);
+    typedef GLboolean(APIENTRY* UnmapBufferFn)(GLenum);
+    typedef void(APIENTRY* ReadPixelsFn)(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void*);
+    typedef void(APIENTRY* PixelStoreFn)(GLenum, GLint);
+
+    int width, height;
+    bool asynchronous = false;
+    uint64_t frame = 0;
+    GLuint buffers[kBuffers] = {};
+    GenBuffersFn genBuffers = nullptr;
+    DeleteBuffersFn deleteBuffers = nullptr;
+    BindBufferFn bindBuffer = nullptr;
+    BufferDataFn bufferData = nullptr;
+    MapBufferFn mapBuffer = nullptr;
+    UnmapBufferFn unmapBuffer = nullptr;
+    ReadPixelsFn readPixels = nullptr;
+    PixelStoreFn pixelStore = nullptr;
+};
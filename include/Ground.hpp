@@ -1,18 +1,32 @@
+#pragma once
+
 #include <chipmunk/chipmunk.h>
 
 class Suelo {
 public:
-    Suelo(cpSpace* space) {
+    Suelo(cpSpace* space) : Suelo(space, cpv(0, 500), cpv(800, 500)) {}
+
+    Suelo(cpSpace* space, const cpVect& from, const cpVect& to) : space(space) {
         cpBody* ground = cpSpaceGetStaticBody(space);
-        shape = cpSegmentShapeNew(ground, cpv(0, 500), cpv(800, 500), 0);
+        shape = cpSegmentShapeNew(ground, from, to, 0);
         cpShapeSetFriction(shape, 1.0);
         cpSpaceAddShape(space, shape);
     }
 
+    // Must run before the space is freed
     ~Suelo() {
+        if (cpSpaceContainsShape(space, shape)) cpSpaceRemoveShape(space, shape);
         cpShapeFree(shape);
     }
 
+    Suelo(const Suelo&) = delete;
+    Suelo& operator=(const Suelo&) = delete;
+
+    cpShape* getShape() {
+        return shape;
+    }
+
 private:
+    cpSpace* space;
     cpShape* shape;
-};
\ No newline at end of file
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// Latency histogram with log2 microsecond buckets. Every field is atomic, so
+// any thread can add samples while another one reads.
+struct LatencyStats {
+    static const int kBuckets = 24; // log2 microsecond buckets
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalUs{0};
+    std::atomic<uint64_t> maxUs{0};
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+
+    void add(uint64_t us) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalUs.fetch_add(us, std::memory_order_relaxed);
+        if (us > maxUs.load(std::memory_order_relaxed)) maxUs.store(us, std::memory_order_relaxed);
+        int b = 0;
+        while (b < kBuckets - 1 && (1ull << (b + 1)) <= us) b++;
+        buckets[b].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double averageUs() const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        return n ? (double)totalUs.load(std::memory_order_relaxed) / n : 0.0;
+    }
+
+    // Starts a new measurement window. Not atomic as a whole, a sample added
+    // concurrently may land in either window.
+    void reset() {
+        count.store(0, std::memory_order_relaxed);
+        totalUs.store(0, std::memory_order_relaxed);
+        maxUs.store(0, std::memory_order_relaxed);
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket holding the given percentile
+    uint64_t percentileUs(double p) const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        if (n == 0) return 0;
+        uint64_t target = (uint64_t)std::ceil(n * p);
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; b++) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= target) return 1ull << (b + 1);
+        }
+        return maxUs.load(std::memory_order_relaxed);
+    }
+};
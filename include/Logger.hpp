@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Asynchronous logger. A log call only copies its arguments, in binary, into
+// a fixed-size record of a ring owned by the calling thread (single producer,
+// no locks, no allocation); formatting and I/O happen on a background thread
+// that drains every ring, orders the records by time and writes them out.
+// That thread sleeps without a timeout while there is nothing to write, and a
+// log call only takes its mutex to wake it.
+// When a ring is full the record is dropped and counted instead of blocking.
+//
+// Messages use {} placeholders filled in order with the arguments:
+//     LOG_WARN("font not loaded, expected {}", path);
+// Format strings must be literals (only the pointer is stored). Numbers, bools
+// and strings are supported; strings are copied and may be truncated.
+//
+// Every call site is rate limited on its own (kDefaultRateLimit messages per
+// second unless changed); the next message that gets through reports how many
+// were suppressed.
+
+enum LogLevel {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+};
+
+enum LogArgType : uint8_t {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_BOOL,
+    LOG_ARG_STRING
+};
+
+struct LogRecord {
+    static const int kMaxArgs = 8;
+    static const int kPayloadSize = 92;
+
+    int64_t timeNs;
+    const char* format;
+    uint32_t suppressed;
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t types[kMaxArgs];
+    uint8_t payloadUsed;
+    uint8_t payload[kPayloadSize];
+
+    void put(LogArgType type, const void* data, size_t size) {
+        if (argCount >= kMaxArgs || payloadUsed + size > (size_t)kPayloadSize) return;
+        types[argCount++] = type;
+        std::memcpy(payload + payloadUsed, data, size);
+        payloadUsed += (uint8_t)size;
+    }
+
+    void putString(const char* s, size_t length) {
+        if (argCount >= kMaxArgs || payloadUsed + 1 > kPayloadSize) return;
+        length = std::min(length, (size_t)(kPayloadSize - payloadUsed - 1));
+        types[argCount++] = LOG_ARG_STRING;
+        payload[payloadUsed++] = (uint8_t)length;
+        std::memcpy(payload + payloadUsed, s, length);
+        payloadUsed += (uint8_t)length;
+    }
+
+    template <class T>
+    void add(const T& value) {
+        if constexpr (std::is_same<T, bool>::value) {
+            uint8_t b = value;
+            put(LOG_ARG_BOOL, &b, 1);
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            if constexpr (std::is_signed<T>::value || std::is_enum<T>::value) {
+                int64_t v = (int64_t)value;
+                put(LOG_ARG_INT, &v, 8);
+            } else {
+                uint64_t v = (uint64_t)value;
+                put(LOG_ARG_UINT, &v, 8);
+            }
+        } else if constexpr (std::is_floating_point<T>::value) {
+            double v = (double)value;
+            put(LOG_ARG_DOUBLE, &v, 8);
+        } else if constexpr (std::is_array<T>::value) {
+            putString(value, std::strlen(value));
+        } else if constexpr (std::is_convertible<const T&, const char*>::value) {
+            const char* s = value ? (const char*)value : "(null)";
+            putString(s, std::strlen(s));
+        } else {
+            const std::string& s = value;
+            putString(s.data(), s.size());
+        }
+    }
+};
+
+// Per call site rate limit state, a static created by the LOG_ macros
+struct LogSite {
+    std::atomic<int64_t> second{-1};
+    std::atomic<int> count{0};
+    std::atomic<uint32_t> suppressed{0};
+
+    bool allow(int64_t nowNs, int limit) {
+        if (limit <= 0) return true;
+        int64_t s = nowNs / 1000000000;
+        int64_t seen = second.load(std::memory_order_relaxed);
+        if (seen != s && second.compare_exchange_strong(seen, s, std::memory_order_relaxed))
+            count.store(0, std::memory_order_relaxed);
+        if (count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+};
+
+class Logger {
+public:
+    static const int kRingSize = 1024; // records per thread, power of two
+    static const int kDefaultRateLimit = 20;
+
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(flushMutex);
+            running.store(false, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+        if (output && output != stderr) fclose(output);
+    }
+
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    // Messages per second allowed from each call site, 0 for no limit
+    void setRateLimit(int perSecond) { rateLimit.store(perSecond, std::memory_order_relaxed); }
+
+    // Sends the log to a file instead of stderr
+    bool open(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "a");
+        if (!file) return false;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (output != stderr) fclose(output);
+        output = file;
+        return true;
+    }
+
+    // Blocks until everything logged before the call has been written
+    void flush() {
+        uint64_t target = logged.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(flushMutex);
+        wake.notify_one();
+        flushed.wait_for(lock, std::chrono::seconds(2), [&]() { return written.load(std::memory_order_acquire) >= target; });
+    }
+
+    // Hot path: no allocation, no formatting, and no locks unless the writer
+    // thread is asleep
+    template <class... Args>
+    void write(LogLevel level, LogSite& site, const char* format, const Args&... args) {
+        int64_t now = nowNs();
+        if (!site.allow(now, rateLimit.load(std::memory_order_relaxed))) return;
+        LogRing& ring = threadRing();
+        uint32_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= (uint32_t)kRingSize) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        LogRecord& r = ring.records[head & (kRingSize - 1)];
+        r.timeNs = now;
+        r.format = format;
+        r.level = (uint8_t)level;
+        r.argCount = 0;
+        r.payloadUsed = 0;
+        r.suppressed = site.suppressed.load(std::memory_order_relaxed) ? site.suppressed.exchange(0, std::memory_order_relaxed) : 0;
+        (r.add(args), ...);
+        ring.head.store(head + 1, std::memory_order_release);
+        logged.fetch_add(1, std::memory_order_seq_cst);
+        // Passing through the mutex orders this against the writer's last
+        // look at the count: it either saw the record or is already waiting
+        if (writerIdle.load(std::memory_order_seq_cst)) {
+            { std::lock_guard<std::mutex> lock(flushMutex); }
+            wake.notify_one();
+        }
+    }
+
+    static int64_t nowNs() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Counters are updated with relaxed atomics and can be read at any time
+    std::atomic<uint64_t> logged{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+
+private:
+    struct LogRing {
+        LogRecord records[kRingSize];
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<bool> abandoned{false};
+    };
+
+    // Marks the ring of an exiting thread, the worker frees it once drained
+    struct RingOwner {
+        LogRing* ring = nullptr;
+        ~RingOwner() {
+            if (ring) ring->abandoned.store(true, std::memory_order_release);
+        }
+    };
+
+    Logger() : startNs(nowNs()) {
+        worker = std::thread([this]() { run(); });
+    }
+
+    LogRing& threadRing() {
+        thread_local RingOwner owner;
+        if (!owner.ring) {
+            std::unique_ptr<LogRing> ring(new LogRing());
+            owner.ring = ring.get();
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::move(ring));
+        }
+        return *owner.ring;
+    }
+
+    void format(const LogRecord& r, std::string& out) {
+        static const char* names[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "[%10.6f] %s ", (r.timeNs - startNs) / 1e9, names[r.level & 3]);
+        out += prefix;
+        size_t offset = 0;
+        int arg = 0;
+        for (const char* p = r.format; *p; p++) {
+            if (p[0] != '{' || p[1] != '}') {
+                out += *p;
+                continue;
+            }
+            p++;
+            if (arg >= r.argCount) {
+                out += "{}";
+                continue;
+            }
+            char number[32];
+            const uint8_t* data = r.payload + offset;
+            switch (r.types[arg++]) {
+            case LOG_ARG_INT: {
+                int64_t v;
+                std::memcpy(&v, data, 8);
+                snprintf(number, sizeof(number), "%lld", (long long)v);
+                out += number;
+                offset += 8;
+                break;
+            }
+            case LOG_ARG_UINT: {
+                uint64_t v;
+                std::memcpy(&v, data, 8);
+                snprintf(number, sizeof(number), "%llu", (unsigned long long)v);
+                out += number;
+                offset += 8;
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double v;
+                std::memcpy(&v, data, 8);
+                snprintf(number, sizeof(number), "%g", v);
+                out += number;
+                offset += 8;
+                break;
+            }
+            case LOG_ARG_BOOL:
+                out += data[0] ? "true" : "false";
+                offset += 1;
+                break;
+            case LOG_ARG_STRING:
+                out.append((const char*)data + 1, data[0]);
+                offset += 1 + data[0];
+                break;
+            }
+        }
+        if (r.suppressed) out += " (" + std::to_string(r.suppressed) + " similar messages suppressed)";
+        out += '\n';
+    }
+
+    void run() {
+        std::vector<LogRecord> batch;
+        std::string text;
+        uint64_t taken = 0; // records moved out of the rings
+        for (;;) {
+            batch.clear();
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                for (size_t i = 0; i < rings.size();) {
+                    LogRing& ring = *rings[i];
+                    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+                    uint32_t head = ring.head.load(std::memory_order_acquire);
+                    for (; tail != head; tail++) batch.push_back(ring.records[tail & (kRingSize - 1)]);
+                    ring.tail.store(tail, std::memory_order_release);
+                    // An exited thread cannot log again, its ring goes once empty
+                    if (ring.abandoned.load(std::memory_order_acquire) && ring.head.load(std::memory_order_acquire) == tail) {
+                        rings.erase(rings.begin() + i);
+                        continue;
+                    }
+                    i++;
+                }
+            }
+            taken += batch.size();
+
+            if (!batch.empty()) {
+                std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) { return a.timeNs < b.timeNs; });
+                text.clear();
+                for (const LogRecord& r : batch) format(r, text);
+                {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    fwrite(text.data(), 1, text.size(), output);
+                    fflush(output);
+                }
+                written.fetch_add(batch.size(), std::memory_order_release);
+                std::lock_guard<std::mutex> lock(flushMutex);
+                flushed.notify_all();
+                continue;
+            }
+            if (!running.load(std::memory_order_relaxed)) break;
+            // Nothing to write: sleep until write() or the destructor wakes
+            // us; both pass through flushMutex, so no wakeup is lost. The
+            // count can trail a record already taken, never lead one.
+            std::unique_lock<std::mutex> lock(flushMutex);
+            writerIdle.store(true, std::memory_order_seq_cst);
+            wake.wait(lock, [&]() {
+                return !running.load(std::memory_order_relaxed) || logged.load(std::memory_order_seq_cst) > taken;
+            });
+            writerIdle.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    int64_t startNs;
+    std::atomic<int> minLevel{LOG_LEVEL_INFO};
+    std::atomic<int> rateLimit{kDefaultRateLimit};
+    FILE* output = stderr;
+    std::mutex outputMutex;
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::atomic<bool> running{true};
+    std::atomic<bool> writerIdle{false};
+    std::mutex flushMutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::thread worker;
+};
+
+#define LOG_AT(level, ...)                                          \
+    do {                                                            \
+        if (Logger::instance().enabled(level)) {                    \
+            static LogSite logSite_;                                \
+            Logger::instance().write(level, logSite_, __VA_ARGS__); \
+        }                                                           \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TetrisCore.hpp"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+// Live engine counters for bot farms and servers, scraped over HTTP in the
+// Prometheus text format (GET /metrics on a localhost port).
+//
+// Metrics are registered once, by name, and the reference kept by the code
+// that updates them; an update is a single relaxed atomic add or store. All
+// formatting happens on the scraping thread. Values that already live in
+// other structures can be exported with a function evaluated at scrape time.
+//
+//     MetricCounter& locks = MetricsRegistry::instance().counter("tetris_pieces_locked_total", "Pieces locked");
+//     locks.add();
+
+enum MetricType {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+struct MetricCounter {
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+struct MetricGauge {
+    std::atomic<int64_t> value{0};
+
+    void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+// Fixed upper bounds chosen at registration. The sum is kept in millionths
+// so it can be an integer atomic.
+struct MetricHistogram {
+    static const int kMaxBuckets = 16;
+
+    double bounds[kMaxBuckets] = {};
+    int boundCount = 0;
+    std::atomic<uint64_t> buckets[kMaxBuckets + 1] = {}; // the last one is +Inf
+    std::atomic<uint64_t> sumMicros{0};
+
+    void observe(double v) {
+        int b = 0;
+        while (b < boundCount && v > bounds[b]) b++;
+        buckets[b].fetch_add(1, std::memory_order_relaxed);
+        sumMicros.fetch_add((uint64_t)(v > 0.0 ? v * 1e6 : 0.0), std::memory_order_relaxed);
+    }
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    // Registering an existing name and label set returns the same metric, so
+    // every thread can look its metrics up by name. labels is the inside of
+    // the braces, e.g. type="double".
+    MetricCounter& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (Entry* e = find(name, labels)) return *e->counter;
+        counters.emplace_back();
+        entries.push_back({ name, help, labels, METRIC_COUNTER, &counters.back(), nullptr, nullptr, nullptr });
+        return counters.back();
+    }
+
+    MetricGauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (Entry* e = find(name, labels)) return *e->gauge;
+        gauges.emplace_back();
+        entries.push_back({ name, help, labels, METRIC_GAUGE, nullptr, &gauges.back(), nullptr, nullptr });
+        return gauges.back();
+    }
+
+    MetricHistogram& histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (Entry* e = find(name, "")) return *e->histogram;
+        histograms.emplace_back();
+        MetricHistogram& h = histograms.back();
+        for (double b : bounds)
+            if (h.boundCount < MetricHistogram::kMaxBuckets) h.bounds[h.boundCount++] = b;
+        entries.push_back({ name, help, "", METRIC_HISTOGRAM, nullptr, nullptr, &h, nullptr });
+        return h;
+    }
+
+    // Counter or gauge read from fn at scrape time (fn runs on the scraping thread)
+    void function(const std::string& name, const std::string& help, MetricType type, std::function<double()> fn,
+                  const std::string& labels = "") {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (find(name, labels)) return;
+        functions.push_back(std::move(fn));
+        entries.push_back({ name, help, labels, type, nullptr, nullptr, nullptr, &functions.back() });
+    }
+
+    // Prometheus text exposition format, version 0.0.4. Samples of one name
+    // are grouped under a single HELP and TYPE line.
+    std::string render() {
+        std::lock_guard<std::mutex> lock(mutex);
+        static const char* typeNames[] = { "counter", "gauge", "histogram" };
+        std::string out;
+        std::vector<bool> done(entries.size(), false);
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (done[i]) continue;
+            const Entry& first = entries[i];
+            out += "# HELP " + first.name + " " + first.help + "\n";
+            out += "# TYPE " + first.name + " " + typeNames[first.type] + "\n";
+            for (size_t j = i; j < entries.size(); j++) {
+                if (done[j] || entries[j].name != first.name) continue;
+                done[j] = true;
+                renderEntry(entries[j], out);
+            }
+        }
+        return out;
+    }
+
+private:
+    struct Entry {
+        std::string name, help, labels;
+        MetricType type;
+        MetricCounter* counter;
+        MetricGauge* gauge;
+        MetricHistogram* histogram;
+        std::function<double()>* fn;
+    };
+
+    MetricsRegistry() {}
+
+    Entry* find(const std::string& name, const std::string& labels) {
+        for (auto& e : entries)
+            if (e.name == name && e.labels == labels) return &e;
+        return nullptr;
+    }
+
+    static void appendSample(std::string& out, const std::string& name, const std::string& labels, const std::string& value) {
+        out += name;
+        if (!labels.empty()) out += "{" + labels + "}";
+        out += " " + value + "\n";
+    }
+
+    static std::string formatDouble(double value) {
+        char number[32];
+        snprintf(number, sizeof(number), "%.9g", value);
+        return number;
+    }
+
+    static void renderEntry(const Entry& e, std::string& out) {
+        if (e.fn) {
+            appendSample(out, e.name, e.labels, formatDouble((*e.fn)()));
+        } else if (e.counter) {
+            appendSample(out, e.name, e.labels, std::to_string(e.counter->value.load(std::memory_order_relaxed)));
+        } else if (e.gauge) {
+            appendSample(out, e.name, e.labels, std::to_string(e.gauge->value.load(std::memory_order_relaxed)));
+        } else {
+            // Buckets are stored per range and exported cumulative; the
+            // count is the +Inf bucket so the two always agree
+            const MetricHistogram& h = *e.histogram;
+            uint64_t seen = 0;
+            for (int b = 0; b <= h.boundCount; b++) {
+                seen += h.buckets[b].load(std::memory_order_relaxed);
+                char le[32];
+                if (b < h.boundCount) snprintf(le, sizeof(le), "le=\"%g\"", h.bounds[b]);
+                else snprintf(le, sizeof(le), "le=\"+Inf\"");
+                appendSample(out, e.name + "_bucket", le, std::to_string(seen));
+            }
+            appendSample(out, e.name + "_sum", "", formatDouble(h.sumMicros.load(std::memory_order_relaxed) / 1e6));
+            appendSample(out, e.name + "_count", "", std::to_string(seen));
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    std::deque<MetricCounter> counters; // deques keep references stable
+    std::deque<MetricGauge> gauges;
+    std::deque<MetricHistogram> histograms;
+    std::deque<std::function<double()>> functions;
+};
+
+// Heap allocations made by the process. Only counted in programs that put
+// METRICS_COUNT_ALLOCATIONS at file scope in one source file.
+inline MetricCounter& allocationCounter()
+{
+    static MetricCounter counter;
+    return counter;
+}
+
+struct MetricsAllocationHook {
+    MetricsAllocationHook() {
+        MetricsRegistry::instance().function("process_heap_allocations_total", "Calls to operator new", METRIC_COUNTER,
+                                             []() { return (double)allocationCounter().value.load(std::memory_order_relaxed); });
+    }
+};
+
+// Out of line so GCC does not pair the inlined free() with the library's
+// operator new and warn about a mismatch
+#if defined(__GNUC__)
+#define METRICS_NOINLINE __attribute__((noinline))
+#else
+#define METRICS_NOINLINE
+#endif
+
+#define METRICS_COUNT_ALLOCATIONS                                                         \
+    METRICS_NOINLINE void* operator new(std::size_t size) {                               \
+        allocationCounter().add();                                                        \
+        if (void* p = std::malloc(size ? size : 1)) return p;                             \
+        throw std::bad_alloc();                                                           \
+    }                                                                                     \
+    METRICS_NOINLINE void operator delete(void* p) noexcept { std::free(p); }             \
+    METRICS_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); } \
+    static MetricsAllocationHook metricsAllocationHook_;
+
+// Counters shared by everything that runs games. record() takes the status
+// after one step; counters are atomic, so several threads can share one set.
+struct GameMetrics {
+    MetricCounter& ticks;
+    MetricCounter& piecesLocked;
+    MetricCounter* lineClears[4]; // single, double, triple, tetris
+    MetricCounter& frozenTriggers;
+    MetricCounter& electricalTriggers;
+    MetricCounter& fireTriggers;
+    MetricCounter& cascadeSteps;
+    MetricCounter& gamesOver;
+
+    explicit GameMetrics(MetricsRegistry& r = MetricsRegistry::instance())
+        : ticks(r.counter("tetris_ticks_total", "Fixed game ticks simulated")),
+          piecesLocked(r.counter("tetris_pieces_locked_total", "Pieces locked")),
+          frozenTriggers(r.counter("tetris_special_triggers_total", "Special piece effects", "piece=\"frozen\"")),
+          electricalTriggers(r.counter("tetris_special_triggers_total", "Special piece effects", "piece=\"electrical\"")),
+          fireTriggers(r.counter("tetris_special_triggers_total", "Special piece effects", "piece=\"fire\"")),
+          cascadeSteps(r.counter("tetris_cascade_steps_total", "Cascade gravity chain steps")),
+          gamesOver(r.counter("tetris_games_over_total", "Games that ended")) {
+        static const char* names[] = { "single", "double", "triple", "tetris" };
+        for (int i = 0; i < 4; i++)
+            lineClears[i] = &r.counter("tetris_line_clears_total", "Line clears by number of rows",
+                                       std::string("type=\"") + names[i] + "\"");
+    }
+
+    void record(const GameStatus& status) {
+        ticks.add((uint64_t)status.ticks);
+        int lines = 0;
+        bool fire = false;
+        for (int i = 0; i < status.eventCount; i++) {
+            switch (status.events[i].type) {
+            case EVENT_LOCK: piecesLocked.add(); break;
+            case EVENT_LINE: lines++; break;
+            case EVENT_FROZEN: frozenTriggers.add(); break;
+            case EVENT_ELECTRICAL: electricalTriggers.add(); break;
+            case EVENT_FIRE: fire = true; break;
+            case EVENT_CASCADE: cascadeSteps.add(); break;
+            case EVENT_GAME_OVER: gamesOver.add(); break;
+            default: break;
+            }
+        }
+        // One fire piece burns several cells, it counts once
+        if (fire) fireTriggers.add();
+        if (lines > 0) lineClears[std::min(lines, 4) - 1]->add();
+    }
+};
+
+// Rendering side, for the programs that draw
+struct FrameMetrics {
+    MetricHistogram& frameSeconds;
+    MetricGauge& particles;
+
+    explicit FrameMetrics(MetricsRegistry& r = MetricsRegistry::instance())
+        : frameSeconds(r.histogram("tetris_frame_seconds", "Frame time without the frame limiter sleep",
+                                   { 0.001, 0.002, 0.004, 0.008, 0.0167, 0.033, 0.066, 0.133 })),
+          particles(r.gauge("tetris_particles", "Live particle effects")) {}
+};
+
+#ifndef _WIN32
+// Tiny HTTP listener on 127.0.0.1 answering GET /metrics with the registry.
+// One connection at a time on its own thread, which is plenty for a scraper.
+class MetricsServer {
+public:
+    explicit MetricsServer(MetricsRegistry& registry = MetricsRegistry::instance()) : registry(registry) {}
+    ~MetricsServer() { stop(); }
+
+    // Port 0 picks a free one, see port()
+    bool start(int port) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) return false;
+        int yes = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 8) < 0 ||
+            getsockname(listenFd, (sockaddr*)&addr, &length) < 0) {
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        boundPort = ntohs(addr.sin_port);
+        running = true;
+        thread = std::thread([this]() { run(); });
+        return true;
+    }
+
+    void stop() {
+        running = false;
+        if (thread.joinable()) thread.join();
+        if (listenFd >= 0) close(listenFd);
+        listenFd = -1;
+    }
+
+    int port() const { return boundPort; }
+
+    std::atomic<uint64_t> scrapes{0};
+
+private:
+    void run() {
+        while (running) {
+            pollfd p = { listenFd, POLLIN, 0 };
+            if (poll(&p, 1, 200) <= 0) continue;
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+            serve(fd);
+            close(fd);
+        }
+    }
+
+    void serve(int fd) {
+        // A slow or silent client must not hold the listener for long
+        timeval timeout = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) return;
+            request.append(buffer, (size_t)n);
+        }
+        std::string status, body, type = "text/plain; version=0.0.4; charset=utf-8";
+        if (request.compare(0, 13, "GET /metrics ") == 0) {
+            status = "200 OK";
+            body = registry.render();
+            scrapes.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            status = "404 Not Found";
+            body = "try /metrics\n";
+            type = "text/plain";
+        }
+        std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + type +
+                               "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            sent += (size_t)n;
+        }
+    }
+
+    MetricsRegistry& registry;
+    int listenFd = -1;
+    int boundPort = 0;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chipmunk/chipmunk.h>
+#include <chipmunk/chipmunk_unsafe.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Refers to an entity of a PhysicsEntityStore. The generation changes every
+// time a slot is reused, so a handle to a destroyed entity stays invalid
+// instead of silently pointing at whatever was created in its place.
+struct EntityHandle {
+    uint32_t slot = ~0u;
+    uint32_t generation = 0;
+};
+
+// Physics-backed circles kept as parallel arrays (structure of arrays):
+// bodies, shapes, radii, colors and the positions cached from the last sync.
+// Live entities are packed at the front, so sync() is one linear pass over
+// the bodies and draw() fills one vertex array and issues one draw call.
+//
+// Destroying swaps the last entity into the hole; handles go through a slot
+// table, so they survive the move. A destroyed entity's body and shape are
+// only taken out of the space and kept for the next create(), which sets
+// their mass, moment and radius again, like DebrisField's pool. Nothing is
+// allocated per frame, and with reserve() nothing on create/destroy either.
+//
+// The store detaches and frees its bodies, so it must be destroyed before
+// the space.
+class PhysicsEntityStore {
+public:
+    static const int kCircleSegments = 12; // triangles per circle
+
+    explicit PhysicsEntityStore(cpSpace* space) : space(space) {
+        for (int i = 0; i < kCircleSegments; i++) {
+            float angle = 2.0f * 3.14159265f * i / kCircleSegments;
+            circle[i] = sf::Vector2f(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    ~PhysicsEntityStore() {
+        for (size_t i = 0; i < bodies.size(); i++) release(i);
+        for (cpShape* shape : spare) {
+            cpBody* body = cpShapeGetBody(shape);
+            cpShapeFree(shape);
+            cpBodyFree(body);
+        }
+    }
+
+    PhysicsEntityStore(const PhysicsEntityStore&) = delete;
+    PhysicsEntityStore& operator=(const PhysicsEntityStore&) = delete;
+
+    // Room for count live entities, Chipmunk bodies and shapes included
+    void reserve(size_t count) {
+        spare.reserve(count);
+        while (bodies.size() + spare.size() < count) {
+            cpShape* shape = cpCircleShapeNew(cpBodyNew(1.0, 1.0), 1.0, cpvzero);
+            cpShapeSetFriction(shape, 0.7);
+            spare.push_back(shape);
+        }
+        bodies.reserve(count);
+        shapes.reserve(count);
+        radii.reserve(count);
+        colors.reserve(count);
+        positions.reserve(count);
+        denseSlot.reserve(count);
+        slotDense.reserve(count);
+        slotGeneration.reserve(count);
+        freeSlots.reserve(count);
+        vertices.reserve(count * kCircleSegments * 3);
+    }
+
+    EntityHandle create(float radius, float mass, const cpVect& position, const sf::Color& color) {
+        const cpFloat moment = cpMomentForCircle(mass, 0, radius, cpvzero);
+        cpBody* body;
+        cpShape* shape;
+        if (!spare.empty()) {
+            shape = spare.back();
+            spare.pop_back();
+            body = cpShapeGetBody(shape);
+            cpBodySetMass(body, mass);
+            cpBodySetMoment(body, moment);
+            cpBodySetVelocity(body, cpvzero);
+            cpBodySetAngle(body, 0.0);
+            cpBodySetAngularVelocity(body, 0.0);
+            cpBodySetForce(body, cpvzero);
+            cpBodySetTorque(body, 0.0);
+            cpCircleShapeSetRadius(shape, radius);
+        } else {
+            body = cpBodyNew(mass, moment);
+            shape = cpCircleShapeNew(body, radius, cpvzero);
+            cpShapeSetFriction(shape, 0.7);
+        }
+        cpBodySetPosition(body, position);
+        cpSpaceAddBody(space, body);
+        cpSpaceAddShape(space, shape);
+
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)slotDense.size();
+            slotDense.push_back(0);
+            slotGeneration.push_back(1);
+        }
+        slotDense[slot] = (uint32_t)bodies.size();
+        bodies.push_back(body);
+        shapes.push_back(shape);
+        radii.push_back(radius);
+        colors.push_back(color);
+        positions.emplace_back((float)position.x, (float)position.y);
+        denseSlot.push_back(slot);
+        return { slot, slotGeneration[slot] };
+    }
+
+    // False for a handle that is stale or was never valid
+    bool destroy(EntityHandle handle) {
+        if (!alive(handle)) return false;
+        uint32_t index = slotDense[handle.slot];
+        release(index);
+        uint32_t last = (uint32_t)bodies.size() - 1;
+        if (index != last) {
+            bodies[index] = bodies[last];
+            shapes[index] = shapes[last];
+            radii[index] = radii[last];
+            colors[index] = colors[last];
+            positions[index] = positions[last];
+            denseSlot[index] = denseSlot[last];
+            slotDense[denseSlot[index]] = index;
+        }
+        bodies.pop_back();
+        shapes.pop_back();
+        radii.pop_back();
+        colors.pop_back();
+        positions.pop_back();
+        denseSlot.pop_back();
+        slotGeneration[handle.slot]++;
+        freeSlots.push_back(handle.slot);
+        return true;
+    }
+
+    bool alive(EntityHandle handle) const {
+        return handle.slot < slotGeneration.size() && slotGeneration[handle.slot] == handle.generation;
+    }
+
+    // nullptr for a stale handle
+    cpBody* body(EntityHandle handle) {
+        return alive(handle) ? bodies[slotDense[handle.slot]] : nullptr;
+    }
+
+    void setColor(EntityHandle handle, const sf::Color& color) {
+        if (alive(handle)) colors[slotDense[handle.slot]] = color;
+    }
+
+    // Position as of the last sync(); (0, 0) for a stale handle
+    sf::Vector2f position(EntityHandle handle) const {
+        return alive(handle) ? positions[slotDense[handle.slot]] : sf::Vector2f();
+    }
+
+    // Copies every body position out of Chipmunk; call once after each step
+    void sync() {
+        const size_t count = bodies.size();
+        for (size_t i = 0; i < count; i++) {
+            cpVect p = cpBodyGetPosition(bodies[i]);
+            positions[i] = sf::Vector2f((float)p.x, (float)p.y);
+        }
+    }
+
+    // Triangles for every entity at its synced position
+    const std::vector<sf::Vertex>& buildVertices() {
+        vertices.resize(bodies.size() * kCircleSegments * 3);
+        sf::Vertex* v = vertices.data();
+        const size_t count = bodies.size();
+        for (size_t i = 0; i < count; i++) {
+            const sf::Vector2f center = positions[i];
+            const float r = radii[i];
+            const sf::Color color = colors[i];
+            for (int s = 0; s < kCircleSegments; s++) {
+                const sf::Vector2f& a = circle[s];
+                const sf::Vector2f& b = circle[(s + 1) % kCircleSegments];
+                v[0] = sf::Vertex(center, color);
+                v[1] = sf::Vertex(center + a * r, color);
+                v[2] = sf::Vertex(center + b * r, color);
+                v += 3;
+            }
+        }
+        return vertices;
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (bodies.empty()) return;
+        buildVertices();
+        target.draw(vertices.data(), vertices.size(), sf::Triangles);
+    }
+
+    size_t count() const { return bodies.size(); }
+    // Bodies made so far, live or kept for reuse
+    size_t capacity() const { return bodies.size() + spare.size(); }
+
+private:
+    // Takes an entity out of the space, keeping its body and shape for reuse
+    void release(size_t index) {
+        cpSpaceRemoveShape(space, shapes[index]);
+        cpSpaceRemoveBody(space, bodies[index]);
+        spare.push_back(shapes[index]);
+    }
+
+    cpSpace* space;
+
+    // Dense arrays, one element per live entity
+    std::vector<cpBody*> bodies;
+    std::vector<cpShape*> shapes;
+    std::vector<float> radii;
+    std::vector<sf::Color> colors;
+    std::vector<sf::Vector2f> positions;
+    std::vector<uint32_t> denseSlot; // slot that refers to each entity
+    std::vector<cpShape*> spare;     // out of the space, each still bound to its body
+
+    // Slot table behind the handles
+    std::vector<uint32_t> slotDense;
+    std::vector<uint32_t> slotGeneration;
+    std::vector<uint32_t> freeSlots;
+
+    sf::Vector2f circle[kCircleSegments];
+    std::vector<sf::Vertex> vertices;
+};
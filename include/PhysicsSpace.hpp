@@ -1,14 +1,77 @@
+#pragma once
+
+#include <chipmunk/chipmunk.h>
+#include <chipmunk/cpHastySpace.h>
+
+// How the space finds shapes that may touch before the exact collision test
+enum Broadphase {
+    BROADPHASE_BBTREE,       // Chipmunk's default, adapts to any mix of shape sizes
+    BROADPHASE_SPATIAL_HASH  // faster when all shapes are about the same size
+};
+
+struct PhysicsSettings {
+    Broadphase broadphase = BROADPHASE_BBTREE;
+    cpFloat hashCellSize = 40.0; // about the size of a typical shape
+    int hashCells = 1000;        // table size, roughly ten times the number of shapes
+    int iterations = 10;         // solver iterations per step
+    int substeps = 1;            // each step() is split in this many smaller steps
+    int threads = 0;             // 0 = plain solver, N = cpHastySpace solving on N threads
+};
 
 class PhysicsSpace {
 public:
-    PhysicsSpace() {
-        space = cpSpaceNew();
+    PhysicsSpace() : PhysicsSpace(PhysicsSettings()) {}
+
+    PhysicsSpace(const PhysicsSettings& settings) : settings(settings) {
+        if (settings.threads > 0) {
+            space = cpHastySpaceNew();
+            cpHastySpaceSetThreads(space, (unsigned long)settings.threads);
+        } else {
+            space = cpSpaceNew();
+        }
         cpVect gravity = cpv(0, 1000);
         cpSpaceSetGravity(space, gravity);
+        cpSpaceSetIterations(space, settings.iterations);
+        if (settings.broadphase == BROADPHASE_SPATIAL_HASH)
+            cpSpaceUseSpatialHash(space, settings.hashCellSize, settings.hashCells);
     }
 
     ~PhysicsSpace() {
-        cpSpaceFree(space);
+        if (settings.threads > 0) cpHastySpaceFree(space);
+        else cpSpaceFree(space);
+    }
+
+    PhysicsSpace(const PhysicsSpace&) = delete;
+    PhysicsSpace& operator=(const PhysicsSpace&) = delete;
+
+    // Advances the simulation by dt, in settings.substeps equal steps
+    void step(cpFloat dt) {
+        int substeps = settings.substeps > 1 ? settings.substeps : 1;
+        cpFloat h = dt / substeps;
+        for (int i = 0; i < substeps; i++) {
+            if (settings.threads > 0) cpHastySpaceStep(space, h);
+            else cpSpaceStep(space, h);
+        }
+    }
+
+    // Contact points between touching shapes after the last step, each pair
+    // counted once
+    int contactCount() {
+        int count = 0;
+        cpSpaceEachBody(space, [](cpBody* body, void* data) {
+            if (cpBodyGetType(body) == CP_BODY_TYPE_STATIC) return;
+            cpBodyEachArbiter(body, [](cpBody* body, cpArbiter* arbiter, void* data) {
+                cpBody *a, *b;
+                cpArbiterGetBodies(arbiter, &a, &b);
+                cpBody* other = a == body ? b : a;
+                if (cpBodyGetType(other) == CP_BODY_TYPE_STATIC || body < other) *(int*)data += cpArbiterGetCount(arbiter);
+            }, data);
+        }, &count);
+        return count;
+    }
+
+    const PhysicsSettings& getSettings() const {
+        return settings;
     }
 
     cpSpace* getSpace() {
@@ -16,5 +79,6 @@ public:
     }
 
 private:
+    PhysicsSettings settings;
     cpSpace* space;
 };
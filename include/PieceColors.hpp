@@ -0,0 +1,11 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include "PiecePalette.hpp"
+
+// Block color for a cell value: 0 is empty, then piece type + 1, then garbage
+inline sf::Color pieceColor(int value)
+{
+    uint32_t rgb = pieceRgb(value);
+    return sf::Color((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+}
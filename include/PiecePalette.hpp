@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include "TetrisCore.hpp"
+
+// Block color for a cell value as 0xRRGGBB: 0 is empty, then piece type + 1
+// in the colors of the piece set in play, then garbage. Kept free of SFML
+// so headless renderers share it.
+inline uint32_t pieceRgb(int value)
+{
+    if (value == 0) return 0x000000;
+    if (value == kGarbageCell) return 0x6E6E6E;
+    return pieceTable.colors[value - 1];
+}
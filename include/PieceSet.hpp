@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "TetrisCore.hpp"
+
+// Piece sets as text, compiled into a PieceTable when they are loaded so
+// the game runs them through the same masks as the built-in tetrominoes.
+// Lines starting with // are comments. Each piece is a line
+//
+//   piece <name> [color RRGGBB] [weight n] [effect frozen|electrical|fire|ghost]
+//
+// followed by the rows of its box, which is square and up to kPieceBox
+// wide: '.' for empty, anything else for a block. The piece turns about
+// the center of its box. Pieces with an effect are the special ones, drawn
+// every third piece when the rules have specials; weights (default 1, 0
+// for never) set how often each piece of its group comes up.
+// assets/pieces/tetromino.txt is the built-in set written this way.
+
+// "none", "frozen", "electrical", "fire" or "ghost"; false for anything else
+inline bool parsePieceEffect(const std::string& name, PieceEffect& effect)
+{
+    if (name == "none") effect = EFFECT_NONE;
+    else if (name == "frozen") effect = EFFECT_FROZEN;
+    else if (name == "electrical") effect = EFFECT_ELECTRICAL;
+    else if (name == "fire") effect = EFFECT_FIRE;
+    else if (name == "ghost") effect = EFFECT_GHOST;
+    else return false;
+    return true;
+}
+
+inline bool parsePieceSet(std::istream& in, PieceTable& table, std::string& error)
+{
+    table = PieceTable();
+    struct Definition {
+        std::string name;
+        uint32_t color = 0;
+        uint32_t weight = 1;
+        PieceEffect effect = EFFECT_NONE;
+        std::vector<std::string> rows;
+        int line = 0;
+    };
+    std::vector<Definition> pieces;
+
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line.compare(0, 2, "//") == 0) continue;
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if (word != "piece") {
+            if (pieces.empty()) {
+                error = "line " + std::to_string(number) + ": rows before the first piece";
+                return false;
+            }
+            pieces.back().rows.push_back(line);
+            continue;
+        }
+
+        Definition piece;
+        piece.line = number;
+        piece.color = kTetrominoColors[pieces.size() % kPieceTypes];
+        if (!(words >> piece.name) || piece.name.size() >= sizeof(table.names[0])) {
+            error = "line " + std::to_string(number) + ": expected a name of up to 15 characters";
+            return false;
+        }
+        for (const Definition& other : pieces) {
+            if (other.name == piece.name) {
+                error = "line " + std::to_string(number) + ": " + piece.name + " defined twice";
+                return false;
+            }
+        }
+        std::string value;
+        while (words >> word) {
+            bool ok = (bool)(words >> value);
+            char* end = nullptr;
+            if (ok && word == "color") {
+                piece.color = (uint32_t)strtoul(value.c_str(), &end, 16);
+                ok = value.size() == 6 && *end == 0;
+            } else if (ok && word == "weight") {
+                piece.weight = (uint32_t)strtoul(value.c_str(), &end, 10);
+                ok = !value.empty() && *end == 0 && piece.weight <= 1000000;
+            } else if (ok && word == "effect") {
+                ok = parsePieceEffect(value, piece.effect);
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                error = "line " + std::to_string(number) + ": bad option " + word + " " + value;
+                return false;
+            }
+        }
+        pieces.push_back(piece);
+    }
+
+    if (pieces.empty() || pieces.size() > (size_t)kMaxPieceTypes) {
+        error = "a set has 1 to " + std::to_string(kMaxPieceTypes) + " pieces";
+        return false;
+    }
+    for (const Definition& piece : pieces) {
+        const std::string where = "line " + std::to_string(piece.line) + ": " + piece.name + ": ";
+        const int n = (int)piece.rows.size();
+        if (n == 0 || n > kPieceBox) {
+            error = where + "the box has 1 to " + std::to_string(kPieceBox) + " rows";
+            return false;
+        }
+        std::string box;
+        for (const std::string& row : piece.rows) {
+            if ((int)row.size() != n) {
+                error = where + "the box must be square";
+                return false;
+            }
+            box += row;
+        }
+        if (box.find_first_not_of('.') == std::string::npos) {
+            error = where + "no blocks";
+            return false;
+        }
+        addPiece(table, box.c_str(), n, piece.name.c_str(), piece.color, piece.effect, piece.weight);
+        // A block must come within kBoardPad columns of the box's left edge,
+        // or the wall padding is too narrow for the fit test next to it
+        for (int r = 0; r < 4; r++) {
+            if (table.shapes[table.count - 1][r].left >= kBoardPad) {
+                error = where + "the blocks cannot all lie on one edge of the box";
+                return false;
+            }
+        }
+    }
+    if (table.normal.count == 0) {
+        error = "no piece without an effect can spawn";
+        return false;
+    }
+    return true;
+}
+
+inline bool loadPieceSet(const std::string& path, PieceTable& table, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    return parsePieceSet(file, table, error);
+}
+
+// Both tables hold the same pieces with the same masks, effects, colors,
+// names and spawn pools
+inline bool samePieceTables(const PieceTable& a, const PieceTable& b)
+{
+    if (a.count != b.count || a.normal.count != b.normal.count || a.special.count != b.special.count) return false;
+    for (int t = 0; t < a.count; t++) {
+        if (a.effects[t] != b.effects[t] || a.colors[t] != b.colors[t] || a.cells[t] != b.cells[t] ||
+            strcmp(a.names[t], b.names[t]) != 0 || std::memcmp(a.shapes[t], b.shapes[t], sizeof(a.shapes[t])) != 0)
+            return false;
+    }
+    for (int i = 0; i < a.normal.count; i++)
+        if (a.normal.types[i] != b.normal.types[i] || a.normal.totals[i] != b.normal.totals[i]) return false;
+    for (int i = 0; i < a.special.count; i++)
+        if (a.special.types[i] != b.special.types[i] || a.special.totals[i] != b.special.totals[i]) return false;
+    return true;
+}
@@ -0,0 +1,793 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TetrisCore.hpp"
+
+// Solver for training puzzles: given a board and the pieces that will come,
+// finds placements that reach a perfect clear (an empty field) or a number
+// of cleared lines. Depth-first search over the row bitmasks of the game:
+//
+// - Placements are every resting position the piece can reach from its
+//   spawn point with the game's own moves (slide, rotate without kicks,
+//   soft drop), so tucks under overhangs count. They are generated a row at
+//   a time as bitmasks of columns for all four rotations at once.
+// - Branches that cannot reach the goal are cut: a perfect clear needs
+//   enough cells to fill every non-empty row and a cell count that is a
+//   multiple of the width, and on even widths the difference between cells
+//   in even and odd columns must be one the coming pieces can cancel (a full
+//   row has as many of each). These counts follow from a placement without
+//   playing it, so hopeless placements are never applied. For a line
+//   target, the emptiest cells of the fullest rows must fit in the coming
+//   pieces.
+// - A perfect clear also has to fill the empty cells of the rows it clears
+//   column group by column group: two neighbouring columns can only ever
+//   share a piece if some of those rows has both cells empty, so each group
+//   needs whole pieces narrow enough for it. Pockets no piece can fill end
+//   the branch there.
+// - For a perfect clear, placements are tried leaving the fewest covered
+//   cells and filling the fullest rows first.
+// - Boards already searched without success with the same pieces to come
+//   are remembered and skipped, in a table shared by all threads. It holds
+//   64-bit hashes, so a collision could in theory hide a solution, and
+//   entries are overwritten when it fills up.
+// - The first placements are shared out between threads.
+//
+// Special pieces follow the game's rules (electrical ones wipe the two rows
+// they land on, fire ones burn the cells around them, with cascades if
+// enabled). Pieces come from the piece set in play.
+
+// A piece of the sequence locked at x, y in that rotation
+struct PuzzlePlacement {
+    int type;
+    int rotation;
+    int x;
+    int y;
+};
+
+enum PuzzleGoal {
+    GOAL_PERFECT_CLEAR,
+    GOAL_LINES
+};
+
+struct PuzzleResult {
+    std::vector<std::vector<PuzzlePlacement>> solutions;
+    uint64_t nodes = 0;    // placements tried
+    uint64_t memoHits = 0; // boards skipped as already searched
+    uint64_t pruned = 0;   // boards that could no longer reach the goal
+    double seconds = 0.0;
+    bool timedOut = false;
+};
+
+template <class Game>
+class PuzzleSolver {
+public:
+    typedef typename Game::Row Row;
+
+    PuzzleGoal goal = GOAL_PERFECT_CLEAR;
+    int targetLines = 4;    // for GOAL_LINES
+    int maxSolutions = 1;   // stops once this many are found
+    int threads = 0;        // 0 uses every core
+    double timeLimit = 0.0; // seconds, 0 for no limit
+    bool cascade = false;   // as GameCore::cascade
+
+    // Searches from the game's current board; its falling piece is ignored,
+    // pieces[0] is the first to place
+    PuzzleResult solve(const Game& game, const std::vector<int>& sequence) {
+        PuzzleResult result;
+        auto start = std::chrono::steady_clock::now();
+        init(game, sequence, start);
+
+        State root;
+        const Row* rows = game.board.rowData();
+        for (int y = 0; y < h + 2 * kBoardPad; y++) root.rows[y] = rows[y];
+        root.lines = 0;
+
+        std::vector<PuzzlePlacement> first;
+        if (!pieces.empty()) {
+            generate(root, pieces[0], first);
+            std::stable_sort(first.begin(), first.end(),
+                             [&](const PuzzlePlacement& a, const PuzzlePlacement& b) { return rank(root, a) < rank(root, b); });
+        }
+        failed.reset(kFailedSlots);
+        std::atomic<size_t> nextBranch{0};
+        std::mutex found;
+        int threadCount = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::max(1, std::min(threadCount, (int)first.size()));
+        std::vector<Worker> workers(threadCount, Worker(game, (int)pieces.size()));
+
+        auto run = [&](Worker& worker) {
+            for (size_t b; !stop.load(std::memory_order_relaxed) && (b = nextBranch.fetch_add(1)) < first.size();) {
+                State next = root;
+                apply(worker, next, first[b]);
+                worker.nodes++;
+                worker.path[0] = first[b];
+                search(worker, next, 1, false, found, result);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threadCount; t++) pool.emplace_back(run, std::ref(workers[t]));
+        if (!workers.empty()) run(workers[0]);
+        for (auto& t : pool) t.join();
+
+        for (const Worker& worker : workers) {
+            result.nodes += worker.nodes;
+            result.memoHits += worker.memoHits;
+            result.pruned += worker.pruned;
+        }
+        result.timedOut = timedOut.load();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    // Plays a solution on the game through its own lock code (place() from
+    // the solver's position), so the result can be checked against the real
+    // rules. False when a piece does not rest where the solver put it.
+    static bool replay(Game& game, const std::vector<PuzzlePlacement>& moves) {
+        for (const PuzzlePlacement& m : moves) {
+            game.status.gameOver = false;
+            game.status.piece = { m.type, m.rotation, m.x, m.y };
+            if (game.ghostY() != m.y || !game.place(m.rotation, m.x)) return false;
+        }
+        return true;
+    }
+
+private:
+    struct State {
+        Row rows[kMaxBoardHeight + 2 * kBoardPad]; // with the walls, as in the board
+        int lines;
+    };
+
+    // Hashes of boards known to fail, shared by the threads: open
+    // addressing over a fixed table, 0 marking an empty slot. When every
+    // slot a key may go to is taken, the first is overwritten, so entries
+    // can be lost but never made up.
+    struct FailedBoards {
+        static const int kProbes = 8;
+        std::vector<std::atomic<uint64_t>> slots;
+
+        void reset(size_t size) {
+            if (slots.size() != size) std::vector<std::atomic<uint64_t>>(size).swap(slots);
+            for (std::atomic<uint64_t>& slot : slots) slot.store(0, std::memory_order_relaxed);
+        }
+
+        bool contains(uint64_t key) const {
+            for (int i = 0; i < kProbes; i++) {
+                uint64_t v = slots[(key + i) & (slots.size() - 1)].load(std::memory_order_relaxed);
+                if (v == key) return true;
+                if (v == 0) return false;
+            }
+            return false;
+        }
+
+        void insert(uint64_t key) {
+            for (int i = 0; i < kProbes; i++) {
+                std::atomic<uint64_t>& slot = slots[(key + i) & (slots.size() - 1)];
+                uint64_t v = 0;
+                if (slot.compare_exchange_strong(v, key, std::memory_order_relaxed) || v == key) return;
+            }
+            slots[key & (slots.size() - 1)].store(key, std::memory_order_relaxed);
+        }
+    };
+
+    struct Worker {
+        Worker(const Game& game, int pieces) : scratch(game), path(pieces), moves(pieces + 1), order(pieces + 1) {}
+
+        Game scratch; // runs cascades
+        std::vector<PuzzlePlacement> path;
+        std::vector<std::vector<PuzzlePlacement>> moves; // per depth, reused
+        std::vector<std::vector<uint64_t>> order;        // per depth: rank, then index into moves
+        uint64_t nodes = 0;
+        uint64_t memoHits = 0;
+        uint64_t pruned = 0;
+    };
+
+    void init(const Game& game, const std::vector<int>& pieceList, std::chrono::steady_clock::time_point start) {
+        w = game.board.width();
+        h = game.board.height();
+        field = game.board.fieldMask();
+        full = game.board.fullRow();
+        empty = game.board.emptyRow();
+        evenColumns = 0;
+        for (int x = 0; x < w; x += 2) evenColumns |= (Row)1 << (x + kBoardPad);
+        specials = game.rules.specials();
+        pieces = pieceList;
+        startTime = start;
+        stop = false;
+        timedOut = false;
+        solutionCount = 0;
+
+        // Blocks of every rotation, and where pieces can go on an empty field
+        Row emptyRows[kMaxBoardHeight + 2 * kBoardPad];
+        for (int y = 0; y < h + 2 * kBoardPad; y++) emptyRows[y] = y < kBoardPad || y >= h + kBoardPad ? full : empty;
+        for (int t = 0; t < pieceTable.count; t++) {
+            Row valid[4][kMaxBoardHeight + 1];
+            Row reach[4][kMaxBoardHeight] = {};
+            joined[t] = true;
+            for (int k = 0; k <= kPieceBox; k++) narrowest[t][k] = kPieceBox + 1;
+            for (int r = 0; r < 4; r++) {
+                Shape& shape = shapes[t][r];
+                const PieceShape& blocks = pieceShape(t, r);
+                for (int k = blocks.bottom - blocks.top + 1; k <= kPieceBox; k++)
+                    narrowest[t][k] = std::min(narrowest[t][k], blocks.right - blocks.left + 1);
+                for (int px = blocks.left; px < blocks.right; px++) {
+                    bool pair = false;
+                    for (int py = blocks.top; py <= blocks.bottom; py++) pair |= ((blocks.rows[py] >> px) & 3) == 3;
+                    joined[t] = joined[t] && pair;
+                }
+                shape.count = 0;
+                shape.parity = 0;
+                shape.top = shape.left = kPieceBox - 1;
+                shape.bottom = 0;
+                for (int py = 0; py < kPieceBox; py++) {
+                    for (int px = 0; px < kPieceBox; px++) {
+                        if (!pieceHasBlock(t, r, px, py)) continue;
+                        shape.px[shape.count] = (int8_t)px;
+                        shape.py[shape.count++] = (int8_t)py;
+                        shape.parity += px % 2 == 0 ? 1 : -1;
+                        shape.top = std::min(shape.top, py);
+                        shape.bottom = py;
+                        shape.left = std::min(shape.left, px);
+                    }
+                }
+                shape.canonical = r;
+                for (int other = 0; other < r && shape.canonical == r; other++)
+                    if (sameShape(t, other, r)) shape.canonical = shapes[t][other].canonical;
+                Row v = (Row)~Row(0);
+                for (int b = 0; b < shape.count; b++) v &= (Row)(~emptyRows[kBoardPad + shape.py[b]] >> shape.px[b]);
+                valid[r][0] = v;
+            }
+            const Row spawn = (Row)1 << (w / 2 - 2 + kBoardPad);
+            if (valid[0][0] & spawn) {
+                reach[0][0] = spawn;
+                close(reach, valid, 0);
+            }
+            for (int r = 0; r < 4; r++) emptyReach[t][r] = reach[r][0];
+        }
+
+        // For every depth d and count m, the changes of the even minus odd
+        // column difference pieces d..d+m-1 can add up to, and their cells
+        const int n = (int)pieces.size();
+        cellsBefore.assign(n + 1, 0);
+        for (int i = 0; i < n; i++) cellsBefore[i + 1] = cellsBefore[i] + shapes[pieces[i]][0].count;
+        firstRemover.assign(n + 1, n);
+        for (int i = n - 1; i >= 0; i--)
+            firstRemover[i] = specials && removesCells(pieces[i]) ? i : firstRemover[i + 1];
+        remainingHash.assign(n + 1, 0x9E3779B97F4A7C15ull);
+        for (int i = n - 1; i >= 0; i--) remainingHash[i] = (remainingHash[i + 1] ^ (uint64_t)(pieces[i] + 1)) * 0xBF58476D1CE4E5B9ull;
+        paritySums.assign((size_t)(n + 1) * (n + 1), ParitySet());
+        for (int d = 0; d <= n; d++) {
+            ParitySet sums;
+            sums.set(kParityOffset);
+            paritySums[(size_t)d * (n + 1)] = sums;
+            for (int m = 1; d + m <= n; m++) {
+                ParitySet next;
+                for (int r = 0; r < 4; r++) {
+                    int shift = std::abs(shapes[pieces[d + m - 1]][r].parity);
+                    next |= (sums << shift) | (sums >> shift);
+                }
+                sums = next;
+                paritySums[(size_t)d * (n + 1) + m] = sums;
+            }
+        }
+    }
+
+    // checked: the caller already knows the goal is still reachable
+    bool search(Worker& wk, const State& s, int depth, bool checked, std::mutex& found, PuzzleResult& result) {
+        if (reached(s)) {
+            std::lock_guard<std::mutex> lock(found);
+            if (solutionCount < maxSolutions) {
+                result.solutions.emplace_back(wk.path.begin(), wk.path.begin() + depth);
+                if (++solutionCount >= maxSolutions) stop = true;
+            }
+            return true;
+        }
+        if (depth == (int)pieces.size() || stop.load(std::memory_order_relaxed)) return false;
+        if (!checked && hopeless(s, depth)) {
+            wk.pruned++;
+            return false;
+        }
+        uint64_t key = hash(s, depth);
+        if (failed.contains(key)) {
+            wk.memoHits++;
+            return false;
+        }
+
+        std::vector<PuzzlePlacement>& moves = wk.moves[depth];
+        const int type = pieces[depth];
+        generate(s, type, moves);
+
+        // For a perfect clear whether the goal is still reachable follows
+        // from the placement alone (a cleared row takes away as many cells
+        // as it needs and no empty ones), so hopeless placements are dropped
+        // without being played, and the rest are tried best first except for
+        // the last piece, where every placement ends the search anyway.
+        const bool last = depth + 1 == (int)pieces.size();
+        const bool screen = goal == GOAL_PERFECT_CLEAR && depth < firstRemover[depth] && !last;
+        const bool ranked = goal == GOAL_PERFECT_CLEAR && !last;
+        FieldCounts counts;
+        if (screen) counts = count(s);
+        std::vector<uint64_t>& order = wk.order[depth];
+        order.clear();
+        const uint64_t nodesBefore = wk.nodes;
+        for (size_t i = 0; i < moves.size(); i++) {
+            wk.nodes++;
+            if (screen && !canPlace(s, counts, moves[i], depth)) {
+                wk.pruned++;
+                continue;
+            }
+            order.push_back((uint64_t)(ranked ? rank(s, moves[i]) : 0) << 32 | i);
+        }
+        if (ranked) std::sort(order.begin(), order.end());
+        if (timeLimit > 0.0 && (nodesBefore >> 10) != (wk.nodes >> 10) &&
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() > timeLimit) {
+            timedOut = true;
+            stop = true;
+        }
+
+        bool solved = false;
+        for (uint64_t o : order) {
+            if (stop.load(std::memory_order_relaxed)) break;
+            const PuzzlePlacement& m = moves[(uint32_t)o];
+            State next = s;
+            apply(wk, next, m);
+            wk.path[depth] = m;
+            if (search(wk, next, depth + 1, screen, found, result)) solved = true;
+        }
+        // A search cut short proves nothing about this board
+        if (!solved && !stop.load(std::memory_order_relaxed)) failed.insert(key);
+        return solved;
+    }
+
+    bool reached(const State& s) const {
+        if (goal == GOAL_LINES) return s.lines >= targetLines;
+        const Row* rows = s.rows + kBoardPad;
+        for (int y = 0; y < h; y++)
+            if (rows[y] & field) return false;
+        return true;
+    }
+
+    // True when no way of placing the remaining pieces can reach the goal
+    bool hopeless(const State& s, int depth) const {
+        if (goal == GOAL_LINES) {
+            const Row* rows = s.rows + kBoardPad;
+            // Cells never move between rows without cascades, so each line
+            // still to clear is a row plus the cells missing from it
+            if (cascade) return false;
+            int need = targetLines - s.lines;
+            int rowsMissing[65] = {}; // rows by empty cells
+            for (int y = 0; y < h; y++) rowsMissing[w - bitCount(rows[y] & field)]++;
+            int missing = 0;
+            for (int m = 0; m <= w && need > 0; m++) {
+                int take = std::min(need, rowsMissing[m]);
+                missing += take * m;
+                need -= take;
+            }
+            return need > 0 || missing > cellsBefore[pieces.size()] - cellsBefore[depth];
+        }
+
+        return !canClear(count(s), depth, s.rows + kBoardPad);
+    }
+
+    struct FieldCounts {
+        int filled = 0;   // cells
+        int nonEmpty = 0; // rows with a cell
+        int parity = 0;   // cells in even columns minus cells in odd ones
+        int top = 0;      // highest row with a cell, the height if none
+    };
+
+    FieldCounts count(const State& s) const {
+        FieldCounts c;
+        c.top = h;
+        const Row* rows = s.rows + kBoardPad;
+        for (int y = h - 1; y >= 0; y--) {
+            Row r = rows[y] & field;
+            if (!r) continue;
+            c.top = y;
+            c.nonEmpty++;
+            c.filled += bitCount(r);
+            c.parity += bitCount(r & evenColumns) - bitCount(r & ~evenColumns);
+        }
+        return c;
+    }
+
+    // The screen for one placement: the counts after it, then canClear()
+    bool canPlace(const State& s, const FieldCounts& counts, const PuzzlePlacement& m, int depth) const {
+        const Row* rows = s.rows + kBoardPad;
+        const Shape& shape = shapes[m.type][m.rotation];
+        FieldCounts after = counts;
+        after.filled += shape.count;
+        after.parity += (m.x & 1) ? -shape.parity : shape.parity;
+        after.top = std::min(after.top, m.y + shape.top);
+        const PieceShape& blocks = pieceShape(m.type, m.rotation);
+        for (int py = blocks.top; py <= blocks.bottom; py++)
+            if (blocks.rows[py] && !(rows[m.y + py] & field)) after.nonEmpty++;
+        return canClear(after, depth + 1, rows, &m);
+    }
+
+    // Whether the next m pieces, for some m, can leave the field empty:
+    // every row with a cell takes a full row of cells to clear, the cells
+    // must add up to whole rows, and on even widths the pieces must cancel
+    // the column difference (a full row has as many even as odd cells).
+    // With the board at hand (rows, plus a placement not played yet) the
+    // column groups are checked too. Pieces that remove cells make anything
+    // possible.
+    bool canClear(const FieldCounts& c, int depth, const Row* rows = nullptr, const PuzzlePlacement* placed = nullptr) const {
+        const int n = (int)pieces.size();
+        const int bit = kParityOffset - c.parity;
+        for (int m = 0; depth + m <= n; m++) {
+            if (depth + m > firstRemover[depth]) return true;
+            int total = c.filled + cellsBefore[depth + m] - cellsBefore[depth];
+            if (total % w != 0 || total < w * c.nonEmpty) continue;
+            if (w % 2 == 0 && (bit < 0 || bit >= kParityRange || !paritySums[(size_t)depth * (n + 1) + m][bit])) continue;
+            if (rows && c.nonEmpty == h - c.top && !fillable(rows, placed, depth, m, total / w)) continue;
+            return true;
+        }
+        return false;
+    }
+
+    // Whether the next m pieces can fill the empty cells of the bottom k
+    // rows, for a perfect clear of k rows with an unbroken stack: a piece
+    // above them would leave more rows to clear than there are cells for.
+    // Those rows only fill up or go away whole, so columns x and x + 1 can
+    // only ever share a piece if one of the rows has both cells empty now.
+    // Each group of columns between such boundaries takes whole pieces, no
+    // wider than the group nor taller than k: a pocket of dead cells no
+    // piece fits ends here. A piece with a gap between its columns could
+    // straddle two groups, so with one of those to come nothing is checked.
+    bool fillable(const Row* rows, const PuzzlePlacement* placed, int depth, int m, int k) const {
+        Row region[kMaxBoardHeight];
+        for (int y = h - k; y < h; y++) region[y] = rows[y];
+        if (placed) {
+            const PieceShape& shape = pieceShape(placed->type, placed->rotation);
+            for (int py = shape.top; py <= shape.bottom; py++) region[placed->y + py] |= (Row)shape.rows[py] << (placed->x + kBoardPad);
+        }
+        Row open = 0; // bit x + kBoardPad: columns x and x + 1 can share a piece
+        for (int y = h - k; y < h; y++) {
+            Row empty = ~region[y] & field;
+            open |= empty & (empty >> 1);
+        }
+        int unit = 0;                   // every group's cells are a multiple of this
+        int narrow[kPieceBox + 1] = {}; // cells of the pieces at most this wide
+        for (int i = depth; i < depth + m; i++) {
+            if (!joined[pieces[i]]) return true;
+            const int cells = shapes[pieces[i]][0].count;
+            const int width = narrowest[pieces[i]][std::min(k, kPieceBox)];
+            if (width > kPieceBox) return false;
+            unit = std::gcd(unit, cells);
+            narrow[width] += cells;
+        }
+        for (int width = 1; width <= kPieceBox; width++) narrow[width] += narrow[width - 1];
+
+        for (int x = 0; x < w; x++) {
+            const int start = x;
+            while (x + 1 < w && ((open >> (x + kBoardPad)) & 1)) x++;
+            const Row group = (Row)(((Row)2 << x) - ((Row)1 << start)) << kBoardPad;
+            int cells = 0;
+            for (int y = h - k; y < h; y++) cells += bitCount(~region[y] & group);
+            if (cells == 0) continue;
+            if (unit == 0 || cells % unit != 0 || cells > narrow[std::min(x - start + 1, kPieceBox)]) return false;
+        }
+        return true;
+    }
+
+    // Order of the placements to try, lowest first: fewest empty cells left
+    // right under the piece, then the ones that fill the fullest rows
+    uint32_t rank(const State& s, const PuzzlePlacement& m) const {
+        const Row* rows = s.rows + kBoardPad;
+        const PieceShape& shape = pieceShape(m.type, m.rotation);
+        const int shift = m.x + kBoardPad;
+        int covered = 0, fill = 0;
+        for (int py = shape.top; py <= shape.bottom; py++) {
+            const Row piece = (Row)shape.rows[py] << shift;
+            const Row below = py < shape.bottom ? (Row)shape.rows[py + 1] << shift : 0;
+            covered += bitCount(piece & ~below & ~rows[m.y + py + 1]);
+            fill += bitCount((rows[m.y + py] | piece) & field);
+        }
+        return (uint32_t)((covered + 1) * kPieceBox * 64 - fill);
+    }
+
+    // The board with the pieces still to come (and lines still to clear)
+    uint64_t hash(const State& s, int depth) const {
+        uint64_t v = remainingHash[depth];
+        if (goal == GOAL_LINES) v ^= (uint64_t)(targetLines - s.lines) << 40;
+        const Row* rows = s.rows + kBoardPad;
+        for (int y = 0; y < h; y++) {
+            v ^= (uint64_t)(rows[y] & field) + 0x9E3779B97F4A7C15ull + (v << 6) + (v >> 2);
+            v *= 0xBF58476D1CE4E5B9ull;
+        }
+        v ^= v >> 31;
+        return v ? v : 1;
+    }
+
+    // Every resting position of the piece reachable from its spawn point,
+    // lowest first. reach[r][y] holds the box positions (bit x + kBoardPad)
+    // the piece can be moved to; moves never go up, so one pass down the
+    // rows, closing each one under sliding and rotating, finds them all.
+    // Above the stack every row is the same, so the pass starts from the
+    // closure on an empty field on the last row the box clears the stack.
+    void generate(const State& s, int type, std::vector<PuzzlePlacement>& out) const {
+        out.clear();
+        const Row* rows = s.rows + kBoardPad;
+        int top = 0;
+        while (top < h && !(rows[top] & field)) top++;
+        const int first = std::max(0, top - kPieceBox);
+
+        Row valid[4][kMaxBoardHeight + 1];
+        Row reach[4][kMaxBoardHeight];
+        for (int r = 0; r < 4; r++) {
+            const Shape& shape = shapes[type][r];
+            for (int y = first; y <= h; y++) {
+                // Past the floor row nothing fits (and the rows run out)
+                Row v = y + shape.bottom <= h ? (Row)~Row(0) : 0;
+                for (int b = 0; b < shape.count && v; b++) v &= (Row)(~rows[y + shape.py[b]] >> shape.px[b]);
+                valid[r][y] = v;
+            }
+            reach[r][first] = top >= kPieceBox ? emptyReach[type][r] : 0;
+        }
+        if (top < kPieceBox) {
+            const Row spawn = (Row)1 << (w / 2 - 2 + kBoardPad);
+            if (!(valid[0][0] & spawn)) return; // topped out
+            reach[0][0] = spawn;
+        }
+
+        int bottom = first;
+        for (int y = first; y < h; y++) {
+            if (y > first) {
+                Row any = 0;
+                for (int r = 0; r < 4; r++) any |= reach[r][y] = reach[r][y - 1] & valid[r][y];
+                if (!any) break;
+            }
+            bottom = y;
+            close(reach, valid, y);
+        }
+
+        // Rotations with the same cells give the same board, except for the
+        // specials whose effect depends on where the box is
+        const bool boxMatters = specials && removesCells(type);
+        Row seen[4][kMaxBoardHeight + kPieceBox] = {}; // by canonical rotation and top row, bit of the left column
+        for (int y = bottom; y >= first; y--) {
+            for (int r = 0; r < 4; r++) {
+                const Shape& shape = shapes[type][r];
+                for (Row land = reach[r][y] & ~valid[r][y + 1]; land; land &= land - 1) {
+                    int bit = lowestBit(land);
+                    if (!boxMatters) {
+                        Row& cellsSeen = seen[shape.canonical][y + shape.top];
+                        Row key = (Row)1 << (bit + shape.left);
+                        if (cellsSeen & key) continue;
+                        cellsSeen |= key;
+                    }
+                    out.push_back({ type, r, bit - kBoardPad, y });
+                }
+            }
+        }
+    }
+
+    // Slides and rotates the positions on row y until nothing new is reached
+    static void close(Row reach[4][kMaxBoardHeight], const Row valid[4][kMaxBoardHeight + 1], int y) {
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (int r = 0; r < 4; r++) reach[r][y] = slide(reach[r][y], valid[r][y]);
+            for (int r = 0; r < 4; r++) {
+                int nr = (r + 1) & 3;
+                Row add = reach[r][y] & valid[nr][y] & ~reach[nr][y];
+                if (add) {
+                    reach[nr][y] |= add;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    static Row slide(Row seed, Row mask) {
+        for (;;) {
+            Row next = (seed | (Row)(seed << 1) | (Row)(seed >> 1)) & mask;
+            if (next == seed) return seed;
+            seed = next;
+        }
+    }
+
+    // TetrisGame::lock on the row masks only
+    void apply(Worker& wk, State& s, const PuzzlePlacement& p) const {
+        Row* rows = s.rows + kBoardPad;
+        const PieceShape& shape = pieceShape(p.type, p.rotation);
+        for (int py = shape.top; py <= shape.bottom; py++) rows[p.y + py] |= (Row)shape.rows[py] << (p.x + kBoardPad);
+
+        bool specialCleared = false;
+        if (specials && pieceEffect(p.type) == EFFECT_ELECTRICAL) {
+            for (int y = p.y; y >= p.y - 1; y--) {
+                if (y >= 0 && y < h) {
+                    rows[y] = empty;
+                    specialCleared = true;
+                }
+            }
+        } else if (specials && pieceEffect(p.type) == EFFECT_FIRE) {
+            Row burn = 0;
+            for (int x = std::max(0, p.x - 2); x <= std::min(w - 1, p.x + 2); x++) burn |= (Row)1 << (x + kBoardPad);
+            for (int y = std::max(0, p.y - 2); y <= std::min(h - 1, p.y + 2); y++) {
+                if (rows[y] & burn) specialCleared = true;
+                rows[y] &= ~burn;
+            }
+        }
+
+        for (int py = shape.top; py <= shape.bottom; py++) {
+            int y = p.y + py;
+            if (y >= 0 && y < h && rows[y] == full) {
+                for (int r = y; r > 0; r--) rows[r] = rows[r - 1];
+                rows[0] = empty;
+                s.lines++;
+            }
+        }
+
+        if (cascade && specialCleared) {
+            Row* board = wk.scratch.board.rowData();
+            for (int y = 0; y < h + 2 * kBoardPad; y++) board[y] = s.rows[y];
+            wk.scratch.boardChanged();
+            wk.scratch.status.linesCleared = 0;
+            wk.scratch.status.eventCount = 0;
+            wk.scratch.runCascade();
+            for (int y = 0; y < h + 2 * kBoardPad; y++) s.rows[y] = board[y];
+            s.lines += wk.scratch.status.linesCleared;
+        }
+    }
+
+    int w = 10;
+    int h = 20;
+    Row field = 0;
+    Row full = 0;
+    Row empty = 0;
+    bool specials = false;
+    std::vector<int> pieces;
+    // Blocks of a piece in one rotation. Rotations with the same cells
+    // share a canonical one; top and left are the first row and column used.
+    struct Shape {
+        int8_t px[kPieceBox * kPieceBox];
+        int8_t py[kPieceBox * kPieceBox];
+        int count;
+        int parity; // cells in even columns minus odd ones, box on an even column
+        int canonical;
+        int top;
+        int bottom;
+        int left;
+    };
+
+    static bool removesCells(int type) {
+        return pieceEffect(type) == EFFECT_ELECTRICAL || pieceEffect(type) == EFFECT_FIRE;
+    }
+
+    // Rotations a and b of the piece have the same cells, moved
+    bool sameShape(int type, int a, int b) const {
+        const Shape& sa = shapes[type][a];
+        const Shape& sb = shapes[type][b];
+        if (sa.count != sb.count) return false;
+        for (int i = 0; i < sa.count; i++) {
+            // Both lists are in row then column order
+            if (sa.px[i] - sa.left != sb.px[i] - sb.left || sa.py[i] - sa.top != sb.py[i] - sb.top) return false;
+        }
+        return true;
+    }
+
+    Shape shapes[kMaxPieceTypes][4];
+    int narrowest[kMaxPieceTypes][kPieceBox + 1] = {}; // columns of the narrowest rotation at most k rows tall
+    bool joined[kMaxPieceTypes] = {};                  // neighbouring columns always share a row of the piece
+    Row emptyReach[kMaxPieceTypes][4] = {}; // box positions on the top row of an empty field
+    static const int kParityRange = 512; // column differences of -256..255
+    static const int kParityOffset = 256;
+    typedef std::bitset<kParityRange> ParitySet;
+    std::vector<int> cellsBefore;       // cells of the first i pieces
+    std::vector<int> firstRemover;      // first electrical or fire piece from i on
+    std::vector<ParitySet> paritySums;  // [d * (n + 1) + m]
+    std::vector<uint64_t> remainingHash; // of pieces i..n - 1
+    static const size_t kFailedSlots = size_t(1) << 19;
+    FailedBoards failed;
+    Row evenColumns = 0;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> timedOut{false};
+    int solutionCount = 0;
+};
+
+// A puzzle as text. Lines starting with // are comments, "pieces" lists
+// the sequence (names of the piece set in play, separated by spaces or,
+// when every name is one letter, run together: IOTLJ or "I O Fire"),
+// "lines <n>" asks for n cleared lines instead of a perfect clear, and the
+// remaining lines are the bottom rows of the board, '.' for an empty cell
+// and anything else for a block.
+struct Puzzle {
+    std::vector<std::string> rows; // top to bottom
+    std::vector<int> pieces;
+    int lines = 0;                 // 0 for a perfect clear
+};
+
+// Piece type of a name, ignoring case when nothing matches exactly; -1 if unknown
+inline int puzzlePieceType(const std::string& name)
+{
+    for (int t = 0; t < pieceTable.count; t++)
+        if (name == pieceName(t)) return t;
+    for (int t = 0; t < pieceTable.count; t++) {
+        const char* other = pieceName(t);
+        if (name.size() != strlen(other)) continue;
+        bool same = true;
+        for (size_t i = 0; i < name.size(); i++) same &= tolower((unsigned char)name[i]) == tolower((unsigned char)other[i]);
+        if (same) return t;
+    }
+    return -1;
+}
+
+inline std::string puzzlePieceName(int type)
+{
+    return pieceName(type);
+}
+
+inline bool parsePuzzle(std::istream& in, Puzzle& puzzle, std::string& error)
+{
+    puzzle = Puzzle();
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line.compare(0, 2, "//") == 0) continue;
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if (word == "pieces") {
+            while (words >> word) {
+                int type = puzzlePieceType(word);
+                if (type >= 0) {
+                    puzzle.pieces.push_back(type);
+                    continue;
+                }
+                for (char c : word) {
+                    type = puzzlePieceType(std::string(1, c));
+                    if (type < 0) {
+                        error = "line " + std::to_string(number) + ": unknown piece " + word;
+                        return false;
+                    }
+                    puzzle.pieces.push_back(type);
+                }
+            }
+        } else if (word == "lines") {
+            if (!(words >> puzzle.lines) || puzzle.lines <= 0) {
+                error = "line " + std::to_string(number) + ": expected a line count";
+                return false;
+            }
+        } else {
+            if (!puzzle.rows.empty() && line.size() != puzzle.rows[0].size()) {
+                error = "line " + std::to_string(number) + ": rows of different widths";
+                return false;
+            }
+            puzzle.rows.push_back(line);
+        }
+    }
+    if (puzzle.pieces.empty()) {
+        error = "no pieces";
+        return false;
+    }
+    return true;
+}
+
+// Puts the puzzle's rows at the bottom of the board, garbage for blocks.
+// False when they do not fit.
+template <class Game>
+bool loadPuzzle(Game& game, const Puzzle& puzzle)
+{
+    const int w = game.width(), h = game.height();
+    if ((int)puzzle.rows.size() > h || (!puzzle.rows.empty() && (int)puzzle.rows[0].size() != w)) return false;
+    game.reset(1);
+    const int top = h - (int)puzzle.rows.size();
+    for (int y = 0; y < (int)puzzle.rows.size(); y++)
+        for (int x = 0; x < w; x++)
+            if (puzzle.rows[y][x] != '.') game.setCell(x, top + y, kGarbageCell);
+    return true;
+}
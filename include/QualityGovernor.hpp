@@ -0,0 +1,107 @@
+#pragma once
+
+// Frame-budget governor.
+//
+// Fed with the time spent producing each frame (update + draw, without the
+// frame limiter sleep). When the recent average eats most of the budget the
+// quality level drops one stage; it only comes back after a longer stretch of
+// clear headroom, and every change is followed by a cooldown so the level
+// does not flicker between two stages.
+
+struct QualitySettings {
+    float particleFraction; // share of particles spawned per effect
+    int starCount;          // stars in the background
+    bool gridLines;         // grid lines over the field
+    float effectLife;       // multiplier on effect lifetime
+};
+
+class QualityGovernor {
+public:
+    static const int kLevels = 4;
+    static const int kWindow = 30; // frames averaged
+
+    explicit QualityGovernor(float budgetSeconds = 1.0f / 60.0f)
+        : budget(budgetSeconds) {
+        for (int i = 0; i < kWindow; i++) frames[i] = 0.0f;
+    }
+
+    // Returns true when the level changed
+    bool addFrame(float seconds) {
+        total += seconds - frames[next];
+        frames[next] = seconds;
+        next = (next + 1) % kWindow;
+        if (count < kWindow) count++;
+        if (cooldown > 0) cooldown--;
+
+        float average = averageFrame();
+        if (average > budget * kStepDownAt) {
+            overBudget++;
+            underBudget = 0;
+        } else if (average < budget * kStepUpAt) {
+            underBudget++;
+            overBudget = 0;
+        } else {
+            overBudget = 0;
+            underBudget = 0;
+        }
+
+        if (count < kWindow || cooldown > 0) return false;
+
+        if (overBudget >= kStepDownFrames && current < kLevels - 1) {
+            current++;
+        } else if (underBudget >= kStepUpFrames && current > 0) {
+            current--;
+        } else {
+            return false;
+        }
+        overBudget = 0;
+        underBudget = 0;
+        cooldown = kCooldownFrames;
+        return true;
+    }
+
+    int level() const {
+        return current;
+    }
+
+    // Force a level, e.g. from a debug key
+    void setLevel(int level) {
+        current = level < 0 ? 0 : (level >= kLevels ? kLevels - 1 : level);
+        cooldown = kCooldownFrames;
+    }
+
+    const QualitySettings& settings() const {
+        static const QualitySettings levels[kLevels] = {
+            { 1.0f, 50, true, 1.0f },   // full
+            { 0.5f, 50, true, 0.75f },  // fewer particles
+            { 0.25f, 20, false, 0.5f }, // simplified starfield, no grid
+            { 0.1f, 0, false, 0.35f },  // bare minimum
+        };
+        return levels[current];
+    }
+
+    float averageFrame() const {
+        return count ? total / count : 0.0f;
+    }
+
+    float frameBudget() const {
+        return budget;
+    }
+
+private:
+    static constexpr float kStepDownAt = 0.8f; // of the budget
+    static constexpr float kStepUpAt = 0.4f;
+    static const int kStepDownFrames = 10;
+    static const int kStepUpFrames = 120;
+    static const int kCooldownFrames = 60;
+
+    float budget;
+    float frames[kWindow];
+    float total = 0.0f;
+    int next = 0;
+    int count = 0;
+    int current = 0;
+    int overBudget = 0;
+    int underBudget = 0;
+    int cooldown = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A recorded game: the seed plus the buttons held on every 60 Hz step. The
+// rules are deterministic, so playing the inputs back with the same seed and
+// step reproduces the game exactly.
+struct Replay {
+    static constexpr float kStepTime = 1.0f / 60.0f;
+
+    uint32_t seed = 1;
+    std::vector<uint8_t> inputs;
+
+    bool save(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+        uint32_t count = (uint32_t)inputs.size();
+        file.write("TRPL", 4);
+        file.write((const char*)&seed, sizeof(seed));
+        file.write((const char*)&count, sizeof(count));
+        file.write((const char*)inputs.data(), count);
+        return (bool)file;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[4];
+        uint32_t count = 0;
+        if (!file.read(magic, 4) || std::memcmp(magic, "TRPL", 4) != 0) return false;
+        if (!file.read((char*)&seed, sizeof(seed)) || !file.read((char*)&count, sizeof(count))) return false;
+        inputs.resize(count);
+        return (bool)file.read((char*)inputs.data(), count);
+    }
+};
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Persistent high scores and per-game history.
+//
+// <path> is an append-only log of fixed 64-byte records in a memory-mapped
+// file; each record carries a magic number and a checksum, so a record torn
+// by a crash or a kill is recognised on the next open and the log ends just
+// before it. <path>.idx is a compact index of (score, record number) pairs
+// sorted best first, covering the first N records of the log. Records after
+// those live in a small in-memory tail until the worker merges them into a
+// new index, written beside the old one and renamed over it.
+//
+// add() only queues the record. A worker thread copies queued records into
+// the mapping, syncs the file at most once a second and compacts the index,
+// so nothing on the caller's thread waits for the disk.
+//
+// POSIX only (mmap); on Windows open() fails and nothing is stored.
+
+enum ScoreFlag {
+    SCORE_BOT = 1 // played by a bot, not a person
+};
+
+struct ScoreRecord {
+    uint32_t magic = 0;
+    uint32_t checksum = 0; // FNV-1a over the fields below
+    uint64_t time = 0;     // unix seconds at game over
+    int32_t score = 0;
+    int32_t lines = 0;
+    int32_t level = 0;
+    uint32_t durationMs = 0;
+    uint32_t pieces = 0;
+    uint32_t flags = 0;
+    char mode[24] = {}; // game variant name
+
+    void setMode(const char* name) {
+        std::memset(mode, 0, sizeof(mode));
+        std::strncpy(mode, name, sizeof(mode) - 1);
+    }
+
+    uint32_t computeChecksum() const {
+        const uint8_t* p = (const uint8_t*)&time;
+        const uint8_t* end = (const uint8_t*)this + sizeof(*this);
+        uint32_t h = 2166136261u;
+        for (; p < end; p++) h = (h ^ *p) * 16777619u;
+        return h;
+    }
+};
+static_assert(sizeof(ScoreRecord) == 64, "records are fixed 64-byte slots");
+
+class ScoreStore {
+public:
+    static constexpr uint32_t kRecordMagic = 0x52435354; // "TSCR"
+    static constexpr size_t kHeaderSize = 64;            // log header, one record slot
+    static constexpr size_t kMinCapacity = 1 << 20;      // first mapping, then doubled
+    static constexpr size_t kMaxGrowth = 256u << 20;     // largest single growth step
+    static constexpr size_t kCompactThreshold = 1 << 16; // tail records before the index is rebuilt
+
+    ScoreStore() {}
+    ~ScoreStore() { close(); }
+
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    bool open(const std::string& path) {
+#ifdef _WIN32
+        (void)path;
+        return false;
+#else
+        close();
+        logPath = path;
+        indexPath = path + ".idx";
+        fd = ::open(logPath.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0) return fail();
+        size_t size = (size_t)st.st_size;
+        if (size < kHeaderSize) {
+            char header[kHeaderSize] = "TSCORE1";
+            uint32_t recordSize = sizeof(ScoreRecord);
+            std::memcpy(header + 8, &recordSize, 4);
+            if (pwrite(fd, header, kHeaderSize, 0) != (ssize_t)kHeaderSize) return fail();
+            size = kHeaderSize;
+        }
+        if (!mapLog(std::max(size, kMinCapacity))) return fail();
+        uint32_t recordSize = 0;
+        std::memcpy(&recordSize, map + 8, 4);
+        if (std::memcmp(map, "TSCORE1", 8) != 0 || recordSize != sizeof(ScoreRecord)) return fail();
+
+        // Records the index covers were synced before it was written; only
+        // the ones after it need their checksums verified
+        loadIndex();
+        uint64_t slots = (capacity - kHeaderSize) / sizeof(ScoreRecord);
+        if (indexCovered > slots) unmapIndex();
+        recordCount = indexCovered;
+        while (recordCount < slots) {
+            ScoreRecord* r = recordAt(recordCount);
+            if (r->magic != kRecordMagic || r->checksum != r->computeChecksum()) {
+                // A torn write: clear it so it cannot be mistaken for data later
+                static const ScoreRecord zero;
+                if (std::memcmp(r, &zero, sizeof(zero)) != 0) {
+                    *r = ScoreRecord();
+                    recovered++;
+                }
+                break;
+            }
+            tail.push_back({ r->score, (uint32_t)recordCount });
+            recordCount++;
+        }
+
+        stopping = false;
+        worker = std::thread([this]() { run(); });
+        return true;
+#endif
+    }
+
+    // Writes everything queued, syncs, folds the tail into the index and
+    // unmaps the files
+    void close() {
+#ifndef _WIN32
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+        unmapIndex();
+        if (map) munmap(map, capacity);
+        map = nullptr;
+        capacity = 0;
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        tail.clear();
+        recordCount = 0;
+#endif
+    }
+
+    bool isOpen() const { return map != nullptr; }
+
+    // Any thread. The record is written by the worker shortly after.
+    void add(const ScoreRecord& record) {
+        if (!isOpen()) return;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            pending.push_back(record);
+        }
+        queued.fetch_add(1, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+
+    // Waits until every record added so far is in the mapping
+    void flush() {
+        while (isOpen() && written.load() < queued.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Best n games, highest score first (ties: the earlier game first)
+    std::vector<ScoreRecord> top(int n) {
+        std::vector<ScoreRecord> result;
+        if (n <= 0) return result;
+        std::lock_guard<std::mutex> lock(dataMutex);
+        std::vector<ScoreIndexEntry> best(indexEntries, indexEntries + std::min<uint64_t>(indexCount, n));
+        size_t fromTail = std::min(tail.size(), (size_t)n);
+        std::vector<ScoreIndexEntry> tailBest(fromTail);
+        std::partial_sort_copy(tail.begin(), tail.end(), tailBest.begin(), tailBest.end(), better);
+        best.insert(best.end(), tailBest.begin(), tailBest.end());
+        std::sort(best.begin(), best.end(), better);
+        for (const auto& e : best) result.push_back(*recordAt(e.record));
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex);
+            result.insert(result.end(), pending.begin(), pending.end());
+        }
+        std::stable_sort(result.begin(), result.end(), [](const ScoreRecord& a, const ScoreRecord& b) { return a.score > b.score; });
+        if (result.size() > (size_t)n) result.resize(n);
+        return result;
+    }
+
+    // Last n games, newest first
+    std::vector<ScoreRecord> recent(int n) {
+        std::vector<ScoreRecord> result;
+        std::lock_guard<std::mutex> lock(dataMutex);
+        {
+            std::lock_guard<std::mutex> queueLock(queueMutex);
+            for (auto it = pending.rbegin(); it != pending.rend() && (int)result.size() < n; ++it) result.push_back(*it);
+        }
+        for (uint64_t i = recordCount; i > 0 && (int)result.size() < n; i--) result.push_back(*recordAt(i - 1));
+        return result;
+    }
+
+    // 1 + the number of stored games that scored more
+    uint64_t rank(int32_t score) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        // The index is sorted best first: binary search for the first entry
+        // not above score
+        uint64_t lo = 0, hi = indexCount;
+        while (lo < hi) {
+            uint64_t mid = (lo + hi) / 2;
+            if (indexEntries[mid].score > score) lo = mid + 1;
+            else hi = mid;
+        }
+        uint64_t above = lo;
+        for (const auto& e : tail)
+            if (e.score > score) above++;
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        for (const auto& r : pending)
+            if (r.score > score) above++;
+        return above + 1;
+    }
+
+    // Stored games, including the ones still queued
+    uint64_t count() {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+        return recordCount + pending.size();
+    }
+
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> syncs{0};
+    std::atomic<uint64_t> compactions{0};
+    uint64_t recovered = 0; // torn records found by open()
+
+private:
+    struct ScoreIndexEntry {
+        int32_t score;
+        uint32_t record;
+    };
+
+    struct IndexHeader {
+        char magic[8];
+        uint64_t covered; // log records [0, covered) are in the index
+        uint64_t entries;
+        uint64_t reserved;
+    };
+
+    static bool better(const ScoreIndexEntry& a, const ScoreIndexEntry& b) {
+        return a.score != b.score ? a.score > b.score : a.record < b.record;
+    }
+
+    ScoreRecord* recordAt(uint64_t i) const { return (ScoreRecord*)(map + kHeaderSize + i * sizeof(ScoreRecord)); }
+
+#ifndef _WIN32
+    bool fail() {
+        unmapIndex();
+        if (map) munmap(map, capacity);
+        map = nullptr;
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Grows the file (never shrinks it) and maps all of it. On failure the
+    // old mapping stays valid.
+    bool mapLog(size_t size) {
+        struct stat st;
+        if (fstat(fd, &st) < 0) return false;
+        if ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) < 0) return false;
+        size = std::max(size, (size_t)st.st_size);
+        void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) return false;
+        if (map) munmap(map, capacity);
+        map = (uint8_t*)m;
+        capacity = size;
+        return true;
+    }
+
+    void loadIndex() {
+        int indexFd = ::open(indexPath.c_str(), O_RDONLY);
+        if (indexFd < 0) return;
+        struct stat st;
+        IndexHeader header;
+        if (fstat(indexFd, &st) == 0 && (size_t)st.st_size >= sizeof(header) &&
+            pread(indexFd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && std::memcmp(header.magic, "TSINDEX", 8) == 0 &&
+            (size_t)st.st_size == sizeof(header) + header.entries * sizeof(ScoreIndexEntry) && header.entries == header.covered) {
+            void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, indexFd, 0);
+            if (m != MAP_FAILED) {
+                indexMap = (uint8_t*)m;
+                indexMapSize = (size_t)st.st_size;
+                indexEntries = (const ScoreIndexEntry*)(indexMap + sizeof(header));
+                indexCount = header.entries;
+                indexCovered = header.covered;
+            }
+        }
+        ::close(indexFd);
+    }
+
+    void unmapIndex() {
+        if (indexMap) munmap(indexMap, indexMapSize);
+        indexMap = nullptr;
+        indexMapSize = 0;
+        indexEntries = nullptr;
+        indexCount = indexCovered = 0;
+    }
+
+    void syncLog() {
+        msync(map, kHeaderSize + recordCount * sizeof(ScoreRecord), MS_SYNC);
+        syncs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Merges the sorted index with the tail into <path>.idx.tmp and renames
+    // it over the index. The log is synced first, so an index never covers
+    // records that could still be lost.
+    void compact() {
+        syncLog();
+        std::vector<ScoreIndexEntry> sortedTail = tail; // only this thread changes the tail
+        std::sort(sortedTail.begin(), sortedTail.end(), better);
+        uint64_t covered = recordCount;
+
+        std::string tmpPath = indexPath + ".tmp";
+        FILE* out = fopen(tmpPath.c_str(), "wb");
+        if (!out) return;
+        IndexHeader header = {};
+        std::memcpy(header.magic, "TSINDEX", 8);
+        header.covered = covered;
+        header.entries = indexCount + sortedTail.size();
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        std::vector<ScoreIndexEntry> chunk;
+        chunk.reserve(4096);
+        uint64_t i = 0;
+        size_t j = 0;
+        while (ok && (i < indexCount || j < sortedTail.size())) {
+            if (j == sortedTail.size() || (i < indexCount && better(indexEntries[i], sortedTail[j]))) chunk.push_back(indexEntries[i++]);
+            else chunk.push_back(sortedTail[j++]);
+            if (chunk.size() == chunk.capacity()) {
+                ok = fwrite(chunk.data(), sizeof(ScoreIndexEntry), chunk.size(), out) == chunk.size();
+                chunk.clear();
+            }
+        }
+        if (ok && !chunk.empty()) ok = fwrite(chunk.data(), sizeof(ScoreIndexEntry), chunk.size(), out) == chunk.size();
+        ok = fflush(out) == 0 && ok;
+        ok = ok && fsync(fileno(out)) == 0;
+        fclose(out);
+        if (!ok || rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+            remove(tmpPath.c_str());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(dataMutex);
+        unmapIndex();
+        loadIndex();
+        if (indexCovered == covered) tail.clear();
+        else tail.erase(tail.begin(), tail.begin() + (size_t)(covered - indexCovered)); // load failed, keep serving from the tail
+        compactions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        std::vector<ScoreRecord> batch;
+        auto lastSync = std::chrono::steady_clock::now();
+        bool dirty = false;
+        for (;;) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait_for(lock, std::chrono::milliseconds(200), [this]() { return stopping || !pending.empty(); });
+                stop = stopping && pending.empty();
+            }
+            {
+                // Taken in the same order as the queries, so a query never
+                // sees a record in neither place
+                std::lock_guard<std::mutex> lock(dataMutex);
+                {
+                    std::lock_guard<std::mutex> queueLock(queueMutex);
+                    batch.swap(pending);
+                }
+                size_t needed = kHeaderSize + (recordCount + batch.size()) * sizeof(ScoreRecord);
+                if (needed > capacity) {
+                    size_t grown = capacity + std::min(capacity, kMaxGrowth);
+                    if (!mapLog(std::max(grown, needed))) {
+                        // Out of disk or address space: count the records as handled and lose them
+                        written.fetch_add(batch.size(), std::memory_order_relaxed);
+                        batch.clear();
+                    }
+                }
+                for (ScoreRecord r : batch) {
+                    r.magic = kRecordMagic;
+                    r.checksum = r.computeChecksum();
+                    std::memcpy(recordAt(recordCount), &r, sizeof(r));
+                    tail.push_back({ r.score, (uint32_t)recordCount });
+                    recordCount++;
+                }
+            }
+            if (!batch.empty()) dirty = true;
+            written.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+
+            auto now = std::chrono::steady_clock::now();
+            if (dirty && (stop || now - lastSync >= std::chrono::seconds(1))) {
+                syncLog();
+                lastSync = now;
+                dirty = false;
+            }
+            if (tail.size() >= kCompactThreshold || (stop && !tail.empty())) compact();
+            if (stop) break;
+        }
+    }
+#endif
+
+    std::string logPath, indexPath;
+    int fd = -1;
+    uint8_t* map = nullptr;
+    size_t capacity = 0;
+    uint64_t recordCount = 0;
+
+    uint8_t* indexMap = nullptr;
+    size_t indexMapSize = 0;
+    const ScoreIndexEntry* indexEntries = nullptr;
+    uint64_t indexCount = 0;
+    uint64_t indexCovered = 0;
+    std::vector<ScoreIndexEntry> tail; // log records after the index, unsorted
+
+    std::vector<ScoreRecord> pending;
+    bool stopping = false;
+    std::mutex queueMutex; // pending, stopping
+    std::mutex dataMutex;  // mapping, index and tail
+    std::condition_variable wake;
+    std::thread worker;
+};
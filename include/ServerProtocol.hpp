@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "TetrisCore.hpp"
+
+// Wire format between the headless game server and its clients (see
+// src/server.cpp and src/loadgen.cpp). Messages are fixed-size records in
+// host byte order, both ends being this code on the same kind of machine.
+//
+//   client -> server  input:  kind, buttons, seq            (6 bytes)
+//   server -> client  state:  kind, flags, tick, acked seq, score, piece
+//                             (20 bytes) + 20 row masks when the board changed
+
+const int kServerBoardWidth = 10;
+const int kServerBoardHeight = 20;
+const int64_t kServerTickUs = 16667; // 60 Hz
+
+typedef TetrisGame<FixedBoard<kServerBoardWidth, kServerBoardHeight>, SpecialRules> ServerGame;
+
+enum MessageKind : uint8_t {
+    MSG_INPUT = 1,
+    MSG_STATE = 2
+};
+
+enum StateFlags : uint8_t {
+    STATE_BOARD = 1,     // row masks follow
+    STATE_GAME_OVER = 2  // the game ended on this tick and restarted
+};
+
+const int kInputMessageSize = 6;
+const int kStateHeaderSize = 20;
+const int kStateBoardSize = kServerBoardHeight * 2;
+const int kMaxStateSize = kStateHeaderSize + kStateBoardSize;
+
+struct InputMessage {
+    uint8_t buttons = 0;
+    uint32_t seq = 0;
+
+    void write(uint8_t* out) const {
+        out[0] = MSG_INPUT;
+        out[1] = buttons;
+        std::memcpy(out + 2, &seq, 4);
+    }
+
+    bool read(const uint8_t* data) {
+        if (data[0] != MSG_INPUT) return false;
+        buttons = data[1];
+        std::memcpy(&seq, data + 2, 4);
+        return true;
+    }
+};
+
+struct StateMessage {
+    uint8_t flags = 0;
+    uint32_t tick = 0;
+    uint32_t ackSeq = 0;
+    int32_t score = 0;
+    int8_t pieceType = 0;
+    int8_t rotation = 0;
+    int8_t x = 0;
+    int8_t y = 0;
+    uint16_t rows[kServerBoardHeight]; // bit x is column x, only with STATE_BOARD
+
+    void append(std::vector<uint8_t>& out) const {
+        size_t at = out.size();
+        out.resize(at + size());
+        uint8_t* p = out.data() + at;
+        p[0] = MSG_STATE;
+        p[1] = flags;
+        p[2] = p[3] = 0;
+        std::memcpy(p + 4, &tick, 4);
+        std::memcpy(p + 8, &ackSeq, 4);
+        std::memcpy(p + 12, &score, 4);
+        p[16] = (uint8_t)pieceType;
+        p[17] = (uint8_t)rotation;
+        p[18] = (uint8_t)x;
+        p[19] = (uint8_t)y;
+        if (flags & STATE_BOARD) std::memcpy(p + kStateHeaderSize, rows, kStateBoardSize);
+    }
+
+    // Size of the message starting at data (at least the header must be there)
+    static int sizeOf(const uint8_t* data) {
+        return data[1] & STATE_BOARD ? kMaxStateSize : kStateHeaderSize;
+    }
+
+    bool read(const uint8_t* data) {
+        if (data[0] != MSG_STATE) return false;
+        flags = data[1];
+        std::memcpy(&tick, data + 4, 4);
+        std::memcpy(&ackSeq, data + 8, 4);
+        std::memcpy(&score, data + 12, 4);
+        pieceType = (int8_t)data[16];
+        rotation = (int8_t)data[17];
+        x = (int8_t)data[18];
+        y = (int8_t)data[19];
+        if (flags & STATE_BOARD) std::memcpy(rows, data + kStateHeaderSize, kStateBoardSize);
+        return true;
+    }
+
+    int size() const {
+        return flags & STATE_BOARD ? kMaxStateSize : kStateHeaderSize;
+    }
+};
+
+inline int64_t monotonicUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "PiecePalette.hpp"
+#include "TetrisCore.hpp"
+
+// CPU rasterizer for rendering the game without a GPU or OpenGL context, for
+// frame capture on headless machines and golden image comparisons. Every
+// primitive is broken into horizontal spans of one color, so the inner loops
+// are straight runs over a row that the compiler can vectorize.
+
+// Pixels are RGBA bytes in memory (0xAABBGGRR read as a little endian word)
+inline uint32_t rgba(int r, int g, int b, int a = 255)
+{
+    return (uint32_t)r | (uint32_t)g << 8 | (uint32_t)b << 16 | (uint32_t)a << 24;
+}
+
+inline uint32_t rgbaFromRgb(uint32_t rgb, int a = 255)
+{
+    return rgba((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, a);
+}
+
+// Fills n pixels with c, blending by the alpha of c. The result stays opaque.
+inline void fillSpan(uint32_t* p, int n, uint32_t c)
+{
+    uint32_t a = c >> 24;
+    if (a == 255) {
+        std::fill(p, p + n, c);
+        return;
+    }
+    if (a == 0) return;
+    // Red and blue, then green, blended two channels per multiply
+    const uint32_t ia = 255 - a;
+    const uint32_t srcRB = (c & 0x00FF00FF) * a;
+    const uint32_t srcG = (c & 0x0000FF00) * a;
+    for (int i = 0; i < n; i++) {
+        uint32_t d = p[i];
+        uint32_t rb = (((d & 0x00FF00FF) * ia + srcRB) >> 8) & 0x00FF00FF;
+        uint32_t g = (((d & 0x0000FF00) * ia + srcG) >> 8) & 0x0000FF00;
+        p[i] = rb | g | 0xFF000000;
+    }
+}
+
+// 5x7 glyphs for ' ' to '_', one byte per row with the leftmost pixel in bit 4.
+// Lower case letters are drawn with the upper case glyphs.
+inline const uint8_t* fontGlyph(char ch)
+{
+    static const uint8_t glyphs[64][7] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+        { 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00 }, // "
+        { 0x0A, 0x1F, 0x0A, 0x0A, 0x0A, 0x1F, 0x0A }, // #
+        { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // $
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+        { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // &
+        { 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 }, // '
+        { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+        { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+        { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // *
+        { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+        { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ,
+        { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+        { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+        { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+        { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+        { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+        { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+        { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+        { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+        { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ;
+        { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+        { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // =
+        { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+        { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // @
+        { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // A
+        { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+        { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+        { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+        { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+        { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+        { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+        { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+        { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+        { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+        { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+        { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+        { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+        { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+        { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+        { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // Y
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+        { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // [
+        { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+        { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // ]
+        { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // _
+    };
+    if (ch >= 'a' && ch <= 'z') ch = (char)(ch - 'a' + 'A');
+    if (ch < ' ' || ch > '_') ch = '?';
+    return glyphs[ch - ' '];
+}
+
+class Framebuffer {
+public:
+    Framebuffer(int width, int height) : width(width), height(height), pixels((size_t)width * height, rgba(0, 0, 0)) {}
+
+    void clear(uint32_t color) { std::fill(pixels.begin(), pixels.end(), color); }
+
+    uint32_t* row(int y) { return &pixels[(size_t)y * width]; }
+    const uint32_t* row(int y) const { return &pixels[(size_t)y * width]; }
+
+    void fillRect(int x, int y, int w, int h, uint32_t color) {
+        int x0 = std::max(x, 0), x1 = std::min(x + w, width);
+        int y0 = std::max(y, 0), y1 = std::min(y + h, height);
+        if (x0 >= x1) return;
+        for (int yy = y0; yy < y1; yy++) fillSpan(row(yy) + x0, x1 - x0, color);
+    }
+
+    // Outline drawn outside the rectangle, like an SFML shape outline
+    void outlineRect(int x, int y, int w, int h, int thickness, uint32_t color) {
+        fillRect(x - thickness, y - thickness, w + 2 * thickness, thickness, color);
+        fillRect(x - thickness, y + h, w + 2 * thickness, thickness, color);
+        fillRect(x - thickness, y, thickness, h, color);
+        fillRect(x + w, y, thickness, h, color);
+    }
+
+    // Covers the pixels whose centers are inside the circle
+    void fillCircle(float cx, float cy, float radius, uint32_t color) {
+        int y0 = std::max((int)std::ceil(cy - radius - 0.5f), 0);
+        int y1 = std::min((int)std::floor(cy + radius - 0.5f), height - 1);
+        for (int y = y0; y <= y1; y++) {
+            float dy = y + 0.5f - cy;
+            float half = std::sqrt(std::max(radius * radius - dy * dy, 0.0f));
+            int x0 = std::max((int)std::ceil(cx - half - 0.5f), 0);
+            int x1 = std::min((int)std::floor(cx + half - 0.5f), width - 1);
+            if (x0 <= x1) fillSpan(row(y) + x0, x1 - x0 + 1, color);
+        }
+    }
+
+    // Bitmap text, each font pixel a scale x scale square. Returns the width drawn.
+    int drawText(int x, int y, const std::string& text, int scale, uint32_t color) {
+        int penX = x;
+        for (char ch : text) {
+            if (ch == '\n') {
+                penX = x;
+                y += 9 * scale;
+                continue;
+            }
+            const uint8_t* glyph = fontGlyph(ch);
+            for (int gy = 0; gy < 7; gy++) {
+                // Runs of set bits become one span per pixel row
+                for (int gx = 0; gx < 5;) {
+                    if (!(glyph[gy] & (0x10 >> gx))) {
+                        gx++;
+                        continue;
+                    }
+                    int run = gx;
+                    while (run < 5 && (glyph[gy] & (0x10 >> run))) run++;
+                    fillRect(penX + gx * scale, y + gy * scale, (run - gx) * scale, scale, color);
+                    gx = run;
+                }
+            }
+            penX += 6 * scale;
+        }
+        return penX - x;
+    }
+
+    // Binary PPM (P6), opaque RGB
+    bool savePpm(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+        std::vector<uint8_t> line(width * 3);
+        for (int y = 0; y < height; y++) {
+            const uint32_t* src = row(y);
+            for (int x = 0; x < width; x++) {
+                line[x * 3 + 0] = src[x] & 0xFF;
+                line[x * 3 + 1] = (src[x] >> 8) & 0xFF;
+                line[x * 3 + 2] = (src[x] >> 16) & 0xFF;
+            }
+            fwrite(line.data(), 1, line.size(), file);
+        }
+        return fclose(file) == 0;
+    }
+
+    bool loadPpm(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        int w = 0, h = 0, maxValue = 0;
+        bool ok = fscanf(file, "P6 %d %d %d", &w, &h, &maxValue) == 3 && maxValue == 255 && fgetc(file) != EOF;
+        if (ok) {
+            width = w;
+            height = h;
+            pixels.assign((size_t)w * h, 0);
+            std::vector<uint8_t> line(w * 3);
+            for (int y = 0; y < h && ok; y++) {
+                ok = fread(line.data(), 1, line.size(), file) == line.size();
+                for (int x = 0; x < w; x++) row(y)[x] = rgba(line[x * 3], line[x * 3 + 1], line[x * 3 + 2]);
+            }
+        }
+        fclose(file);
+        return ok;
+    }
+
+    int width, height;
+    std::vector<uint32_t> pixels;
+};
+
+// Number of pixels where any channel differs by more than tolerance. When
+// diff is given it receives the differing pixels in red over a dimmed copy of a.
+inline long compareImages(const Framebuffer& a, const Framebuffer& b, int tolerance = 0, Framebuffer* diff = nullptr)
+{
+    if (a.width != b.width || a.height != b.height) return (long)a.width * a.height + 1;
+    if (diff) *diff = Framebuffer(a.width, a.height);
+    long count = 0;
+    for (size_t i = 0; i < a.pixels.size(); i++) {
+        uint32_t pa = a.pixels[i], pb = b.pixels[i];
+        bool differs = false;
+        for (int shift = 0; shift < 24; shift += 8) {
+            int d = (int)((pa >> shift) & 0xFF) - (int)((pb >> shift) & 0xFF);
+            if (d > tolerance || -d > tolerance) differs = true;
+        }
+        count += differs;
+        if (diff) diff->pixels[i] = differs ? rgba(255, 0, 0) : ((pa >> 2) & 0x003F3F3F) | 0xFF000000;
+    }
+    return count;
+}
+
+// What the game window shows on one frame, in the window coordinates of
+// tetris.cpp (a 520 pixel tall screen); the renderer scales it to the target.
+struct SoftEffect {
+    float x, y;
+    uint32_t color;
+};
+
+struct SoftScene {
+    const GameCore* game = nullptr;
+    bool paused = false;
+    int ghostY = 0;
+    bool gridLines = true;
+    std::vector<float> stars; // x, y pairs
+    std::vector<SoftEffect> effects;
+};
+
+inline void renderTetrisScene(Framebuffer& fb, const SoftScene& scene)
+{
+    const GameCore& game = *scene.game;
+    const GameStatus& status = game.status;
+    const int fieldWidth = game.width();
+    const int fieldHeight = game.height();
+
+    // Same layout as the window, then scaled to the framebuffer height
+    const int blockSize = std::min(24, 480 / fieldHeight);
+    const int offsetX = 50;
+    const int hudX = offsetX + fieldWidth * blockSize + 10;
+    const int offsetY = (520 - fieldHeight * blockSize) / 2;
+    const float scale = fb.height / 520.0f;
+    auto px = [scale](float v) { return (int)std::lround(v * scale); };
+    const int block = std::max(1, px((float)blockSize));
+    const int left = px((float)offsetX);
+    const int top = px((float)offsetY);
+    const int textScale = std::max(1, px(2.0f));
+
+    fb.clear(rgba(0, 0, 20));
+    for (size_t i = 0; i + 1 < scene.stars.size(); i += 2)
+        fb.fillCircle((scene.stars[i] + 1) * scale, (scene.stars[i + 1] + 1) * scale, std::max(1.0f, scale), rgba(255, 255, 255));
+
+    // Locked blocks, one span per run of equal cells on a row
+    for (int y = 0; y < fieldHeight; y++) {
+        for (int x = 0; x < fieldWidth;) {
+            int value = game.cell(x, y);
+            int run = x + 1;
+            while (run < fieldWidth && game.cell(run, y) == value) run++;
+            if (value) fb.fillRect(left + x * block, top + y * block, (run - x) * block, block, rgbaFromRgb(pieceRgb(value)));
+            x = run;
+        }
+    }
+
+    if (!status.gameOver) {
+        const Piece& p = status.piece;
+        for (int py = 0; py < kPieceBox; py++) {
+            for (int pxl = 0; pxl < kPieceBox; pxl++) {
+                if (!pieceHasBlock(p.type, p.rotation, pxl, py)) continue;
+                int x = left + (p.x + pxl) * block;
+                fb.fillRect(x, top + (p.y + py) * block, block, block, rgbaFromRgb(pieceRgb(p.type + 1)));
+                if (pieceEffect(p.type) == EFFECT_GHOST) fb.fillRect(x, top + (scene.ghostY + py) * block, block, block, rgba(255, 255, 255, 100));
+            }
+        }
+    }
+
+    for (const SoftEffect& e : scene.effects) fb.fillCircle(e.x * scale, e.y * scale, 3 * scale, e.color);
+
+    fb.outlineRect(left, top, fieldWidth * block, fieldHeight * block, std::max(1, px(2.0f)), rgba(255, 255, 255));
+    if (scene.gridLines) {
+        uint32_t gridColor = rgba(100, 100, 100);
+        int line = std::max(1, px(1.0f));
+        for (int i = 1; i < fieldWidth; i++) fb.fillRect(left + i * block, top, line, fieldHeight * block, gridColor);
+        for (int i = 1; i < fieldHeight; i++) fb.fillRect(left, top + i * block, fieldWidth * block, line, gridColor);
+    }
+
+    uint32_t white = rgba(255, 255, 255);
+    fb.drawText(px((float)hudX), px(50.0f), "Score: " + std::to_string(status.score), textScale, white);
+    fb.drawText(px((float)hudX), px(80.0f), "Lines: " + std::to_string(status.linesCleared), textScale, white);
+    fb.drawText(px((float)hudX), px(110.0f), "Level: " + std::to_string(status.level), textScale, white);
+    const char* special = specialPieceName(status.piece.type);
+    if (!status.gameOver && special) {
+        fb.drawText(px((float)hudX), px(140.0f), "Special:", textScale, white);
+        fb.drawText(px((float)hudX), px(170.0f), special, textScale, white);
+    }
+    if (scene.paused) fb.drawText(px(150.0f), px(200.0f), "PAUSED", textScale * 2, rgba(255, 255, 0));
+    if (status.gameOver) fb.drawText(px(125.0f), px(250.0f), "GAME OVER", textScale * 2, rgba(255, 0, 0));
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LatencyStats.hpp"
+
+// Sound effects with a fixed voice pool.
+//
+// Every effect is decoded (or synthesized) once into an sf::SoundBuffer when
+// the bank is created. trigger() only writes a small record into a lock-free
+// single-producer ring, so the game thread never allocates; a mixer thread
+// drains the ring, picks a voice (stealing the lowest-priority one when the
+// pool is full) and starts playback. With nothing in flight the mixer sleeps
+// until trigger() wakes it, without any periodic wakeups.
+
+enum SoundEffect {
+    SFX_LINE_CLEAR,
+    SFX_ELECTRICAL,
+    SFX_FIRE,
+    SFX_FROZEN,
+    SFX_COUNT
+};
+
+class SoundEffects {
+public:
+    static const int kVoiceCount = 16;
+    static const int kQueueSize = 256; // must be a power of two
+
+    SoundEffects() {
+        const char* names[SFX_COUNT] = { "line_clear", "electrical", "fire", "frozen" };
+        for (int i = 0; i < SFX_COUNT; i++) {
+            if (!buffers[i].loadFromFile(std::string("assets/sounds/") + names[i] + ".wav"))
+                synthesize((SoundEffect)i);
+        }
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~SoundEffects() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            running.store(false, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+        for (auto& v : voices) v.sound.stop();
+    }
+
+    // Called from the game thread: no allocation. The mutex is only taken
+    // when the mixer is asleep, and then only for as long as the mixer holds
+    // it between checking the ring and blocking.
+    void trigger(SoundEffect id) {
+        uint32_t head = queueHead.load(std::memory_order_relaxed);
+        uint32_t tail = queueTail.load(std::memory_order_acquire);
+        if (head - tail >= (uint32_t)kQueueSize) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Request& r = queue[head & (kQueueSize - 1)];
+        r.id = id;
+        r.time = now();
+        queueHead.store(head + 1, std::memory_order_seq_cst);
+        triggered.fetch_add(1, std::memory_order_relaxed);
+        // Passing through the mutex orders this against the mixer's last look
+        // at the ring: it either saw the new request or is already waiting
+        if (mixerIdle.load(std::memory_order_seq_cst)) {
+            { std::lock_guard<std::mutex> lock(wakeMutex); }
+            wake.notify_one();
+        }
+    }
+
+    static int priority(SoundEffect id) {
+        static const int priorities[SFX_COUNT] = { 1, 2, 3, 1 };
+        return priorities[id];
+    }
+
+    // Counters are updated with relaxed atomics and can be read at any time
+    std::atomic<uint64_t> triggered{0};
+    std::atomic<uint64_t> played{0};
+    std::atomic<uint64_t> stolen{0};
+    std::atomic<uint64_t> dropped{0};
+    LatencyStats dispatchLatency; // trigger() until play() was issued
+    LatencyStats startLatency;    // trigger() until the mixer reports a playing offset
+
+private:
+    struct Request {
+        SoundEffect id;
+        int64_t time;
+    };
+
+    struct Voice {
+        sf::Sound sound;
+        int sfx = -1;
+        int priority = 0;
+        int64_t startedAt = 0;
+        int64_t triggeredAt = 0;
+        bool waitingForStart = false;
+    };
+
+    static int64_t now() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void synthesize(SoundEffect id) {
+        const unsigned rate = 44100;
+        const float durations[SFX_COUNT] = { 0.15f, 0.25f, 0.4f, 0.3f };
+        std::vector<sf::Int16> samples((size_t)(durations[id] * rate));
+        uint32_t noise = 0x12345678u + id;
+        float low = 0.0f;
+        for (size_t i = 0; i < samples.size(); i++) {
+            float t = (float)i / rate;
+            float k = (float)i / samples.size();
+            noise = noise * 1664525u + 1013904223u;
+            float white = (float)(noise >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+            float s = 0.0f;
+            switch (id) {
+            case SFX_LINE_CLEAR: // rising chime
+                s = std::sin(6.2831853f * (880.0f + 440.0f * k) * t) * (1.0f - k);
+                break;
+            case SFX_ELECTRICAL: // buzzing square with crackle
+                s = (std::sin(6.2831853f * 120.0f * t) > 0 ? 0.5f : -0.5f) + white * 0.4f;
+                s *= 1.0f - k;
+                break;
+            case SFX_FIRE: // low-passed noise burst
+                low += (white - low) * 0.08f;
+                s = low * 3.0f * std::exp(-6.0f * k);
+                break;
+            case SFX_FROZEN: // shimmering high tone
+                s = std::sin(6.2831853f * 1760.0f * t) * (0.6f + 0.4f * std::sin(6.2831853f * 18.0f * t)) * (1.0f - k);
+                break;
+            default:
+                break;
+            }
+            s = std::max(-1.0f, std::min(1.0f, s));
+            samples[i] = (sf::Int16)(s * 12000.0f);
+        }
+        buffers[id].loadFromSamples(samples.data(), samples.size(), 1, rate);
+    }
+
+    // Free voice first, otherwise steal the oldest voice with the lowest priority
+    Voice* pickVoice(int prio) {
+        Voice* best = nullptr;
+        for (auto& v : voices) {
+            if (v.sound.getStatus() != sf::SoundSource::Playing) return &v;
+            if (v.priority > prio) continue;
+            if (!best || v.priority < best->priority || (v.priority == best->priority && v.startedAt < best->startedAt))
+                best = &v;
+        }
+        if (best) stolen.fetch_add(1, std::memory_order_relaxed);
+        return best;
+    }
+
+    void dispatch(const Request& r) {
+        int prio = priority(r.id);
+        Voice* v = pickVoice(prio);
+        if (!v) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        v->sound.stop();
+        if (v->sfx != r.id) {
+            v->sound.setBuffer(buffers[r.id]);
+            v->sfx = r.id;
+        }
+        v->priority = prio;
+        v->triggeredAt = r.time;
+        v->sound.play();
+        v->startedAt = now();
+        v->waitingForStart = true;
+        dispatchLatency.add((uint64_t)(v->startedAt - r.time));
+        played.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        while (running.load(std::memory_order_relaxed)) {
+            uint32_t tail = queueTail.load(std::memory_order_relaxed);
+            uint32_t head = queueHead.load(std::memory_order_acquire);
+            while (tail != head) {
+                dispatch(queue[tail & (kQueueSize - 1)]);
+                tail++;
+            }
+            queueTail.store(tail, std::memory_order_release);
+
+            bool busy = false;
+            for (auto& v : voices) {
+                if (v.waitingForStart && v.sound.getPlayingOffset() > sf::Time::Zero) {
+                    startLatency.add((uint64_t)(now() - v.triggeredAt));
+                    v.waitingForStart = false;
+                }
+                busy = busy || v.waitingForStart;
+            }
+
+            if (busy) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } else {
+                // Nothing in flight: sleep until trigger() or the destructor
+                // wakes us; both pass through wakeMutex, so no wakeup is lost
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                mixerIdle.store(true, std::memory_order_seq_cst);
+                wake.wait(lock, [this]() {
+                    return !running.load(std::memory_order_relaxed) ||
+                           queueHead.load(std::memory_order_seq_cst) != queueTail.load(std::memory_order_relaxed);
+                });
+                mixerIdle.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    sf::SoundBuffer buffers[SFX_COUNT];
+    Voice voices[kVoiceCount];
+    Request queue[kQueueSize];
+    std::atomic<uint32_t> queueHead{0};
+    std::atomic<uint32_t> queueTail{0};
+    std::atomic<bool> running{true};
+    std::atomic<bool> mixerIdle{false};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread worker;
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Named rectangles of one texture. Images, or frames cut out of sprite
+// sheets, are queued with add() and packed into a single texture by pack(),
+// so everything drawn from the atlas can go out in one draw call.
+//
+// The packed layout can be saved as a PNG plus a text file with one
+// "name x y width height" line per region and loaded back, to pack offline
+// instead of at startup. Regions are in texture pixels, which is what
+// sf::Vertex::texCoords expects.
+class SpriteAtlas {
+public:
+    // Each region is surrounded by a one pixel copy of its own edges, so
+    // scaled or smoothed sprites never sample their neighbours
+    static const int kPadding = 1;
+
+    // Queues rect of image (the whole image by default); only that part is
+    // kept. Returns the index the region will have, or -1 once packed.
+    int add(const std::string& name, const sf::Image& image, sf::IntRect rect = sf::IntRect()) {
+        if (packed) return -1;
+        sf::Vector2u size = image.getSize();
+        if (rect.width <= 0 || rect.height <= 0) rect = sf::IntRect(0, 0, (int)size.x, (int)size.y);
+        pending.emplace_back();
+        pending.back().create(rect.width, rect.height, sf::Color::Transparent);
+        pending.back().copy(image, 0, 0, rect);
+        names.push_back(name);
+        return (int)names.size() - 1;
+    }
+
+    // Queues count frames of a sprite sheet: first, then first moved by
+    // step each time. They are named name0, name1... and get consecutive
+    // indexes; returns the first one, or -1 once the atlas is packed.
+    int addFrames(const std::string& name, const sf::Image& sheet, const sf::IntRect& first, int count, sf::Vector2i step) {
+        if (packed || count <= 0) return -1;
+        int index = -1;
+        for (int i = 0; i < count; i++) {
+            sf::IntRect rect(first.left + step.x * i, first.top + step.y * i, first.width, first.height);
+            int added = add(name + std::to_string(i), sheet, rect);
+            if (i == 0) index = added;
+        }
+        return index;
+    }
+
+    // Places every queued region and uploads the texture. Tries each power
+    // of two width up to maxSize and keeps the layout with the least area.
+    bool pack(unsigned maxSize = 4096) {
+        if (packed || pending.empty()) return packed;
+        std::vector<int> order(pending.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            sf::Vector2u sa = pending[a].getSize(), sb = pending[b].getSize();
+            return sa.y != sb.y ? sa.y > sb.y : sa.x > sb.x;
+        });
+
+        unsigned bestWidth = 0, bestHeight = 0;
+        std::vector<sf::Vector2i> placed(pending.size()), best;
+        for (unsigned width = 64; width <= maxSize; width *= 2) {
+            unsigned height = shelves(order, width, placed);
+            if (height == 0 || height > maxSize) continue;
+            if (bestWidth == 0 || (uint64_t)width * height < (uint64_t)bestWidth * bestHeight) {
+                bestWidth = width;
+                bestHeight = height;
+                best = placed;
+            }
+        }
+        if (bestWidth == 0) return false;
+
+        image.create(bestWidth, bestHeight, sf::Color::Transparent);
+        regions.resize(pending.size());
+        for (size_t i = 0; i < pending.size(); i++) {
+            const sf::Image& from = pending[i];
+            int w = (int)from.getSize().x, h = (int)from.getSize().y;
+            int x = best[i].x, y = best[i].y;
+            image.copy(from, x, y);
+            // Edge pixels outwards: left and right columns, then top and
+            // bottom rows including the corners just filled
+            image.copy(from, x - 1, y, sf::IntRect(0, 0, 1, h));
+            image.copy(from, x + w, y, sf::IntRect(w - 1, 0, 1, h));
+            image.copy(image, x - 1, y - 1, sf::IntRect(x - 1, y, w + 2, 1));
+            image.copy(image, x - 1, y + h, sf::IntRect(x - 1, y + h - 1, w + 2, 1));
+            regions[i] = sf::IntRect(x, y, w, h);
+        }
+        if (!texture.loadFromImage(image)) return false;
+        pending.clear();
+        packed = true;
+        return true;
+    }
+
+    bool saveToFile(const std::string& imagePath, const std::string& layoutPath) const {
+        if (!packed || !image.saveToFile(imagePath)) return false;
+        std::ofstream layout(layoutPath);
+        for (size_t i = 0; i < regions.size(); i++) {
+            const sf::IntRect& r = regions[i];
+            layout << names[i] << ' ' << r.left << ' ' << r.top << ' ' << r.width << ' ' << r.height << '\n';
+        }
+        return (bool)layout;
+    }
+
+    // Replaces whatever the atlas held with a saved one
+    bool loadFromFile(const std::string& imagePath, const std::string& layoutPath) {
+        std::ifstream layout(layoutPath);
+        if (!layout || !image.loadFromFile(imagePath) || !texture.loadFromImage(image)) return false;
+        names.clear();
+        regions.clear();
+        pending.clear();
+        std::string name;
+        sf::IntRect r;
+        while (layout >> name >> r.left >> r.top >> r.width >> r.height) {
+            names.push_back(name);
+            regions.push_back(r);
+        }
+        packed = true;
+        return true;
+    }
+
+    // -1 for an unknown name
+    int find(const std::string& name) const {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) return (int)i;
+        }
+        return -1;
+    }
+
+    const sf::IntRect& rect(int region) const { return regions[region]; }
+    const std::string& name(int region) const { return names[region]; }
+    size_t size() const { return names.size(); }
+    bool isPacked() const { return packed; }
+    const sf::Texture& getTexture() const { return texture; }
+
+private:
+    // Rows of regions, tallest first; returns the height used, 0 when a
+    // region is wider than the texture
+    unsigned shelves(const std::vector<int>& order, unsigned width, std::vector<sf::Vector2i>& placed) const {
+        int x = 0, y = 0, shelf = 0;
+        for (int i : order) {
+            int w = (int)pending[i].getSize().x + 2 * kPadding, h = (int)pending[i].getSize().y + 2 * kPadding;
+            if (w > (int)width) return 0;
+            if (x + w > (int)width) {
+                y += shelf;
+                x = 0;
+                shelf = 0;
+            }
+            placed[i] = sf::Vector2i(x + kPadding, y + kPadding);
+            x += w;
+            shelf = std::max(shelf, h);
+        }
+        return (unsigned)(y + shelf);
+    }
+
+    std::vector<std::string> names;
+    std::vector<sf::IntRect> regions; // valid once packed
+    std::vector<sf::Image> pending;   // until packed
+    sf::Image image;
+    sf::Texture texture;
+    bool packed = false;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SpriteAtlas.hpp"
+
+// Frames of an atlas played at a fixed rate
+struct AnimationClip {
+    std::vector<int> frames; // atlas regions, in order
+    float frameSeconds = 0.1f;
+    bool loop = true;        // otherwise it stops on the last frame
+
+    // Region shown t seconds after the clip started
+    int frameAt(float t) const {
+        int n = (int)frames.size();
+        int i = t > 0.0f ? (int)(t / frameSeconds) : 0;
+        return frames[loop ? i % n : std::min(i, n - 1)];
+    }
+
+    // The regions called name0, name1... of an atlas, as many as it has
+    static AnimationClip fromAtlas(const SpriteAtlas& atlas, const std::string& name, float frameSeconds) {
+        AnimationClip clip;
+        clip.frameSeconds = frameSeconds;
+        for (int region; (region = atlas.find(name + std::to_string(clip.frames.size()))) >= 0;) clip.frames.push_back(region);
+        return clip;
+    }
+};
+
+// Sprites of one atlas drawn with a single draw call. Fill it with add()
+// every frame (after clear()), then draw(): sprites come out ordered by
+// layer and, within a layer, in the order they were added. Layers are
+// 0..255, so the ordering is a counting sort that writes every quad
+// straight to its final place in the vertex array.
+//
+// Animated sprites take their frame from the batch's clock, set once per
+// frame with setTime(), instead of each sprite keeping an sf::Clock; a
+// start time per sprite keeps them from all moving in step.
+class SpriteBatch {
+public:
+    explicit SpriteBatch(const SpriteAtlas& atlas) : atlas(atlas) {}
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+    int addClip(const AnimationClip& clip) {
+        clips.push_back(clip);
+        return (int)clips.size() - 1;
+    }
+
+    const AnimationClip& clip(int id) const { return clips[id]; }
+
+    // The shared clock, in seconds; set before adding animated sprites
+    void setTime(float seconds) { time = seconds; }
+    float getTime() const { return time; }
+
+    void reserve(size_t count) {
+        sprites.reserve(count);
+        vertices.reserve(count * 4);
+    }
+
+    void clear() { sprites.clear(); }
+
+    // position is the top-left corner, scale multiplies the region's size
+    // and color tints the texture
+    void add(int region, sf::Vector2f position, uint8_t layer = 0, sf::Color color = sf::Color::White, float scale = 1.0f) {
+        sprites.push_back({ position, color, scale, region, layer });
+    }
+
+    // A clip that started at startTime on the batch's clock
+    void addAnimated(int clip, float startTime, sf::Vector2f position, uint8_t layer = 0, sf::Color color = sf::Color::White,
+                     float scale = 1.0f) {
+        add(clips[clip].frameAt(time - startTime), position, layer, color, scale);
+    }
+
+    // Quads for every sprite, in drawing order
+    const std::vector<sf::Vertex>& build() {
+        uint32_t start[256] = {};
+        for (const Sprite& s : sprites) start[s.layer]++;
+        uint32_t offset = 0;
+        for (int layer = 0; layer < 256; layer++) {
+            uint32_t count = start[layer];
+            start[layer] = offset;
+            offset += count;
+        }
+        vertices.resize(sprites.size() * 4);
+        for (const Sprite& s : sprites) {
+            const sf::IntRect& r = atlas.rect(s.region);
+            float left = (float)r.left, top = (float)r.top, right = left + r.width, bottom = top + r.height;
+            float w = r.width * s.scale, h = r.height * s.scale;
+            sf::Vertex* v = &vertices[(size_t)start[s.layer]++ * 4];
+            v[0] = sf::Vertex(s.position, s.color, sf::Vector2f(left, top));
+            v[1] = sf::Vertex(sf::Vector2f(s.position.x + w, s.position.y), s.color, sf::Vector2f(right, top));
+            v[2] = sf::Vertex(sf::Vector2f(s.position.x + w, s.position.y + h), s.color, sf::Vector2f(right, bottom));
+            v[3] = sf::Vertex(sf::Vector2f(s.position.x, s.position.y + h), s.color, sf::Vector2f(left, bottom));
+        }
+        return vertices;
+    }
+
+    // One draw call however many sprites there are
+    void draw(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default) {
+        if (sprites.empty()) return;
+        build();
+        states.texture = &atlas.getTexture();
+        target.draw(vertices.data(), vertices.size(), sf::Quads, states);
+    }
+
+    size_t size() const { return sprites.size(); }
+
+private:
+    struct Sprite {
+        sf::Vector2f position;
+        sf::Color color;
+        float scale;
+        int region;
+        uint8_t layer;
+    };
+
+    const SpriteAtlas& atlas;
+    std::vector<AnimationClip> clips;
+    std::vector<Sprite> sprites;
+    std::vector<sf::Vertex> vertices;
+    float time = 0.0f;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include "SpriteAtlas.hpp"
+
+// Animations of the sprite sheets in assets/images, as atlas frames:
+// pikachu_run0..3 with the rectangles of archive_examples/03_1_Pikachu.cpp
+// and ken_stance0..3, the fighting stance at the top left of ken.png.
+// Ken's sheet has no alpha, so its background color becomes transparent.
+inline bool addSpriteSheets(SpriteAtlas& atlas)
+{
+    sf::Image pikachu, ken;
+    if (!pikachu.loadFromFile("assets/images/pikachu.png") || !ken.loadFromFile("assets/images/ken.png")) return false;
+    ken.createMaskFromColor(ken.getPixel(0, 0));
+    atlas.addFrames("pikachu_run", pikachu, sf::IntRect(17, 133, 64, 36), 4, sf::Vector2i(64, 0));
+    const int stanceX[4] = { 0, 52, 111, 164 };
+    for (int i = 0; i < 4; i++) atlas.add("ken_stance" + std::to_string(i), ken, sf::IntRect(stanceX[i], 8, 50, 101));
+    return true;
+}
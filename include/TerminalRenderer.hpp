@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PiecePalette.hpp"
+#include "TetrisCore.hpp"
+#ifndef _WIN32
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// Text mode renderer for watching games over SSH. Draws into a back buffer of
+// character cells; present() compares it with what the terminal already shows
+// and emits only the cells that changed, with cursor moves to skip the rest
+// and color codes only where the color changes.
+
+struct TerminalCell {
+    char32_t glyph = ' ';
+    uint8_t fg = 7;  // xterm 256 color index
+    uint8_t bg = 0;
+
+    bool operator==(const TerminalCell& o) const { return glyph == o.glyph && fg == o.fg && bg == o.bg; }
+    bool operator!=(const TerminalCell& o) const { return !(*this == o); }
+};
+
+class TerminalScreen {
+public:
+    TerminalScreen(int columns, int rows) : columns(columns), rows(rows), back(columns * rows), front(columns * rows) {
+        invalidate();
+    }
+
+    int width() const { return columns; }
+    int height() const { return rows; }
+    const TerminalCell& at(int x, int y) const { return back[y * columns + x]; }
+
+    void clear(uint8_t bg = 0) {
+        for (auto& c : back) c = TerminalCell{ ' ', 7, bg };
+    }
+
+    void put(int x, int y, char32_t glyph, uint8_t fg, uint8_t bg) {
+        if (x < 0 || y < 0 || x >= columns || y >= rows) return;
+        back[y * columns + x] = TerminalCell{ glyph, fg, bg };
+    }
+
+    void text(int x, int y, const std::string& s, uint8_t fg, uint8_t bg = 0) {
+        for (size_t i = 0; i < s.size(); i++) put(x + (int)i, y, (unsigned char)s[i], fg, bg);
+    }
+
+    // Forgets what the terminal shows, so the next present() repaints everything
+    void invalidate() {
+        for (auto& c : front) c.glyph = 0;
+        colorKnown = false;
+    }
+
+    // Appends the escape sequences that bring the terminal up to date with
+    // the back buffer to out and returns how many bytes were added
+    size_t present(std::string& out) {
+        size_t start = out.size();
+        int cursorX = -1, cursorY = -1; // unknown after the last frame
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < columns; x++) {
+                const TerminalCell& c = back[y * columns + x];
+                TerminalCell& shown = front[y * columns + x];
+                if (c == shown) continue;
+                if (x != cursorX || y != cursorY) {
+                    // A short run of unchanged cells is cheaper to rewrite than to jump over
+                    int gap = x - cursorX;
+                    if (y == cursorY && gap > 0 && gap <= 3 && sameColors(y, cursorX, x)) {
+                        for (int i = cursorX; i < x; i++) appendGlyph(out, front[y * columns + i].glyph);
+                    } else {
+                        out += "\x1b[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+                    }
+                }
+                if (!colorKnown || c.fg != lastFg || c.bg != lastBg) {
+                    out += "\x1b[38;5;" + std::to_string(c.fg) + ";48;5;" + std::to_string(c.bg) + "m";
+                    lastFg = c.fg;
+                    lastBg = c.bg;
+                    colorKnown = true;
+                }
+                appendGlyph(out, c.glyph);
+                shown = c;
+                cursorX = x + 1;
+                cursorY = y;
+            }
+        }
+        return out.size() - start;
+    }
+
+private:
+    // Whether the cells in [from, to) of row y can be rewritten with the current colors
+    bool sameColors(int y, int from, int to) const {
+        for (int i = from; i < to; i++) {
+            const TerminalCell& c = front[y * columns + i];
+            if (!colorKnown || c.fg != lastFg || c.bg != lastBg || c.glyph == 0) return false;
+        }
+        return true;
+    }
+
+    static void appendGlyph(std::string& out, char32_t g) {
+        if (g < 0x80) {
+            out += (char)g;
+        } else if (g < 0x800) {
+            out += (char)(0xC0 | (g >> 6));
+            out += (char)(0x80 | (g & 0x3F));
+        } else {
+            out += (char)(0xE0 | (g >> 12));
+            out += (char)(0x80 | ((g >> 6) & 0x3F));
+            out += (char)(0x80 | (g & 0x3F));
+        }
+    }
+
+    int columns, rows;
+    std::vector<TerminalCell> back;
+    std::vector<TerminalCell> front; // what the terminal shows, glyph 0 when unknown
+    bool colorKnown = false;
+    uint8_t lastFg = 0, lastBg = 0;
+};
+
+// xterm 256 color for a cell value: 0 is empty, then piece type + 1, then
+// garbage. Pieces get the nearest color of the 6x6x6 cube (levels 0, 95,
+// 135, 175, 215, 255), garbage a gray.
+inline uint8_t terminalPieceColor(int value)
+{
+    if (value == 0) return 0;
+    if (value == kGarbageCell) return 244;
+    uint32_t rgb = pieceRgb(value);
+    auto level = [](int c) { return c < 48 ? 0 : c < 115 ? 1 : (c - 35) / 40; };
+    return (uint8_t)(16 + 36 * level((rgb >> 16) & 0xFF) + 6 * level((rgb >> 8) & 0xFF) + level(rgb & 0xFF));
+}
+
+// Draws the field (two columns per cell), the current piece, its drop
+// shadow and the HUD. Needs 2 * width + 26 columns and height + 2 rows.
+inline void drawTerminalGame(TerminalScreen& screen, const GameCore& game, const std::string& message = std::string())
+{
+    const GameStatus& status = game.status;
+    const int w = game.width();
+    const int h = game.height();
+    const uint8_t borderColor = 250;
+    screen.clear();
+
+    for (int y = 0; y <= h + 1; y++) {
+        screen.put(0, y, U'│', borderColor, 0);
+        screen.put(2 * w + 1, y, U'│', borderColor, 0);
+    }
+    for (int x = 0; x < 2 * w + 2; x++) screen.put(x, h + 1, U'─', borderColor, 0);
+    screen.put(0, h + 1, U'└', borderColor, 0);
+    screen.put(2 * w + 1, h + 1, U'┘', borderColor, 0);
+    for (int x = 1; x <= 2 * w; x++) screen.put(x, 0, ' ', 7, 0);
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int value = game.cell(x, y);
+            uint8_t bg = value ? terminalPieceColor(value) : 0;
+            screen.put(1 + 2 * x, 1 + y, value ? ' ' : U'·', 238, bg);
+            screen.put(2 + 2 * x, 1 + y, ' ', 238, bg);
+        }
+    }
+
+    if (!status.gameOver) {
+        const Piece& p = status.piece;
+        int ghost = game.ghostY();
+        uint8_t color = terminalPieceColor(p.type + 1);
+        // Shadow first, so the piece covers it where the two overlap
+        for (int pass = 0; pass < 2; pass++) {
+            int top = pass == 0 ? ghost : p.y;
+            for (int py = 0; py < kPieceBox; py++) {
+                for (int px = 0; px < kPieceBox; px++) {
+                    if (!pieceHasBlock(p.type, p.rotation, px, py) || top + py < 0) continue;
+                    int x = 1 + 2 * (p.x + px);
+                    for (int half = 0; half < 2; half++) {
+                        if (pass == 0) screen.put(x + half, 1 + top + py, U'░', color, 0);
+                        else screen.put(x + half, 1 + top + py, ' ', 7, color);
+                    }
+                }
+            }
+        }
+    }
+
+    int hudX = 2 * w + 4;
+    screen.text(hudX, 1, "Score: " + std::to_string(status.score), 15);
+    screen.text(hudX, 2, "Lines: " + std::to_string(status.linesCleared), 15);
+    screen.text(hudX, 3, "Level: " + std::to_string(status.level), 15);
+    const char* special = specialPieceName(status.piece.type);
+    if (special && !status.gameOver) {
+        screen.text(hudX, 5, "Special:", 15);
+        screen.text(hudX, 6, special, terminalPieceColor(status.piece.type + 1));
+    }
+    if (status.frozen) screen.text(hudX, 8, "FROZEN", 201);
+    if (status.gameOver) screen.text(hudX, 8, "GAME OVER", 196);
+    if (!message.empty()) screen.text(hudX, h, message, 244);
+}
+
+#ifndef _WIN32
+// Puts the terminal in raw, non-blocking mode for the lifetime of the object:
+// keys arrive one by one without echo or line buffering.
+class RawTerminal {
+public:
+    RawTerminal() {
+        active = tcgetattr(STDIN_FILENO, &saved) == 0;
+        if (active) {
+            termios raw = saved;
+            raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+            raw.c_iflag &= ~(IXON | ICRNL);
+            // Reads return at once, with or without a byte. O_NONBLOCK is avoided
+            // because stdout shares the file and would stop blocking too.
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+        }
+        // Alternate screen, hidden cursor, cleared
+        write("\x1b[?1049h\x1b[?25l\x1b[2J");
+    }
+
+    ~RawTerminal() { restore(); }
+
+    // Back to the normal screen and cooked mode, safe to call more than once
+    void restore() {
+        if (restored) return;
+        write("\x1b[0m\x1b[?25h\x1b[?1049l");
+        if (active) tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+        restored = true;
+    }
+
+    bool isTerminal() const { return active; }
+
+    // Returns false when no more input is waiting
+    bool readByte(uint8_t& byte) {
+        return ::read(STDIN_FILENO, &byte, 1) == 1;
+    }
+
+    static void write(const std::string& s) {
+        size_t done = 0;
+        while (done < s.size()) {
+            ssize_t n = ::write(STDOUT_FILENO, s.data() + done, s.size() - done);
+            if (n <= 0) break;
+            done += n;
+        }
+    }
+
+private:
+    termios saved;
+    bool active = false;
+    bool restored = false;
+};
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "TetrisCore.hpp"
+
+// Greedy placement bot. Tries every rotation and column for the current piece,
+// drops it and scores the resulting board by completed lines, aggregate
+// height, holes and bumpiness. Works on the row bitmasks directly, so it is
+// also a decent workload for benchmarking the game core.
+
+struct BotMove {
+    int rotation;
+    int x;
+    float score;
+};
+
+template <class Game>
+float evaluatePlacement(const Game& game, int type, int rotation, int x, int y)
+{
+    typedef typename Game::Row Row;
+    const int w = game.board.width();
+    const int h = game.board.height();
+    const Row* rows = game.board.rowData() + kBoardPad;
+    const PieceShape& shape = pieceShape(type, rotation);
+    const Row field = game.board.fieldMask();
+
+    int heights[64] = {};
+    Row covered = 0;
+    int lines = 0;
+    int holes = 0;
+    for (int row = 0; row < h; row++) {
+        Row r = rows[row];
+        int py = row - y;
+        if (py >= shape.top && py <= shape.bottom) r |= (Row)shape.rows[py] << (x + kBoardPad);
+        r &= field;
+        if (r == field) {
+            lines++;
+            continue;
+        }
+        // Columns whose top block is on this row
+        for (Row fresh = r & ~covered; fresh; fresh &= fresh - 1)
+            heights[lowestBit(fresh) - kBoardPad] = h - row;
+        holes += bitCount(~r & covered & field);
+        covered |= r;
+    }
+
+    int aggregate = 0;
+    int bumpiness = 0;
+    for (int c = 0; c < w; c++) {
+        aggregate += heights[c];
+        if (c > 0) bumpiness += heights[c] > heights[c - 1] ? heights[c] - heights[c - 1] : heights[c - 1] - heights[c];
+    }
+    return -0.51f * aggregate + 0.76f * lines - 0.36f * holes - 0.18f * bumpiness;
+}
+
+template <class Game>
+BotMove findBotMove(const Game& game)
+{
+    const Piece& p = game.status.piece;
+    BotMove best = { p.rotation, p.x, -1e30f };
+    for (int r = 0; r < 4; r++) {
+        const PieceShape& shape = pieceShape(p.type, r);
+        for (int x = -shape.left; x + shape.right < game.board.width(); x++) {
+            if (!game.fits(p.type, r, x, p.y)) continue;
+            int y = game.dropY(p.type, r, x, p.y);
+            float score = evaluatePlacement(game, p.type, r, x, y);
+            if (score > best.score) best = { r, x, score };
+        }
+    }
+    return best;
+}
+
+// Turns a chosen placement into buttons for step(): rotate first, then slide,
+// then hard drop. Rotation and hard drop react to presses, so the buttons of
+// the previous step are needed to release them in between.
+inline uint8_t botInput(const Piece& piece, const BotMove& move, uint8_t previous)
+{
+    if ((piece.rotation & 3) != (move.rotation & 3)) return (previous & INPUT_ROTATE) ? 0 : INPUT_ROTATE;
+    if (piece.x < move.x) return INPUT_RIGHT;
+    if (piece.x > move.x) return INPUT_LEFT;
+    return (previous & INPUT_HARD_DROP) ? 0 : INPUT_HARD_DROP;
+}
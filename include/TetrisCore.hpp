@@ -0,0 +1,915 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Tetris rules without any SFML dependency, so they can also run headless.
+//
+// The game is a template over a board and a rule set. Rows are stored as
+// bitmasks (bit kBoardPad + x is column x) padded with solid walls on both
+// sides and solid rows above and below, so a fit test is a handful of ANDs
+// with no bounds checks. FixedBoard<W, H> picks the narrowest row type for
+// the width; DynamicBoard is the generic runtime-sized version of the same
+// thing. The rule set decides whether special pieces exist.
+//
+// Time runs in fixed ticks, however long the frames that feed
+// step() are, so a game plays the same at any frame rate. Gravity is a
+// fraction of a row per tick; the rows it builds up are taken in one move,
+// up to 20 a tick (20G), clamped to the row where the piece lands, which is
+// kept up to date as the piece moves rather than probed for every row it
+// falls. A piece resting on the stack locks after a delay that moving or
+// rotating it starts over, a limited number of times.
+
+struct Piece {
+    int type;
+    int rotation;
+    int x;
+    int y;
+};
+
+const int kNormalPieces = 7;   // in the built-in set
+const int kPieceTypes = 11;    // in the built-in set
+const int kMaxPieceTypes = 32; // in any set
+const int kPieceBox = 5;       // pieces are defined in boxes up to 5x5
+const int kBoardPad = 4; // wall columns / rows around the field
+const int kMaxBoardHeight = 56;
+const int kGarbageCell = kMaxPieceTypes + 1; // cell value of garbage rows
+
+const int kTicksPerSecond = 60;
+const int64_t kTickTime = 1 << 20;             // frame time is counted in 1/kTickTime ticks
+const int32_t kGravityUnit = 1 << 16;          // gravity is in 1/kGravityUnit rows per tick
+const int32_t kGravity20G = 20 * kGravityUnit; // the fastest: 20 rows every tick
+const int kLockDelay = 30;                     // ticks, half a second
+const int kLockResets = 15;
+
+// Gravity for a level: level + 1 rows per second up to level 10, as it has
+// always been, then twice as fast every level until 20G from level 17.
+// Rounded up, so a row falls on the tick it is due.
+inline int32_t gravityForLevel(int level)
+{
+    int64_t rowsPerSecond = std::min(std::max(level, 1), 10) + 1;
+    if (level > 10) rowsPerSecond <<= std::min(level - 10, 7);
+    return (int32_t)std::min<int64_t>((rowsPerSecond * kGravityUnit + kTicksPerSecond - 1) / kTicksPerSecond, kGravity20G);
+}
+
+// Built-in piece types
+enum SpecialPiece {
+    FROZEN_PIECE = 7,
+    ELECTRICAL_PIECE = 8,
+    FIRE_PIECE = 9,
+    GHOST_PIECE = 10
+};
+
+// What a piece does when it locks, if the rule set has special pieces
+enum PieceEffect : uint8_t {
+    EFFECT_NONE,
+    EFFECT_FROZEN,     // stops the game for a few seconds
+    EFFECT_ELECTRICAL, // wipes the row the box's top is on and the one above
+    EFFECT_FIRE,       // burns the 5x5 cells around the box's corner
+    EFFECT_GHOST       // shows where it will land
+};
+
+// Buttons held during one step
+enum InputBits : uint8_t {
+    INPUT_LEFT = 1,
+    INPUT_RIGHT = 2,
+    INPUT_ROTATE = 4,
+    INPUT_SOFT_DROP = 8,
+    INPUT_HARD_DROP = 16
+};
+
+// What happened during a step, so the front end can play sounds and spawn particles
+enum GameEventType : uint8_t {
+    EVENT_LOCK,       // piece locked at x, y
+    EVENT_LINE,       // row y completed (before the rows above moved down)
+    EVENT_FROZEN,     // frozen piece locked
+    EVENT_ELECTRICAL, // row y wiped by an electrical piece
+    EVENT_FIRE,       // cell x, y burned by a fire piece
+    EVENT_CASCADE,    // cascade chain step x, y cells fell
+    EVENT_GARBAGE,    // y garbage rows pushed in with the hole at column x
+    EVENT_GAME_OVER
+};
+
+struct GameEvent {
+    GameEventType type;
+    int16_t x;
+    int16_t y;
+};
+
+// Tetromino definitions (4x4)
+constexpr const char* kTetrominoes[kPieceTypes] = {
+    "..X...X...X...X.", // I
+    "..X..XX...X.....", // T
+    ".X..XX..X.......", // S
+    "..X..XX..X......", // Z
+    ".XX..XX.........", // O
+    ".X...X...XX.....", // L
+    "..X...X..XX.....", // J
+    "..X..XX..X......", // Frozen (same as Z for simplicity)
+    ".XX..XX.........", // Electrical (same as O)
+    "..X..XX...X.....", // Fire (same as T)
+    "..X...X...X...X.", // Ghost (same as I)
+};
+
+constexpr const char* kTetrominoNames[kPieceTypes] = { "I", "T", "S", "Z", "O", "L", "J", "Frozen", "Electrical", "Fire", "Ghost" };
+
+constexpr uint32_t kTetrominoColors[kPieceTypes] = {
+    0x00FFFF, 0x800080, 0x00FF00, 0xFF0000, 0xFFFF00, 0xFFA500, 0x0000FF, // I T S Z O L J
+    0xFF00FF, 0xFFFF00, 0xFF0000, 0x00FF00,                               // Frozen Electrical Fire Ghost
+};
+
+// Index into an n x n box of the cell that lands on px, py after r turns
+constexpr int rotate(int px, int py, int r, int n = 4)
+{
+    switch (r % 4) {
+    case 0: return py * n + px;
+    case 1: return (n - 1 - px) * n + py;
+    case 2: return n * n - 1 - py * n - px;
+    case 3: return n - 1 - py + px * n;
+    }
+    return 0;
+}
+
+// One rotation of a piece: bit px of rows[py] is set when that block is
+// filled, and top..bottom, left..right bound the blocks. The fit test
+// always reads the four rows from window on, the last of them the bottom
+// one when the piece reaches that low, plus the top row masked by extra for
+// a piece five rows tall: a fixed cost whatever the piece, and every row
+// read stays inside the board's padding. Bit py of columns[px] is set for
+// the same blocks, for computing drops column by column.
+struct PieceShape {
+    uint8_t rows[kPieceBox];
+    uint8_t columns[kPieceBox];
+    int8_t top;
+    int8_t bottom;
+    int8_t left;
+    int8_t right;
+    int8_t window;
+    uint8_t extra;
+};
+
+// Piece types picked with probability proportional to their weights.
+// totals are running sums, so equal weights pick types[r % count].
+struct SpawnPool {
+    int count;
+    uint8_t types[kMaxPieceTypes];
+    uint32_t totals[kMaxPieceTypes];
+
+    int pick(uint32_t r) const {
+        uint32_t target = r % totals[count - 1];
+        int i = 0;
+        while (totals[i] <= target) i++;
+        return types[i];
+    }
+};
+
+// A piece set compiled to masks: every rotation of every piece with its
+// bounds, plus what the game needs to spawn, score and draw them. The
+// built-in set is compiled from kTetrominoes; others are loaded from a
+// definition file at startup (PieceSet.hpp) through the same addPiece().
+struct PieceTable {
+    int count;
+    PieceShape shapes[kMaxPieceTypes][4];
+    PieceEffect effects[kMaxPieceTypes];
+    uint32_t colors[kMaxPieceTypes]; // 0xRRGGBB
+    int cells[kMaxPieceTypes];
+    char names[kMaxPieceTypes][16];
+    SpawnPool normal;  // pieces without an effect
+    SpawnPool special; // one in three pieces comes from here with special rules
+};
+
+// Adds a piece given as the n * n cells of its box, row by row, any
+// character but '.' being a block. Rotations turn the box about its center.
+// A weight of 0 keeps the piece out of the spawn pools.
+constexpr void addPiece(PieceTable& table, const char* box, int n, const char* name, uint32_t color, PieceEffect effect,
+                        uint32_t weight)
+{
+    const int t = table.count++;
+    for (int r = 0; r < 4; r++) {
+        PieceShape& shape = table.shapes[t][r];
+        shape.top = shape.left = kPieceBox;
+        shape.bottom = shape.right = -1;
+        for (int py = 0; py < n; py++) {
+            for (int px = 0; px < n; px++) {
+                if (box[rotate(px, py, r, n)] == '.') continue;
+                shape.rows[py] |= (uint8_t)(1 << px);
+                shape.columns[px] |= (uint8_t)(1 << py);
+                if (py < shape.top) shape.top = (int8_t)py;
+                if (py > shape.bottom) shape.bottom = (int8_t)py;
+                if (px < shape.left) shape.left = (int8_t)px;
+                if (px > shape.right) shape.right = (int8_t)px;
+                if (r == 0) table.cells[t]++;
+            }
+        }
+        shape.window = (int8_t)(shape.bottom > 3 ? shape.bottom - 3 : 0);
+        shape.extra = shape.top < shape.window ? shape.rows[shape.top] : 0;
+    }
+    table.effects[t] = effect;
+    table.colors[t] = color;
+    for (int i = 0; i < 15 && name[i]; i++) table.names[t][i] = name[i];
+    if (weight == 0) return;
+    SpawnPool& pool = effect == EFFECT_NONE ? table.normal : table.special;
+    pool.types[pool.count] = (uint8_t)t;
+    pool.totals[pool.count] = (pool.count ? pool.totals[pool.count - 1] : 0) + weight;
+    pool.count++;
+}
+
+constexpr PieceTable buildPieceTable()
+{
+    PieceTable table = {};
+    const PieceEffect effects[kPieceTypes] = { EFFECT_NONE, EFFECT_NONE, EFFECT_NONE, EFFECT_NONE, EFFECT_NONE, EFFECT_NONE,
+                                               EFFECT_NONE, EFFECT_FROZEN, EFFECT_ELECTRICAL, EFFECT_FIRE, EFFECT_GHOST };
+    for (int t = 0; t < kPieceTypes; t++)
+        addPiece(table, kTetrominoes[t], 4, kTetrominoNames[t], kTetrominoColors[t], effects[t], 1);
+    return table;
+}
+
+constexpr PieceTable kBuiltinPieces = buildPieceTable();
+
+// The set in play: the built-in one unless another was loaded at startup.
+// Every fit test reads it, so it is a plain table rather than something
+// each game points to; the same code runs for built-in and loaded pieces.
+inline PieceTable pieceTable = kBuiltinPieces;
+
+inline int bitCount(uint64_t v)
+{
+    return __builtin_popcountll(v);
+}
+
+inline int lowestBit(uint64_t v)
+{
+    return __builtin_ctzll(v);
+}
+
+inline const PieceShape& pieceShape(int type, int rotation)
+{
+    return pieceTable.shapes[type][rotation & 3];
+}
+
+inline bool pieceHasBlock(int type, int rotation, int px, int py)
+{
+    return (pieceTable.shapes[type][rotation & 3].rows[py] >> px) & 1;
+}
+
+inline PieceEffect pieceEffect(int type)
+{
+    return pieceTable.effects[type];
+}
+
+inline const char* pieceName(int type)
+{
+    return pieceTable.names[type];
+}
+
+// HUD name of a special piece, null for the normal ones
+inline const char* specialPieceName(int type)
+{
+    return pieceTable.effects[type] != EFFECT_NONE ? pieceTable.names[type] : nullptr;
+}
+
+template <int W, int H>
+struct FixedBoard {
+    static_assert(W >= 4 && W + 2 * kBoardPad <= 64, "board too wide for a row mask");
+    static_assert(H >= 4 && H <= kMaxBoardHeight, "board height out of range");
+    typedef typename std::conditional<W + 2 * kBoardPad <= 32, uint32_t, uint64_t>::type Row;
+
+    static constexpr int width() { return W; }
+    static constexpr int height() { return H; }
+    static constexpr Row fieldMask() { return (Row)(((Row(1) << W) - 1) << kBoardPad); }
+    static constexpr Row emptyRow() { return (Row)~fieldMask(); }
+    static constexpr Row fullRow() { return (Row)~Row(0); }
+
+    Row* rowData() { return rows; }
+    const Row* rowData() const { return rows; }
+    uint8_t* cellData() { return cells; }
+    const uint8_t* cellData() const { return cells; }
+
+    Row rows[H + 2 * kBoardPad];
+    uint8_t cells[W * H];
+};
+
+// Same layout as FixedBoard, sized at run time
+struct DynamicBoard {
+    typedef uint64_t Row;
+
+    explicit DynamicBoard(int w = 10, int h = 20)
+        : w(w), h(h), rows(h + 2 * kBoardPad), cells(w * h) {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+    Row fieldMask() const { return ((Row(1) << w) - 1) << kBoardPad; }
+    Row emptyRow() const { return ~fieldMask(); }
+    Row fullRow() const { return ~Row(0); }
+
+    Row* rowData() { return rows.data(); }
+    const Row* rowData() const { return rows.data(); }
+    uint8_t* cellData() { return cells.data(); }
+    const uint8_t* cellData() const { return cells.data(); }
+
+    int w;
+    int h;
+    std::vector<Row> rows;
+    std::vector<uint8_t> cells;
+};
+
+// Rule sets. specials() is a compile-time constant for the fixed ones, so the
+// special-piece code is compiled out of classic mode entirely.
+struct ClassicRules {
+    static constexpr bool specials() { return false; }
+};
+
+struct SpecialRules {
+    static constexpr bool specials() { return true; }
+};
+
+struct DynamicRules {
+    bool enabled = true;
+    bool specials() const { return enabled; }
+};
+
+struct GameStatus {
+    Piece piece = { 0, 0, 0, 0 };
+    int score = 0;
+    int linesCleared = 0;
+    int level = 1;
+    bool frozen = false;
+    float freezeTimer = 0.0f;
+    bool gameOver = false;
+    int ticks = 0; // fixed ticks the last step() ran
+
+    static const int kMaxEvents = 64;
+    GameEvent events[kMaxEvents];
+    int eventCount = 0;
+};
+
+// Type-erased interface used by the front ends
+class GameCore {
+public:
+    virtual ~GameCore() {}
+
+    virtual void reset(uint32_t seed) = 0;
+    // Advances the game by dt seconds with the given buttons held
+    virtual void step(uint8_t input, float dt) = 0;
+    // Moves the current piece to rotation/x, drops and locks it
+    virtual bool place(int rotation, int x) = 0;
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    // 0 when empty, otherwise piece type + 1
+    virtual int cell(int x, int y) const = 0;
+    virtual bool fits(int type, int rotation, int x, int y) const = 0;
+    virtual int ghostY() const = 0;
+
+    GameStatus status;
+    // After a special clear, floating groups fall and the lines they complete
+    // chain until the board is stable
+    bool cascade = false;
+    // Fall speed in 1/kGravityUnit rows per tick, 0 to follow the level
+    int32_t gravity = 0;
+    // Ticks a piece rests on the stack before it locks (0 locks as it
+    // lands), and how many moves or rotations per piece start that wait over.
+    // Reaching a new lowest row gives the resets back.
+    int lockDelay = kLockDelay;
+    int lockResets = kLockResets;
+};
+
+template <class Board, class Rules>
+class TetrisGame final : public GameCore {
+public:
+    typedef typename Board::Row Row;
+
+    static constexpr float kFreezeDuration = 3.0f; // seconds
+    static constexpr int kMoveDelay = 8;           // ticks between repeated moves
+    static constexpr int kMaxTicksPerStep = kTicksPerSecond / 4;
+
+    explicit TetrisGame(const Board& board = Board(), const Rules& rules = Rules())
+        : board(board), rules(rules) {
+        reset(1);
+    }
+
+    void reset(uint32_t seed) override {
+        Row* rows = board.rowData();
+        for (int y = 0; y < board.height() + 2 * kBoardPad; y++)
+            rows[y] = (y < kBoardPad || y >= board.height() + kBoardPad) ? board.fullRow() : board.emptyRow();
+        std::memset(board.cellData(), 0, board.width() * board.height());
+        columnsStale = true;
+
+        status = GameStatus();
+        rng = seed ? seed : 0x9E3779B9u;
+        pendingTime = 0;
+        moveTicks = 0;
+        heldInput = 0;
+        pressedInput = 0;
+        pieceCounter = 0;
+        spawn(pieceTable.normal.pick(nextRandom()));
+    }
+
+    void step(uint8_t input, float dt) override {
+        status.eventCount = 0;
+        status.ticks = 0;
+        if (status.gameOver) return;
+
+        // Rotation and hard drop react to the press, not to holding the key.
+        // A press waits for the next tick, so one between two ticks at a high
+        // frame rate still counts. After a stall only a quarter second of
+        // ticks is played, not all of them in one frame.
+        pressedInput |= input & ~heldInput;
+        heldInput = input;
+        pendingTime = std::min(pendingTime + (int64_t)std::llround((double)dt * kTicksPerSecond * kTickTime),
+                               kTickTime * kMaxTicksPerStep);
+        for (; pendingTime >= kTickTime && !status.gameOver; pendingTime -= kTickTime) {
+            tick(input, pressedInput);
+            pressedInput = 0;
+            status.ticks++;
+        }
+    }
+
+    bool place(int rotation, int x) override {
+        status.eventCount = 0;
+        status.ticks = 0;
+        Piece& p = status.piece;
+        const PieceShape& shape = pieceShape(p.type, rotation);
+        if (status.gameOver || x + shape.left < 0 || x + shape.right >= board.width() || !fits(p.type, rotation, x, p.y)) return false;
+        p.rotation = rotation;
+        p.x = x;
+        p.y = dropY(p.type, rotation, x, p.y);
+        lock();
+        return true;
+    }
+
+    int width() const override { return board.width(); }
+    int height() const override { return board.height(); }
+
+    int cell(int x, int y) const override {
+        return board.cellData()[y * board.width() + x];
+    }
+
+    // y is at most one row below a position that fits, so the rows read
+    // (see PieceShape) never go past the padding under the field
+    bool fits(int type, int rotation, int x, int y) const override {
+        const PieceShape& shape = pieceShape(type, rotation);
+        const Row* rows = board.rowData() + kBoardPad + y;
+        const Row* window = rows + shape.window;
+        const uint8_t* mask = shape.rows + shape.window;
+        int shift = x + kBoardPad;
+        Row hit = (window[0] & ((Row)mask[0] << shift)) | (window[1] & ((Row)mask[1] << shift)) |
+                  (window[2] & ((Row)mask[2] << shift)) | (window[3] & ((Row)mask[3] << shift)) |
+                  (rows[shape.top] & ((Row)shape.extra << shift));
+        return hit == 0;
+    }
+
+    // Row where a piece that fits at y comes to rest, computed from the
+    // occupied rows of each board column instead of probing row by row: the
+    // lowest block of every run of blocks in a piece column can fall until
+    // the first occupied row under it, and the piece falls the least of those.
+    int dropY(int type, int rotation, int x, int y) const {
+        if (columnsStale) buildColumns();
+        const PieceShape& shape = pieceShape(type, rotation);
+        int drop = kMaxBoardHeight;
+        for (int px = shape.left; px <= shape.right; px++) {
+            const uint64_t column = columns[x + px + kBoardPad];
+            for (int bits = shape.columns[px] & ~(shape.columns[px] >> 1); bits; bits &= bits - 1) {
+                int row = y + kBoardPad + lowestBit(bits);
+                drop = std::min(drop, lowestBit(column >> (row + 1)));
+            }
+        }
+        return y + drop;
+    }
+
+    int ghostY() const override {
+        const Piece& p = status.piece;
+        return dropY(p.type, p.rotation, p.x, p.y);
+    }
+
+    // Pushes the stack up and fills the bottom rows with garbage that has one
+    // hole at column hole. Blocks pushed off the top end the game; the falling
+    // piece is moved up out of the way when it can be.
+    void addGarbage(int lines, int hole) {
+        const int w = board.width();
+        const int h = board.height();
+        if (lines <= 0 || status.gameOver) return;
+        if (lines > h) lines = h;
+        Row* rows = board.rowData() + kBoardPad;
+        uint8_t* cells = board.cellData();
+
+        bool toppedOut = false;
+        for (int y = 0; y < lines; y++)
+            if (rows[y] & board.fieldMask()) toppedOut = true;
+        std::memmove(rows, rows + lines, (h - lines) * sizeof(Row));
+        std::memmove(cells, cells + lines * w, (h - lines) * w);
+        Row garbage = board.fullRow() & ~((Row)1 << (hole + kBoardPad));
+        for (int y = h - lines; y < h; y++) {
+            rows[y] = garbage;
+            std::memset(cells + y * w, kGarbageCell, w);
+            cells[y * w + hole] = 0;
+        }
+        columnsStale = true;
+        addEvent(EVENT_GARBAGE, hole, lines);
+
+        Piece& p = status.piece;
+        for (int i = 0; i < lines && !fits(p.type, p.rotation, p.x, p.y) && p.y > -kBoardPad; i++) {
+            p.y--;
+            lowestY--;
+        }
+        if (toppedOut || !fits(p.type, p.rotation, p.x, p.y)) {
+            status.gameOver = true;
+            addEvent(EVENT_GAME_OVER, -1, -1);
+        }
+        landingY = dropY(p.type, p.rotation, p.x, p.y);
+    }
+
+    // Writes one cell, keeping the row mask in sync (for tests and benchmarks)
+    void setCell(int x, int y, int value) {
+        Row bit = (Row)1 << (x + kBoardPad);
+        Row& row = board.rowData()[y + kBoardPad];
+        row = value ? (row | bit) : (row & ~bit);
+        board.cellData()[y * board.width() + x] = (uint8_t)value;
+        columnsStale = true;
+    }
+
+    // Lets floating groups fall and clears the lines they complete, repeating
+    // until nothing moves. Every fall is one chain step (EVENT_CASCADE), and
+    // lines cleared at step n score 100 * (n + 1) each. Returns the steps taken.
+    int runCascade() {
+        Row* rows = board.rowData() + kBoardPad;
+        int chain = 0;
+        for (;;) {
+            int moved = settle();
+            if (!moved) break;
+            chain++;
+            addEvent(EVENT_CASCADE, chain, moved);
+
+            // Going down, a removed row pulls in one that was already checked
+            int lines = 0;
+            for (int y = 0; y < board.height(); y++) {
+                if (rows[y] == board.fullRow()) {
+                    addEvent(EVENT_LINE, -1, y);
+                    removeRow(y);
+                    lines++;
+                }
+            }
+            if (!lines) break;
+            addLines(lines, lines * 100 * (chain + 1));
+        }
+        return chain;
+    }
+
+    // Drops every 4-connected group of blocks as a rigid body until it rests
+    // on the floor or on another block. Groups are found with a flood fill on
+    // the row masks, lowest first; a group that lands on one above it in the
+    // same pass is picked up by the next pass. Returns the number of cells moved.
+    int settle() {
+        const int h = board.height();
+        const Row field = board.fieldMask();
+        Row* rows = board.rowData() + kBoardPad;
+        Row remaining[kMaxBoardHeight];
+        Row group[kMaxBoardHeight + 2] = {}; // one spare row on each side
+        Row* g = group + 1;
+        int moved = 0;
+
+        for (bool again = true; again;) {
+            again = false;
+            for (int y = 0; y < h; y++) remaining[y] = rows[y] & field;
+
+            for (int y = h - 1; y >= 0; y--) {
+                while (remaining[y]) {
+                    int top = y;
+                    int bottom = y;
+                    g[y] = fillRow(remaining[y] & (~remaining[y] + 1), remaining[y]);
+                    floodFill(remaining, g, top, bottom);
+
+                    for (int r = top; r <= bottom; r++) {
+                        remaining[r] &= ~g[r];
+                        rows[r] &= ~g[r];
+                    }
+                    int d = 0;
+                    for (bool clear = true; clear;) {
+                        for (int r = top; r <= bottom && clear; r++)
+                            clear = (g[r] & rows[r + d + 1]) == 0;
+                        if (clear) d++;
+                    }
+                    if (d > 0) {
+                        moved += moveGroup(g, top, bottom, d);
+                        again = true;
+                    } else {
+                        for (int r = top; r <= bottom; r++) rows[r] |= g[r];
+                    }
+                    for (int r = top; r <= bottom; r++) g[r] = 0;
+                }
+            }
+        }
+        return moved;
+    }
+
+    // To be called after writing board rows directly rather than through
+    // the methods here, before the next drop
+    void boardChanged() {
+        columnsStale = true;
+    }
+
+    Board board;
+    Rules rules;
+
+private:
+    // Bit r of columns[x + kBoardPad] is set when padded row r of column x
+    // is occupied, the padding above and below the field included. Rebuilt
+    // from the row masks on the first drop after the board changes.
+    void buildColumns() const {
+        const Row* rows = board.rowData() + kBoardPad;
+        const int h = board.height();
+        const uint64_t padding = ((uint64_t(1) << kBoardPad) - 1) | (((uint64_t(1) << kBoardPad) - 1) << (h + kBoardPad));
+        for (int x = 0; x < board.width(); x++) columns[x + kBoardPad] = padding;
+        for (int y = 0; y < h; y++)
+            for (Row bits = rows[y] & board.fieldMask(); bits; bits &= bits - 1)
+                columns[lowestBit(bits)] |= uint64_t(1) << (y + kBoardPad);
+        columnsStale = false;
+    }
+
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    void addEvent(GameEventType type, int x, int y) {
+        if (status.eventCount < GameStatus::kMaxEvents)
+            status.events[status.eventCount++] = { type, (int16_t)x, (int16_t)y };
+    }
+
+    void spawn(int type) {
+        status.piece = { type, 0, board.width() / 2 - 2, 0 };
+        landingY = dropY(type, 0, status.piece.x, 0);
+        lowestY = 0;
+        fallen = 0;
+        lockTicks = 0;
+        lockResetsUsed = 0;
+    }
+
+    void clearCell(int x, int y) {
+        board.rowData()[y + kBoardPad] &= ~((Row)1 << (x + kBoardPad));
+        board.cellData()[y * board.width() + x] = 0;
+        columnsStale = true;
+    }
+
+    void clearRow(int y) {
+        board.rowData()[y + kBoardPad] = board.emptyRow();
+        std::memset(board.cellData() + y * board.width(), 0, board.width());
+        columnsStale = true;
+    }
+
+    // Spreads seed bits sideways through the runs of mask they sit in
+    static Row fillRow(Row seed, Row mask) {
+        for (;;) {
+            Row next = (seed | (Row)(seed << 1) | (Row)(seed >> 1)) & mask;
+            if (next == seed) return seed;
+            seed = next;
+        }
+    }
+
+    // Grows the group g over the blocks in remaining, sweeping down and up
+    // until it stops changing; top and bottom track the rows it spans
+    void floodFill(const Row* remaining, Row* g, int& top, int& bottom) const {
+        const int h = board.height();
+        auto grow = [&](int y) {
+            // g[y] always holds whole runs, so no new seed bits means no growth
+            Row seed = (g[y] | g[y - 1] | g[y + 1]) & remaining[y];
+            if (seed == g[y]) return false;
+            g[y] = fillRow(seed, remaining[y]);
+            if (y < top) top = y;
+            if (y > bottom) bottom = y;
+            return true;
+        };
+        for (bool grew = true; grew;) {
+            grew = false;
+            for (int y = top > 0 ? top - 1 : 0; y <= bottom + 1 && y < h; y++) grew |= grow(y);
+            for (int y = bottom; y >= 0 && y >= top - 1; y--) grew |= grow(y);
+        }
+    }
+
+    // Moves group g down by d rows, bottom row first so it never overwrites
+    // itself. Returns the number of cells moved.
+    int moveGroup(const Row* g, int top, int bottom, int d) {
+        Row* rows = board.rowData() + kBoardPad;
+        uint8_t* cells = board.cellData();
+        const int w = board.width();
+        int count = 0;
+        for (int y = bottom; y >= top; y--) {
+            rows[y + d] |= g[y];
+            for (Row bits = g[y]; bits; bits &= bits - 1) {
+                int x = lowestBit(bits) - kBoardPad;
+                cells[(y + d) * w + x] = cells[y * w + x];
+                cells[y * w + x] = 0;
+                count++;
+            }
+        }
+        columnsStale = true;
+        return count;
+    }
+
+    // Removes row y and moves everything above it down one row
+    void removeRow(int y) {
+        Row* rows = board.rowData() + kBoardPad;
+        std::memmove(rows + 1, rows, y * sizeof(Row));
+        rows[0] = board.emptyRow();
+        uint8_t* cells = board.cellData();
+        std::memmove(cells + board.width(), cells, y * board.width());
+        std::memset(cells, 0, board.width());
+        columnsStale = true;
+    }
+
+    // One tick (1 / kTicksPerSecond) with the buttons held and those pressed since the
+    // tick before
+    void tick(uint8_t input, uint8_t pressed) {
+        Piece& p = status.piece;
+        moveTicks++;
+
+        if (status.frozen) {
+            status.freezeTimer -= 1.0f / kTicksPerSecond;
+            if (status.freezeTimer <= 0) status.frozen = false;
+        }
+        if (status.frozen) return;
+
+        const bool grounded = p.y == landingY;
+        bool moved = false;
+        if (moveTicks >= kMoveDelay && (input & (INPUT_LEFT | INPUT_RIGHT))) {
+            int dx = (input & INPUT_LEFT) ? -1 : 1;
+            if (fits(p.type, p.rotation, p.x + dx, p.y)) {
+                p.x += dx;
+                moved = true;
+            }
+            moveTicks = 0;
+        }
+        if ((pressed & INPUT_ROTATE) && fits(p.type, p.rotation + 1, p.x, p.y)) {
+            p.rotation += 1;
+            moved = true;
+        }
+        if (moved) {
+            landingY = dropY(p.type, p.rotation, p.x, p.y);
+            if (grounded && lockResetsUsed < lockResets) {
+                lockResetsUsed++;
+                lockTicks = 0;
+            }
+        }
+
+        if (pressed & INPUT_HARD_DROP) {
+            p.y = landingY;
+            lock();
+            return;
+        }
+
+        // Gravity moves the piece by all the whole rows it has built up at
+        // once, but not past where it lands. Soft drop falls at least a row
+        // every tick.
+        int32_t rate = gravity ? gravity : gravityForLevel(status.level);
+        if ((input & INPUT_SOFT_DROP) && rate < kGravityUnit) rate = kGravityUnit;
+        fallen += rate;
+        p.y = std::min(p.y + fallen / kGravityUnit, landingY);
+        fallen = p.y == landingY ? 0 : fallen % kGravityUnit;
+        if (p.y > lowestY) {
+            lowestY = p.y;
+            lockTicks = 0;
+            lockResetsUsed = 0;
+        }
+        // lockDelay ticks after the one it landed on; 0 locks on landing
+        if (p.y == landingY && ++lockTicks > lockDelay) lock();
+    }
+
+    void lock() {
+        Piece& p = status.piece;
+        Row* rows = board.rowData() + kBoardPad;
+        uint8_t* cells = board.cellData();
+        const PieceShape& shape = pieceShape(p.type, p.rotation);
+        for (int py = shape.top; py <= shape.bottom; py++) {
+            int bits = shape.rows[py];
+            rows[p.y + py] |= (Row)bits << (p.x + kBoardPad);
+            for (; bits; bits &= bits - 1) cells[(p.y + py) * board.width() + p.x + lowestBit(bits)] = (uint8_t)(p.type + 1);
+        }
+        columnsStale = true;
+        addEvent(EVENT_LOCK, p.x, p.y);
+
+        bool specialCleared = false;
+        if (rules.specials() && pieceEffect(p.type) != EFFECT_NONE) specialCleared = applySpecial();
+
+        // Check lines. Rows without blocks of the piece cannot have filled up.
+        for (int py = shape.top; py <= shape.bottom; py++) {
+            int y = p.y + py;
+            if (y >= 0 && y < board.height() && rows[y] == board.fullRow()) {
+                addEvent(EVENT_LINE, -1, y);
+                removeRow(y);
+                addLines(1, 100);
+            }
+        }
+
+        if (cascade && specialCleared) runCascade();
+
+        // Next piece
+        pieceCounter++;
+        if (rules.specials() && pieceCounter % 3 == 0 && pieceTable.special.count)
+            spawn(pieceTable.special.pick(nextRandom()));
+        else
+            spawn(pieceTable.normal.pick(nextRandom()));
+
+        if (!fits(p.type, p.rotation, p.x, p.y)) {
+            status.gameOver = true;
+            addEvent(EVENT_GAME_OVER, -1, -1);
+        }
+    }
+
+    void addLines(int lines, int points) {
+        status.score += points;
+        status.linesCleared += lines;
+        status.level = status.linesCleared / 10 + 1;
+    }
+
+    // Returns true when blocks were removed from the board
+    bool applySpecial() {
+        const Piece& p = status.piece;
+        const uint8_t* cells = board.cellData();
+        bool cleared = false;
+        switch (pieceEffect(p.type)) {
+        case EFFECT_FROZEN:
+            status.frozen = true;
+            status.freezeTimer = kFreezeDuration;
+            addEvent(EVENT_FROZEN, p.x, p.y);
+            break;
+        case EFFECT_ELECTRICAL: // Clear two rows where the piece landed
+            for (int y = p.y; y >= p.y - 1; y--) {
+                if (y >= 0 && y < board.height()) {
+                    clearRow(y);
+                    status.score += 100;
+                    addEvent(EVENT_ELECTRICAL, -1, y);
+                    cleared = true;
+                }
+            }
+            break;
+        case EFFECT_FIRE: { // Explode blocks around the piece
+            int blocksCleared = 0;
+            for (int ex = -2; ex <= 2; ex++) {
+                for (int ey = -2; ey <= 2; ey++) {
+                    int nx = p.x + ex;
+                    int ny = p.y + ey;
+                    if (nx >= 0 && nx < board.width() && ny >= 0 && ny < board.height() && cells[ny * board.width() + nx] != 0) {
+                        clearCell(nx, ny);
+                        blocksCleared++;
+                        addEvent(EVENT_FIRE, nx, ny);
+                    }
+                }
+            }
+            status.score += blocksCleared * 10;
+            cleared = blocksCleared > 0;
+            break;
+        }
+        default:
+            break;
+        }
+        return cleared;
+    }
+
+    uint32_t rng = 1;
+    int64_t pendingTime = 0; // frame time not played as a tick yet
+    int moveTicks = 0;      // since the last sideways move
+    uint8_t heldInput = 0;
+    uint8_t pressedInput = 0;
+    int landingY = 0;       // where the current piece comes to rest
+    int lowestY = 0;        // lowest row it has reached
+    int32_t fallen = 0;     // part of a row gravity has built up, in 1/kGravityUnit
+    int lockTicks = 0;      // ticks resting on the stack
+    int lockResetsUsed = 0;
+    int pieceCounter = 0;
+    mutable uint64_t columns[64];     // see buildColumns()
+    mutable bool columnsStale = true; // the board changed since they were built
+};
+
+// Board sizes and rule sets selectable at run time. Each entry is its own
+// template instantiation.
+struct GameVariant {
+    const char* name;
+    const char* description;
+    std::unique_ptr<GameCore> (*create)();
+};
+
+template <int W, int H, class Rules>
+std::unique_ptr<GameCore> createGame()
+{
+    return std::unique_ptr<GameCore>(new TetrisGame<FixedBoard<W, H>, Rules>());
+}
+
+inline const GameVariant gameVariants[] = {
+    { "standard", "10x20 with special pieces", createGame<10, 20, SpecialRules> },
+    { "wide", "16x20 with special pieces", createGame<16, 20, SpecialRules> },
+    { "tall", "10x40 with special pieces", createGame<10, 40, SpecialRules> },
+    { "classic", "10x20 without special pieces", createGame<10, 20, ClassicRules> },
+};
+
+inline const GameVariant* findGameVariant(const char* name)
+{
+    for (const auto& v : gameVariants)
+        if (std::strcmp(v.name, name) == 0) return &v;
+    return nullptr;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hashed timing wheel with 1 ms slots, for periodic work on many small
+// objects (one tick per game session). Entries are integer ids chosen by the
+// caller; they are linked through arrays kept here, so scheduling, cancelling
+// and expiring are O(1) per entry and never allocate once the id range is
+// known. A deadline can be at most kSlots - 1 ms ahead.
+class TimerWheel {
+public:
+    static const int kSlots = 256; // power of two
+
+    explicit TimerWheel(int64_t nowMs = 0)
+        : currentMs(nowMs), heads(kSlots, -1) {}
+
+    // Schedules id at atMs. Deadlines in the past fire on the next expire();
+    // ones beyond the wheel are clamped to its far end.
+    void schedule(int id, int64_t atMs) {
+        grow(id);
+        cancel(id);
+        if (atMs <= currentMs) atMs = currentMs + 1;
+        if (atMs > currentMs + kSlots - 1) atMs = currentMs + kSlots - 1;
+        int slot = (int)(atMs & (kSlots - 1));
+        next[id] = heads[slot];
+        prev[id] = -1;
+        if (heads[slot] >= 0) prev[heads[slot]] = id;
+        heads[slot] = id;
+        slotOf[id] = slot;
+        count++;
+    }
+
+    void cancel(int id) {
+        if (id >= (int)slotOf.size() || slotOf[id] < 0) return;
+        if (prev[id] >= 0) next[prev[id]] = next[id];
+        else heads[slotOf[id]] = next[id];
+        if (next[id] >= 0) prev[next[id]] = prev[id];
+        slotOf[id] = -1;
+        count--;
+    }
+
+    // Calls fire(id) for every entry due up to nowMs, oldest slot first.
+    // fire may schedule again; that lands in a later slot.
+    template <class Fire>
+    void expire(int64_t nowMs, Fire fire) {
+        while (currentMs < nowMs) {
+            currentMs++;
+            int slot = (int)(currentMs & (kSlots - 1));
+            // One at a time, so fire() may also cancel other entries
+            while (heads[slot] >= 0) {
+                int id = heads[slot];
+                cancel(id);
+                fire(id);
+            }
+            if (count == 0 && currentMs < nowMs) currentMs = nowMs; // nothing left, jump ahead
+        }
+    }
+
+    // Milliseconds from the last expire() to the next non-empty slot, -1 when
+    // the wheel is empty
+    int nextDelay() const {
+        if (count == 0) return -1;
+        for (int d = 1; d < kSlots; d++)
+            if (heads[(currentMs + d) & (kSlots - 1)] >= 0) return d;
+        return -1;
+    }
+
+    int64_t now() const {
+        return currentMs;
+    }
+
+    int size() const {
+        return count;
+    }
+
+private:
+    void grow(int id) {
+        if (id < (int)slotOf.size()) return;
+        std::size_t n = id + 1 > (int)slotOf.size() * 2 ? id + 1 : slotOf.size() * 2;
+        next.resize(n, -1);
+        prev.resize(n, -1);
+        slotOf.resize(n, -1);
+    }
+
+    int64_t currentMs;
+    int count = 0;
+    std::vector<int> heads;
+    std::vector<int> next;
+    std::vector<int> prev;
+    std::vector<int> slotOf;
+};
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "TronCore.hpp"
+
+// Tron bot. While the bot shares space with an opponent it runs an alpha-beta
+// search against the nearest one, scoring positions by Voronoi territory:
+// cells it reaches before every other cycle minus cells the others reach
+// first. Once its region is cut off from everyone else it switches to
+// filling that region, scoring by reachable area. Either way the search
+// deepens one round at a time until the per-tick time budget runs out and
+// plays the best move of the deepest finished round.
+//
+// Both evaluations work on bitsets laid out like TronGrid, 64 cells per word.
+// Voronoi is a breadth-first race: one step shifts whole words to advance
+// both frontiers by a ring of cells, skipping rows with no frontier nearby.
+// The area only needs a flood fill, which fills whole runs of a row at once.
+
+struct TronBotStats {
+    uint64_t nodes = 0;
+    int depth = 0;        // deepest fully searched round
+    double seconds = 0.0;
+    bool separated = false;
+};
+
+class TronBot {
+public:
+    explicit TronBot(int budgetMicros = 5000) : budgetMicros(budgetMicros) {}
+
+    int budgetMicros;
+    TronBotStats last;      // the last choose()
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0.0;
+    uint64_t decisions = 0;
+    uint64_t totalDepth = 0;
+
+    // Best direction for a living player
+    uint8_t choose(const TronGame& game, int player) {
+        auto start = std::chrono::steady_clock::now();
+        deadline = start + std::chrono::microseconds(budgetMicros);
+        prepare(game, player);
+        last = TronBotStats();
+        nodes = 0;
+
+        const TronPlayer& me = game.players[player];
+        uint8_t best = me.dir;
+        // A move that is not instantly fatal, in case not even depth 1 finishes
+        for (uint8_t d = 0; d < 4; d++) {
+            int x, y;
+            if (d != (me.dir ^ 2) && target(me.x, me.y, d, x, y) && !occupied(x, y)) {
+                best = d;
+                if (d == me.dir) break;
+            }
+        }
+
+        last.separated = opponent < 0 || isSeparated();
+        searching = true;
+        for (int depth = 1; depth <= kMaxDepth; depth++) {
+            aborted = false;
+            uint8_t move = best;
+            int score = last.separated ? rootSurvival(depth, move) : rootVersus(depth, move);
+            if (aborted) break;
+            best = move;
+            last.depth = depth;
+            if (score >= kWin - 1000 || score <= -kWin + 1000) break; // the outcome is decided
+        }
+        searching = false;
+
+        last.nodes = nodes;
+        last.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += nodes;
+        totalSeconds += last.seconds;
+        totalDepth += last.depth;
+        decisions++;
+        return best;
+    }
+
+    // Voronoi score of a position: cells the first head reaches strictly
+    // before the others minus the reverse. Exposed for the benchmark.
+    int voronoi(const TronGame& game, int player) {
+        prepare(game, player);
+        return evaluate();
+    }
+
+    // Free cells the player can still reach. Exposed for the benchmark.
+    int area(const TronGame& game, int player) {
+        prepare(game, player);
+        return reachable();
+    }
+
+private:
+    static const int kWin = 1 << 24;
+    static const int kMaxDepth = 64;
+
+    struct Head {
+        int x, y;
+        uint8_t dir;
+    };
+
+    // Copies the arena into the bot's own layout and picks the nearest
+    // living opponent. Rows get at least one spare bit on the right and
+    // there is a spare row above and below, so the expansion needs no edge
+    // cases: spare bits are walls, spare rows are empty (or, with wrap,
+    // copies of the opposite edge row).
+    void prepare(const TronGame& game, int player) {
+        width = game.width();
+        height = game.height();
+        words = width / 64 + 1;
+        wrap = game.wrap;
+        topBit = (width - 1) & 63;
+        lastWord = (width - 1) >> 6;
+        size_t n = (size_t)(height + 2) * words;
+        grid.assign(n, 0);
+        // Bits from the width on are the spare ones
+        const uint64_t spare = width & 63 ? ~(uint64_t)0 << (width & 63) : ~(uint64_t)0;
+        for (int y = 0; y < height; y++) {
+            uint64_t* row = &grid[(size_t)(y + 1) * words];
+            const uint64_t* from = game.grid.row(y);
+            for (int w = 0; w < game.grid.wordsPerRow; w++) row[w] = from[w];
+            row[words - 1] |= spare;
+        }
+        mine.assign(n, 0);
+        theirs.assign(n, 0);
+        seen.assign(n, 0);
+        nextMine.assign(n, 0);
+        nextTheirs.assign(n, 0);
+        ownMine.assign(n, 0);
+        ownTheirs.assign(n, 0);
+        live.assign(height + 2, 0);
+        grewAt.assign(height + 2, -2);
+        nextLive.assign(height + 2, 0);
+
+        const TronPlayer& me = game.players[player];
+        self = { me.x, me.y, me.dir };
+        others.clear();
+        opponent = -1;
+        int nearest = 1 << 30;
+        for (int i = 0; i < (int)game.players.size(); i++) {
+            const TronPlayer& p = game.players[i];
+            if (i == player || !p.alive) continue;
+            int dx = std::abs(p.x - me.x), dy = std::abs(p.y - me.y);
+            if (wrap) {
+                dx = std::min(dx, width - dx);
+                dy = std::min(dy, height - dy);
+            }
+            if (dx + dy < nearest) {
+                nearest = dx + dy;
+                opponent = (int)others.size();
+            }
+            others.push_back({ p.x, p.y, p.dir });
+        }
+    }
+
+    bool target(int x, int y, uint8_t d, int& nx, int& ny) const {
+        nx = x + tronDx[d];
+        ny = y + tronDy[d];
+        if (wrap) {
+            nx = nx < 0 ? width - 1 : (nx >= width ? 0 : nx);
+            ny = ny < 0 ? height - 1 : (ny >= height ? 0 : ny);
+            return true;
+        }
+        return nx >= 0 && nx < width && ny >= 0 && ny < height;
+    }
+
+    size_t wordIndex(int x, int y) const { return (size_t)(y + 1) * words + (x >> 6); }
+    bool occupied(int x, int y) const { return grid[wordIndex(x, y)] >> (x & 63) & 1; }
+    void setCell(std::vector<uint64_t>& bits, int x, int y) { bits[wordIndex(x, y)] |= (uint64_t)1 << (x & 63); }
+    void clearCell(std::vector<uint64_t>& bits, int x, int y) { bits[wordIndex(x, y)] &= ~((uint64_t)1 << (x & 63)); }
+
+    // Checked at every node: reading the clock costs far less than one
+    // evaluation, which can take a while in a winding region
+    bool outOfTime() {
+        if (!aborted && std::chrono::steady_clock::now() >= deadline) aborted = true;
+        return aborted;
+    }
+
+    // Grows both frontiers in lockstep from the heads set in mine/theirs and
+    // counts the cells each reaches first. A cell reached by both in the same
+    // step belongs to no one and stops both.
+    void race(int& mineCount, int& theirCount) {
+        const int W = words;
+        const size_t begin = W, end = (size_t)(height + 1) * W;
+        for (size_t i = begin; i < end; i++) {
+            seen[i] = grid[i] | mine[i] | theirs[i];
+            ownMine[i] = ownTheirs[i] = 0;
+        }
+        // live[r]: row r holds part of a frontier. A row is only expanded
+        // when it or a neighbouring row is live, so the cost of a step
+        // follows the frontier rather than the arena.
+        std::fill(nextMine.begin(), nextMine.end(), 0);
+        std::fill(nextTheirs.begin(), nextTheirs.end(), 0);
+        std::fill(nextLive.begin(), nextLive.end(), 0);
+        for (int r = 1; r <= height; r++) {
+            uint64_t bits = 0;
+            for (size_t i = (size_t)r * W; i < (size_t)(r + 1) * W; i++) bits |= mine[i] | theirs[i];
+            live[r] = bits != 0;
+        }
+        live[0] = live[height + 1] = 0;
+        bool any = true;
+        for (int step = 1; any; step++) {
+            any = false;
+            // A winding region can take thousands of steps; give up with the
+            // search when the time is out
+            if (searching && (step & 63) == 0 && outOfTime()) break;
+            if (wrap) {
+                for (int w = 0; w < W; w++) {
+                    mine[w] = mine[end - W + w];
+                    theirs[w] = theirs[end - W + w];
+                    mine[end + w] = mine[begin + w];
+                    theirs[end + w] = theirs[begin + w];
+                }
+                live[0] = live[height];
+                live[height + 1] = live[1];
+            }
+            for (int r = 1; r <= height; r++) {
+                const size_t row = (size_t)r * W;
+                if (!(live[r - 1] | live[r] | live[r + 1])) {
+                    if (nextLive[r]) {
+                        for (size_t i = row; i < row + W; i++) nextMine[i] = nextTheirs[i] = 0;
+                        nextLive[r] = 0;
+                    }
+                    continue;
+                }
+                // Neighbours of each frontier: one shift per direction per
+                // word. Bits crossing into the spare bits are masked below.
+                for (size_t i = row; i < row + W; i++) {
+                    uint64_t m = mine[i], t = theirs[i];
+                    nextMine[i] = (m << 1) | (m >> 1) | (mine[i - 1] >> 63) | (mine[i + 1] << 63) | mine[i - W] | mine[i + W];
+                    nextTheirs[i] = (t << 1) | (t >> 1) | (theirs[i - 1] >> 63) | (theirs[i + 1] << 63) | theirs[i - W] | theirs[i + W];
+                }
+                if (wrap) {
+                    nextMine[row] |= mine[row + lastWord] >> topBit & 1;
+                    nextTheirs[row] |= theirs[row + lastWord] >> topBit & 1;
+                    nextMine[row + lastWord] |= (mine[row] & 1) << topBit;
+                    nextTheirs[row + lastWord] |= (theirs[row] & 1) << topBit;
+                }
+                uint64_t rowBits = 0;
+                for (size_t i = row; i < row + W; i++) {
+                    uint64_t a = nextMine[i] & ~seen[i];
+                    uint64_t b = nextTheirs[i] & ~seen[i];
+                    uint64_t tie = a & b;
+                    seen[i] |= a | b;
+                    nextMine[i] = a & ~tie;
+                    nextTheirs[i] = b & ~tie;
+                    ownMine[i] |= a & ~tie;
+                    ownTheirs[i] |= b & ~tie;
+                    rowBits |= a | b;
+                }
+                nextLive[r] = rowBits != 0;
+                any |= rowBits != 0;
+            }
+            mine.swap(nextMine);
+            theirs.swap(nextTheirs);
+            live.swap(nextLive);
+        }
+        mineCount = 0;
+        theirCount = 0;
+        for (size_t i = begin; i < end; i++) {
+            mineCount += __builtin_popcountll(ownMine[i]);
+            theirCount += __builtin_popcountll(ownTheirs[i]);
+        }
+    }
+
+    // Territory difference for the current heads
+    int evaluate() {
+        std::fill(mine.begin(), mine.end(), 0);
+        std::fill(theirs.begin(), theirs.end(), 0);
+        setCell(mine, self.x, self.y);
+        for (const Head& h : others) setCell(theirs, h.x, h.y);
+        int a, b;
+        race(a, b);
+        return a - b;
+    }
+
+    // Free cells reachable from our head. Only the area counts here, not
+    // who gets where first, so instead of one ring per step every row is
+    // filled along whole runs of free cells at once (doubling shifts, six
+    // per direction per word) and then spread to the rows above and below.
+    // Sweeps alternate downwards and upwards and only revisit rows next to
+    // one that grew, so an open region fills in a handful of sweeps.
+    // Leaves the region in seen.
+    int reachable() {
+        const int W = words;
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(grewAt.begin(), grewAt.end(), -2);
+        for (uint8_t d = 0; d < 4; d++) {
+            int x, y;
+            if (target(self.x, self.y, d, x, y) && !occupied(x, y)) {
+                setCell(seen, x, y);
+                fillRow(&seen[(size_t)(y + 1) * W], &grid[(size_t)(y + 1) * W]);
+                grewAt[y + 1] = 0;
+            }
+        }
+        uint64_t* row = &mine[0]; // scratch for the row being filled
+        bool grew = true;
+        for (int sweep = 0; grew; sweep++) {
+            grew = false;
+            if (searching && outOfTime()) break;
+            for (int k = 0; k < height; k++) {
+                int r = sweep & 1 ? height - k : k + 1;
+                int up = r - 1, down = r + 1;
+                if (wrap) {
+                    up = up < 1 ? height : up;
+                    down = down > height ? 1 : down;
+                }
+                if (std::max(grewAt[up], std::max(grewAt[r], grewAt[down])) < sweep - 1) continue;
+                const uint64_t* wall = &grid[(size_t)r * W];
+                uint64_t* cur = &seen[(size_t)r * W];
+                const uint64_t *above = &seen[(size_t)up * W], *below = &seen[(size_t)down * W];
+                // Rows are kept filled along their runs, so nothing new
+                // from above or below means nothing new at all
+                uint64_t added = 0;
+                for (int i = 0; i < W; i++) {
+                    row[i] = (cur[i] | above[i] | below[i]) & ~wall[i];
+                    added |= row[i] & ~cur[i];
+                }
+                if (!added) continue;
+                fillRow(row, wall);
+                for (int i = 0; i < W; i++) cur[i] = row[i];
+                grewAt[r] = sweep;
+                grew = true;
+            }
+        }
+        int count = 0;
+        for (size_t i = words, end = (size_t)(height + 1) * words; i < end; i++) count += __builtin_popcountll(seen[i]);
+        return count;
+    }
+
+    // Extends the cells set in row along the free runs of the row: forwards
+    // then backwards across the words, then around the edge with wrap
+    void fillRow(uint64_t* row, const uint64_t* wall) const {
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < words; i++) {
+                if (i > 0) row[i] |= (row[i - 1] >> 63) & ~wall[i] & 1;
+                row[i] = fillRun(row[i], ~wall[i]);
+            }
+            for (int i = words - 2; i >= 0; i--) {
+                row[i] |= (row[i + 1] << 63) & ~wall[i];
+                row[i] = fillRun(row[i], ~wall[i]);
+            }
+            if (!wrap) return;
+            uint64_t first = row[0] & 1, last = row[lastWord] >> topBit & 1;
+            uint64_t toFirst = last & ~first & ~wall[0] & 1;
+            uint64_t toLast = first & ~last & ~(wall[lastWord] >> topBit) & 1;
+            if (!toFirst && !toLast) return;
+            row[0] |= toFirst;
+            row[lastWord] |= toLast << topBit;
+        }
+    }
+
+    // Bits of g spread to both sides through the set bits of free; g must
+    // be a subset of free
+    static uint64_t fillRun(uint64_t g, uint64_t free) {
+        uint64_t left = g, right = g, pl = free, pr = free;
+        for (int shift = 1; shift < 64; shift <<= 1) {
+            left |= pl & (left << shift);
+            right |= pr & (right >> shift);
+            pl &= pl << shift;
+            pr &= pr >> shift;
+        }
+        return left | right;
+    }
+
+    // True when no other cycle can ever get into our region
+    bool isSeparated() {
+        reachable(); // seen now holds our region
+        for (const Head& h : others) {
+            for (uint8_t d = 0; d < 4; d++) {
+                int x, y;
+                if (!target(h.x, h.y, d, x, y) || occupied(x, y)) continue;
+                if (seen[wordIndex(x, y)] >> (x & 63) & 1) return false;
+            }
+        }
+        return true;
+    }
+
+    // Alpha-beta over alternating plies: we move, then the nearest opponent.
+    // depth counts rounds (one move each).
+    int rootVersus(int depth, uint8_t& bestMove) {
+        uint8_t moves[3];
+        int count = moveOrder(bestMove, self.dir, moves);
+        int alpha = -kWin - 1, best = -kWin - 1;
+        for (int i = 0; i < count; i++) {
+            int score = myMove(moves[i], depth, 0, alpha, kWin + 1);
+            if (aborted) return best;
+            if (score > best) {
+                best = score;
+                bestMove = moves[i];
+            }
+            alpha = std::max(alpha, best);
+        }
+        return best;
+    }
+
+    // The three directions other than straight back, the given one first
+    static int moveOrder(uint8_t first, uint8_t dir, uint8_t* out) {
+        int count = 0;
+        if (first != (dir ^ 2)) out[count++] = first;
+        for (uint8_t d = 0; d < 4; d++) {
+            if (d != first && d != (dir ^ 2)) out[count++] = d;
+        }
+        return count;
+    }
+
+    int myMove(uint8_t d, int depth, int ply, int alpha, int beta) {
+        nodes++;
+        if (outOfTime()) return 0;
+        int x, y;
+        if (!target(self.x, self.y, d, x, y) || occupied(x, y)) return -kWin + ply;
+        Head saved = self;
+        self = { x, y, d };
+        setCell(grid, x, y);
+        int score = opponentReply(depth, ply + 1, alpha, beta);
+        clearCell(grid, x, y);
+        self = saved;
+        return score;
+    }
+
+    int opponentReply(int depth, int ply, int alpha, int beta) {
+        if (outOfTime()) return 0;
+        Head& op = others[opponent];
+        int best = kWin + 1;
+        bool any = false;
+        for (uint8_t d = 0; d < 4; d++) {
+            if (d == (op.dir ^ 2)) continue;
+            int x, y;
+            if (!target(op.x, op.y, d, x, y)) continue;
+            if (x == self.x && y == self.y) {
+                // Both would enter the same cell: both crash
+                best = std::min(best, 0);
+                any = true;
+                if (best <= alpha) return best;
+                continue;
+            }
+            if (occupied(x, y)) continue;
+            any = true;
+            nodes++;
+            Head saved = op;
+            op = { x, y, d };
+            setCell(grid, x, y);
+            int score;
+            if (depth <= 1) {
+                score = evaluate();
+            } else {
+                score = -kWin - 1;
+                int a = alpha;
+                for (uint8_t m = 0; m < 4; m++) {
+                    if (m == (self.dir ^ 2)) continue;
+                    score = std::max(score, myMove(m, depth - 1, ply + 1, a, std::min(beta, best)));
+                    a = std::max(a, score);
+                    if (aborted || score >= std::min(beta, best)) break;
+                }
+            }
+            clearCell(grid, x, y);
+            op = saved;
+            if (aborted) return 0;
+            best = std::min(best, score);
+            if (best <= alpha) return best;
+        }
+        if (!any) return kWin - ply; // the opponent has nowhere to go
+        return best;
+    }
+
+    // Alone in our region: the longest path we can still make, estimated by
+    // the area reachable after depth moves
+    int rootSurvival(int depth, uint8_t& bestMove) {
+        uint8_t moves[3];
+        int count = moveOrder(bestMove, self.dir, moves);
+        int best = -kWin - 1;
+        for (int i = 0; i < count; i++) {
+            int score = survive(moves[i], depth, 0);
+            if (aborted) return best;
+            if (score > best) {
+                best = score;
+                bestMove = moves[i];
+            }
+        }
+        return best;
+    }
+
+    int survive(uint8_t d, int depth, int ply) {
+        nodes++;
+        int x, y;
+        if (!target(self.x, self.y, d, x, y) || occupied(x, y)) return -kWin + ply;
+        if (outOfTime()) return 0;
+        Head saved = self;
+        self = { x, y, d };
+        setCell(grid, x, y);
+        int score = -kWin - 1;
+        if (depth <= 1) {
+            score = ply + 1 + reachable();
+        } else {
+            for (uint8_t m = 0; m < 4 && !aborted; m++) {
+                if (m == (d ^ 2)) continue;
+                score = std::max(score, survive(m, depth - 1, ply + 1));
+            }
+        }
+        clearCell(grid, x, y);
+        self = saved;
+        return score;
+    }
+
+    int width = 0, height = 0, words = 0, lastWord = 0, topBit = 0;
+    bool wrap = true;
+    std::vector<uint64_t> grid, mine, theirs, seen, nextMine, nextTheirs, ownMine, ownTheirs;
+    std::vector<uint8_t> live, nextLive;
+    std::vector<int> grewAt; // last sweep of reachable() that added cells to each row
+    Head self = { 0, 0, 0 };
+    std::vector<Head> others;
+    int opponent = -1;
+    uint64_t nodes = 0;
+    bool aborted = false;
+    bool searching = false;
+    std::chrono::steady_clock::time_point deadline;
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Tron light cycles without any SFML dependency, so they can also run headless.
+//
+// Every cell a cycle has passed through is one bit of a row-padded occupancy
+// grid (64 cells per word), so a collision test is a single bit test however
+// long the trails get, and a 1000x1000 arena takes 125 KB. step() moves all
+// cycles at once and is deterministic: the same seed and inputs always give
+// the same game. Renderers only look at the cells claimed by the last step.
+
+enum TronDirection : uint8_t {
+    TRON_UP,
+    TRON_RIGHT,
+    TRON_DOWN,
+    TRON_LEFT,
+    TRON_KEEP // input: keep the current direction
+};
+
+const int tronDx[4] = { 0, 1, 0, -1 };
+const int tronDy[4] = { -1, 0, 1, 0 };
+
+class TronGrid {
+public:
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        wordsPerRow = (w + 63) / 64;
+        bits.assign((size_t)wordsPerRow * h, 0);
+    }
+
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    bool test(int x, int y) const { return bits[(size_t)y * wordsPerRow + (x >> 6)] >> (x & 63) & 1; }
+    void set(int x, int y) { bits[(size_t)y * wordsPerRow + (x >> 6)] |= (uint64_t)1 << (x & 63); }
+
+    // Bit x & 63 of word x >> 6 is column x; bits past the width are always 0
+    const uint64_t* row(int y) const { return bits.data() + (size_t)y * wordsPerRow; }
+
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+};
+
+struct TronPlayer {
+    int x;
+    int y;
+    uint8_t dir;
+    bool alive;
+    int length; // cells claimed, the starting one included
+};
+
+// A cell claimed by a player during the last step
+struct TronCell {
+    int x;
+    int y;
+    int player;
+};
+
+class TronGame {
+public:
+    // Leaving one side comes back in on the other, as in the original
+    // archive_examples/08_Tron.cpp. Without wrap the border is a wall.
+    bool wrap = true;
+
+    // Two players start like the original: a quarter in from each side,
+    // heading up. Any other number spawns on seeded random free cells, at
+    // most one player per cell.
+    void reset(int width, int height, int playerCount, uint32_t seed) {
+        playerCount = std::min(playerCount, width * height);
+        grid.resize(width, height);
+        rng = seed ? seed : 0x9E3779B9u;
+        tick = 0;
+        players.clear();
+        claimed.clear();
+        for (int i = 0; i < playerCount; i++) {
+            TronPlayer p;
+            if (playerCount == 2) {
+                p.x = i == 0 ? width / 4 : width - width / 4;
+                p.y = height / 2;
+                p.dir = TRON_UP;
+            } else {
+                do {
+                    p.x = (int)(nextRandom() % (uint32_t)width);
+                    p.y = (int)(nextRandom() % (uint32_t)height);
+                } while (grid.test(p.x, p.y));
+                p.dir = (uint8_t)(nextRandom() % 4);
+            }
+            p.alive = true;
+            p.length = 1;
+            grid.set(p.x, p.y);
+            players.push_back(p);
+            claimed.push_back({ p.x, p.y, i });
+        }
+        aliveCount = playerCount;
+    }
+
+    // One tick. inputs holds a TronDirection per player; turning straight
+    // back is ignored. A cycle dies entering a claimed cell, leaving the
+    // arena without wrap, or entering the same cell as another cycle.
+    void step(const uint8_t* inputs) {
+        claimed.clear();
+        moves.clear();
+        const int width = grid.width, height = grid.height;
+        for (int i = 0; i < (int)players.size(); i++) {
+            TronPlayer& p = players[i];
+            if (!p.alive) continue;
+            uint8_t input = inputs ? inputs[i] : (uint8_t)TRON_KEEP;
+            if (input < 4 && input != (p.dir ^ 2)) p.dir = input;
+            int x = p.x + tronDx[p.dir];
+            int y = p.y + tronDy[p.dir];
+            if (wrap) {
+                x = x < 0 ? width - 1 : (x >= width ? 0 : x);
+                y = y < 0 ? height - 1 : (y >= height ? 0 : y);
+            } else if (x < 0 || x >= width || y < 0 || y >= height) {
+                p.alive = false;
+                continue;
+            }
+            if (grid.test(x, y)) {
+                p.alive = false;
+                continue;
+            }
+            p.x = x;
+            p.y = y;
+            moves.push_back({ (uint64_t)y * width + x, i });
+        }
+
+        // Cycles meeting in the same free cell both crash; the wreck keeps
+        // the cell (drawn in the lowest player's color)
+        std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) {
+            return a.cell != b.cell ? a.cell < b.cell : a.player < b.player;
+        });
+        for (size_t i = 0; i < moves.size();) {
+            size_t j = i + 1;
+            while (j < moves.size() && moves[j].cell == moves[i].cell) j++;
+            if (j - i > 1) {
+                for (size_t k = i; k < j; k++) players[moves[k].player].alive = false;
+            }
+            TronPlayer& first = players[moves[i].player];
+            grid.set(first.x, first.y);
+            first.length++;
+            claimed.push_back({ first.x, first.y, moves[i].player });
+            i = j;
+        }
+
+        aliveCount = 0;
+        for (const TronPlayer& p : players) aliveCount += p.alive;
+        tick++;
+    }
+
+    // The round is over when at most one cycle is left (or, alone in the
+    // arena, when it crashed)
+    bool over() const { return players.size() > 1 ? aliveCount <= 1 : aliveCount == 0; }
+
+    // Index of the last cycle standing, -1 for a draw or a running round
+    int winner() const {
+        if (!over()) return -1;
+        for (int i = 0; i < (int)players.size(); i++) {
+            if (players[i].alive) return i;
+        }
+        return -1;
+    }
+
+    int width() const { return grid.width; }
+    int height() const { return grid.height; }
+
+    TronGrid grid;
+    std::vector<TronPlayer> players;
+    std::vector<TronCell> claimed; // cells taken by the last step (or reset), for renderers
+    uint32_t tick = 0;
+    int aliveCount = 0;
+
+private:
+    struct Move {
+        uint64_t cell;
+        int player;
+    };
+
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    std::vector<Move> moves;
+    uint32_t rng = 1;
+};
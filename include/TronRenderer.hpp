@@ -0,0 +1,74 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "TronCore.hpp"
+
+// Player colors: red and blue like the original, then a spread of hues
+inline sf::Color tronColor(int player)
+{
+    static const sf::Color first[] = { sf::Color::Red, sf::Color::Blue, sf::Color::Green, sf::Color::Yellow,
+                                       sf::Color::Magenta, sf::Color::Cyan, sf::Color(255, 128, 0), sf::Color::White };
+    if (player < 8) return first[player];
+    float hue = (player * 0.618034f) - (int)(player * 0.618034f);
+    float h = hue * 6.0f;
+    int sector = (int)h;
+    sf::Uint8 rise = (sf::Uint8)((h - sector) * 255.0f), fall = (sf::Uint8)(255 - rise);
+    switch (sector) {
+    case 0: return sf::Color(255, rise, 0);
+    case 1: return sf::Color(fall, 255, 0);
+    case 2: return sf::Color(0, 255, rise);
+    case 3: return sf::Color(0, fall, 255);
+    case 4: return sf::Color(rise, 0, 255);
+    default: return sf::Color(255, 0, fall);
+    }
+}
+
+// Trails are never erased during a round, so they accumulate in a render
+// texture: each frame the cells claimed since the last one are drawn into it
+// as one quad batch and the texture is drawn as one sprite. The cost per
+// frame depends on how many cells changed, not on the trail lengths.
+class TronRenderer {
+public:
+    TronRenderer(int width, int height, int cellSize) : cellSize(cellSize) {
+        layer.create(width * cellSize, height * cellSize);
+        layer.clear(sf::Color::Black);
+        layer.display();
+    }
+
+    // Starts over for a new round
+    void reset(const TronGame& game) {
+        pending.clear();
+        cleared = true;
+        add(game);
+    }
+
+    // Queues the cells claimed by the last step; call after every step
+    void add(const TronGame& game) {
+        for (const TronCell& c : game.claimed) {
+            sf::Color color = tronColor(c.player);
+            float x = (float)(c.x * cellSize), y = (float)(c.y * cellSize), s = (float)cellSize;
+            pending.emplace_back(sf::Vector2f(x, y), color);
+            pending.emplace_back(sf::Vector2f(x + s, y), color);
+            pending.emplace_back(sf::Vector2f(x + s, y + s), color);
+            pending.emplace_back(sf::Vector2f(x, y + s), color);
+        }
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (cleared || !pending.empty()) {
+            if (cleared) layer.clear(sf::Color::Black);
+            if (!pending.empty()) layer.draw(pending.data(), pending.size(), sf::Quads);
+            layer.display();
+            pending.clear();
+            cleared = false;
+        }
+        target.draw(sf::Sprite(layer.getTexture()));
+    }
+
+private:
+    int cellSize;
+    sf::RenderTexture layer;
+    std::vector<sf::Vertex> pending;
+    bool cleared = false;
+};
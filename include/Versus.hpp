@@ -0,0 +1,349 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "TetrisCore.hpp"
+
+// Two-player versus with rollback netcode.
+//
+// Both clients simulate the whole match (both boards) from the same seed with
+// a fixed time step, so the only thing that goes over the network is each
+// player's buttons per frame. The remote player's buttons are predicted (the
+// last confirmed ones are assumed to stay held); when the real ones arrive and
+// differ, the match is restored from the snapshot taken before that frame and
+// re-simulated up to the present. Local input is applied immediately.
+
+typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> VersusGame;
+
+// Garbage rows sent for the lines cleared in one step
+inline int garbageForLines(int lines)
+{
+    static const int table[5] = { 0, 0, 1, 2, 4 };
+    return lines < 5 ? table[lines] : lines;
+}
+
+// The complete deterministic state of a match. Plain data, so a snapshot is
+// a copy (about 2 KB).
+class VersusMatch {
+public:
+    static constexpr float kFrameTime = 1.0f / 60.0f;
+
+    explicit VersusMatch(uint32_t seed = 1) {
+        reset(seed);
+    }
+
+    void reset(uint32_t seed) {
+        players[0].reset(seed);
+        players[1].reset(seed); // same piece sequence for both
+        rng = seed * 2654435761u + 1;
+        frame = 0;
+    }
+
+    void step(const uint8_t input[2]) {
+        int garbage[2] = { 0, 0 };
+        for (int p = 0; p < 2; p++) {
+            players[p].step(input[p], kFrameTime);
+            int lines = 0;
+            const GameStatus& status = players[p].status;
+            for (int i = 0; i < status.eventCount; i++)
+                if (status.events[i].type == EVENT_LINE) lines++;
+            garbage[1 - p] = garbageForLines(lines);
+        }
+        for (int p = 0; p < 2; p++)
+            if (garbage[p]) players[p].addGarbage(garbage[p], (int)(nextRandom() % players[p].width()));
+        frame++;
+    }
+
+    bool over() const {
+        return players[0].status.gameOver || players[1].status.gameOver;
+    }
+
+    // FNV-1a over everything that matters, used to detect desyncs
+    uint32_t checksum() const {
+        uint32_t hash = 2166136261u;
+        auto mix = [&hash](const void* data, size_t size) {
+            const uint8_t* bytes = (const uint8_t*)data;
+            for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+        };
+        for (const VersusGame& game : players) {
+            mix(game.board.rows, sizeof(game.board.rows));
+            mix(&game.status.piece, sizeof(Piece));
+            mix(&game.status.score, sizeof(int));
+            mix(&game.status.gameOver, sizeof(bool));
+        }
+        mix(&rng, sizeof(rng));
+        mix(&frame, sizeof(frame));
+        return hash;
+    }
+
+    VersusGame players[2];
+    uint32_t rng;
+    int frame;
+
+private:
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+};
+
+// One datagram: the sender's inputs for frames [firstFrame, firstFrame + count)
+// plus the last frame it has confirmed from us, and the checksum of a frame
+// whose inputs it knows for both players. Inputs are resent until acknowledged,
+// so a lost packet costs nothing but a little delay.
+struct InputPacket {
+    static const int kMaxInputs = 80; // unacknowledged frames; the sender stalls beyond this
+    static const int kHeaderSize = 17;
+    static const uint8_t kMagic = 0x7E;
+
+    int32_t firstFrame = 0;
+    int32_t ack = -1;
+    int32_t syncFrame = -1;
+    uint32_t syncHash = 0;
+    uint8_t count = 0;
+    uint8_t inputs[kMaxInputs];
+
+    // Host byte order; both ends are the same program
+    int write(uint8_t* out) const {
+        out[0] = kMagic;
+        std::memcpy(out + 1, &firstFrame, 4);
+        std::memcpy(out + 5, &ack, 4);
+        std::memcpy(out + 9, &syncFrame, 4);
+        std::memcpy(out + 13, &syncHash, 4);
+        out[kHeaderSize] = count;
+        std::memcpy(out + kHeaderSize + 1, inputs, count);
+        return kHeaderSize + 1 + count;
+    }
+
+    bool read(const uint8_t* data, size_t size) {
+        if (size < (size_t)kHeaderSize + 1 || data[0] != kMagic) return false;
+        std::memcpy(&firstFrame, data + 1, 4);
+        std::memcpy(&ack, data + 5, 4);
+        std::memcpy(&syncFrame, data + 9, 4);
+        std::memcpy(&syncHash, data + 13, 4);
+        count = data[kHeaderSize];
+        if (count > kMaxInputs || size < (size_t)kHeaderSize + 1 + count) return false;
+        std::memcpy(inputs, data + kHeaderSize + 1, count);
+        return true;
+    }
+};
+
+struct RollbackStats {
+    long frames = 0;        // frames advanced
+    long rollbacks = 0;     // mispredictions corrected
+    long resimFrames = 0;   // frames simulated again because of them
+    int maxDepth = 0;       // deepest rollback in frames
+    double resimSeconds = 0.0;
+    long stalls = 0;        // frames we had to wait for the remote player
+    long desyncs = 0;
+
+    double averageDepth() const {
+        return rollbacks ? (double)resimFrames / rollbacks : 0.0;
+    }
+
+    // Re-simulation cost spread over all frames
+    double resimUsPerFrame() const {
+        return frames ? resimSeconds * 1e6 / frames : 0.0;
+    }
+};
+
+class RollbackSession {
+public:
+    static const int kHistory = 128;      // frames of inputs and snapshots kept
+    static const int kMaxPrediction = 32; // frames we may run ahead of the remote player
+
+    RollbackSession(int localPlayer, uint32_t seed)
+        : local(localPlayer), remote(1 - localPlayer), match(seed) {
+        std::memset(inputs, 0, sizeof(inputs));
+        std::memset(hashes, 0, sizeof(hashes));
+    }
+
+    int frame() const {
+        return match.frame;
+    }
+
+    // How far the simulation is ahead of the remote player's confirmed input
+    int prediction() const {
+        return match.frame - 1 - confirmedRemote;
+    }
+
+    // Last frame with the remote player's input known
+    int confirmedFrame() const {
+        return confirmedRemote;
+    }
+
+    const VersusMatch& state() const {
+        return match;
+    }
+
+    // Applies a pending rollback now instead of on the next advance()
+    void resolve() {
+        rollback();
+    }
+
+    // Simulates one frame with the local buttons. Returns false (and does
+    // nothing) when we are too far ahead of the remote player to predict, or
+    // when one more frame would leave more unacknowledged inputs than a
+    // packet holds: those could never be resent and the remote player would
+    // wait for them forever.
+    bool advance(uint8_t localInput) {
+        if (match.frame - confirmedRemote > kMaxPrediction || match.frame - remoteAck > InputPacket::kMaxInputs) {
+            stats.stalls++;
+            return false;
+        }
+        rollback();
+
+        int f = match.frame;
+        uint8_t* in = inputs[f % kHistory];
+        in[local] = localInput;
+        in[remote] = f <= confirmedRemote ? in[remote] : predictRemote();
+        snapshots[f % kHistory] = match;
+        match.step(in);
+        hashes[f % kHistory] = match.checksum();
+        stats.frames++;
+        return true;
+    }
+
+    // Confirms the remote player's buttons for frame f. Frames have to arrive
+    // in order; the packets repeat everything unacknowledged, so a gap fills
+    // itself from a later packet.
+    void receiveRemote(int f, uint8_t input) {
+        if (f != confirmedRemote + 1) return;
+        confirmedRemote = f;
+        uint8_t& slot = inputs[f % kHistory][remote];
+        if (f < match.frame && slot != input && (rollbackFrom < 0 || f < rollbackFrom)) rollbackFrom = f;
+        slot = input;
+        lastRemoteInput = input;
+    }
+
+    // Builds the packet to send this frame: every local input the remote
+    // player has not acknowledged yet, which advance() keeps within
+    // InputPacket::kMaxInputs
+    InputPacket makePacket() const {
+        InputPacket packet;
+        int first = remoteAck + 1;
+        packet.firstFrame = first;
+        packet.count = (uint8_t)(match.frame - first);
+        for (int i = 0; i < packet.count; i++) packet.inputs[i] = inputs[(first + i) % kHistory][local];
+        packet.ack = confirmedRemote;
+        packet.syncFrame = finalFrame();
+        packet.syncHash = packet.syncFrame >= 0 ? hashes[packet.syncFrame % kHistory] : 0;
+        return packet;
+    }
+
+    void receivePacket(const InputPacket& packet) {
+        if (packet.ack > remoteAck) remoteAck = packet.ack;
+        for (int i = 0; i < packet.count; i++) receiveRemote(packet.firstFrame + i, packet.inputs[i]);
+        // Compare checksums for a frame both of us have final
+        int f = packet.syncFrame;
+        if (f >= 0 && f <= finalFrame() && f > match.frame - kHistory && hashes[f % kHistory] != packet.syncHash) stats.desyncs++;
+    }
+
+    RollbackStats stats;
+
+private:
+    uint8_t predictRemote() const {
+        return lastRemoteInput;
+    }
+
+    // Last frame whose resulting state can no longer change: both inputs
+    // known, already simulated and not waiting for a rollback
+    int finalFrame() const {
+        int f = confirmedRemote < match.frame - 1 ? confirmedRemote : match.frame - 1;
+        if (rollbackFrom >= 0 && rollbackFrom - 1 < f) f = rollbackFrom - 1;
+        return f;
+    }
+
+    // Restores the snapshot before the first mispredicted frame and replays
+    // up to the present with the corrected inputs
+    void rollback() {
+        if (rollbackFrom < 0) return;
+        auto start = std::chrono::steady_clock::now();
+        int target = match.frame;
+        match = snapshots[rollbackFrom % kHistory];
+        while (match.frame < target) {
+            int f = match.frame;
+            uint8_t* in = inputs[f % kHistory];
+            if (f > confirmedRemote) in[remote] = predictRemote();
+            snapshots[f % kHistory] = match;
+            match.step(in);
+            hashes[f % kHistory] = match.checksum();
+        }
+        int depth = target - rollbackFrom;
+        stats.rollbacks++;
+        stats.resimFrames += depth;
+        if (depth > stats.maxDepth) stats.maxDepth = depth;
+        stats.resimSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rollbackFrom = -1;
+    }
+
+    int local;
+    int remote;
+    VersusMatch match;
+    VersusMatch snapshots[kHistory]; // state before each frame
+    uint8_t inputs[kHistory][2];
+    uint32_t hashes[kHistory];       // checksum of the state after each frame
+    int confirmedRemote = -1;        // last frame with the remote input known
+    int remoteAck = -1;              // last of our frames the remote player has
+    int rollbackFrom = -1;           // earliest mispredicted frame, -1 when none
+    uint8_t lastRemoteInput = 0;
+};
+
+// Artificial latency, jitter and packet loss for testing on loopback. Packets
+// go in with send() and come out of receive() once their delivery time passed.
+class LagSimulator {
+public:
+    LagSimulator(double latencyMs = 0.0, double jitterMs = 0.0, double lossPercent = 0.0, uint32_t seed = 99)
+        : latency(latencyMs / 1000.0), jitter(jitterMs / 1000.0), loss(lossPercent / 100.0), rng(seed ? seed : 1) {}
+
+    void send(const uint8_t* data, int size, double now) {
+        sent++;
+        if (random() < loss) {
+            dropped++;
+            return;
+        }
+        double delay = latency + (random() * 2.0 - 1.0) * jitter;
+        Datagram d;
+        d.deliverAt = now + (delay > 0.0 ? delay : 0.0);
+        d.bytes.assign(data, data + size);
+        // Keep the queue ordered by delivery time; jitter may reorder packets
+        auto it = queue.end();
+        while (it != queue.begin() && (it - 1)->deliverAt > d.deliverAt) --it;
+        queue.insert(it, std::move(d));
+    }
+
+    // Returns false when nothing is due yet
+    bool receive(std::vector<uint8_t>& out, double now) {
+        if (queue.empty() || queue.front().deliverAt > now) return false;
+        out.swap(queue.front().bytes);
+        queue.pop_front();
+        return true;
+    }
+
+    long sent = 0;
+    long dropped = 0;
+
+private:
+    struct Datagram {
+        double deliverAt;
+        std::vector<uint8_t> bytes;
+    };
+
+    double random() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return (rng & 0xFFFFFF) / (double)0x1000000;
+    }
+
+    double latency;
+    double jitter;
+    double loss;
+    uint32_t rng;
+    std::deque<Datagram> queue;
+};
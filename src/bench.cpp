@@ -0,0 +1,2422 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+#include "Ball.hpp"
+#include "Debris.hpp"
+#include "Ground.hpp"
+#include "FrameCapture.hpp"
+#include "GameWindow.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "PieceSet.hpp"
+#include "PuzzleSolver.hpp"
+#include "PhysicsEntities.hpp"
+#include "QualityGovernor.hpp"
+#include "ScoreStore.hpp"
+#include "SoftRenderer.hpp"
+#include "SoundEffects.hpp"
+#include "SpriteAtlas.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteSheets.hpp"
+#include "TerminalRenderer.hpp"
+#include "TetrisBot.hpp"
+#include "TetrisCore.hpp"
+#include "TronBot.hpp"
+#include "TronCore.hpp"
+#include "Versus.hpp"
+
+// Benchmarks and stress tests that run without opening a window.
+// Usage: bench.exe <name> [options]
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Fires random sound effects at a fixed rate from this (the "game") thread and
+// reports trigger cost, voice stealing and trigger-to-playback latency.
+// Options: [events per second = 500] [seconds = 5]
+static int benchSfx(int argc, char** argv)
+{
+    double rate = argc > 0 ? atof(argv[0]) : 500.0;
+    double duration = argc > 1 ? atof(argv[1]) : 5.0;
+
+    SoundEffects sfx;
+    uint32_t rng = 12345;
+    double pending = 0.0;
+    uint64_t calls = 0;
+    double worstTriggerNs = 0.0;
+    double totalTriggerNs = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    while (secondsSince(start) < duration) {
+        auto now = std::chrono::steady_clock::now();
+        pending += std::chrono::duration<double>(now - last).count() * rate;
+        last = now;
+        while (pending >= 1.0) {
+            rng = rng * 1664525u + 1013904223u;
+            SoundEffect id = (SoundEffect)((rng >> 16) % SFX_COUNT);
+            auto t0 = std::chrono::steady_clock::now();
+            sfx.trigger(id);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            totalTriggerNs += ns;
+            if (ns > worstTriggerNs) worstTriggerNs = ns;
+            calls++;
+            pending -= 1.0;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    // Let the mixer thread catch up before reading the counters
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::cout << "sfx stress: " << calls << " triggers in " << duration << " s (" << rate << "/s)\n";
+    std::cout << "  trigger cost: avg " << (calls ? totalTriggerNs / calls : 0.0) << " ns, max " << worstTriggerNs << " ns\n";
+    std::cout << "  played " << sfx.played.load() << ", stolen " << sfx.stolen.load() << ", dropped " << sfx.dropped.load() << "\n";
+    std::cout << "  dispatch latency: avg " << sfx.dispatchLatency.averageUs() << " us, p99 <= "
+              << sfx.dispatchLatency.percentileUs(0.99) << " us, max " << sfx.dispatchLatency.maxUs.load() << " us\n";
+    std::cout << "  start latency:    avg " << sfx.startLatency.averageUs() << " us, p99 <= "
+              << sfx.startLatency.percentileUs(0.99) << " us, max " << sfx.startLatency.maxUs.load() << " us\n";
+    return 0;
+}
+
+// Drives the quality governor with a synthetic load: every frame costs a base
+// amount plus an effect load scaled by the current particle fraction, and the
+// effect load goes through calm, heavy, extreme and calm phases.
+static int benchGovernor(int, char**)
+{
+    struct Phase { const char* name; int frames; float baseMs; float effectMs; };
+    const Phase phases[] = {
+        { "calm", 120, 4.0f, 2.0f },
+        { "heavy", 300, 6.0f, 12.0f },
+        { "extreme", 300, 6.0f, 40.0f },
+        { "calm", 600, 4.0f, 2.0f },
+    };
+
+    QualityGovernor governor;
+    int frame = 0;
+    int missed = 0;
+    for (const auto& phase : phases) {
+        int phaseMissed = 0;
+        for (int i = 0; i < phase.frames; i++, frame++) {
+            const QualitySettings& q = governor.settings();
+            float ms = phase.baseMs + phase.effectMs * q.particleFraction + (q.gridLines ? 0.5f : 0.0f);
+            if (ms > governor.frameBudget() * 1000.0f) phaseMissed++;
+            if (governor.addFrame(ms / 1000.0f))
+                std::cout << "  frame " << frame << " (" << phase.name << "): quality -> " << governor.level()
+                          << " (avg " << governor.averageFrame() * 1000.0f << " ms)\n";
+        }
+        std::cout << phase.name << ": " << phase.frames << " frames, " << phaseMissed << " over budget, ends at quality "
+                  << governor.level() << "\n";
+        missed += phaseMissed;
+    }
+    std::cout << "total over budget: " << missed << " of " << frame << " frames\n";
+    return 0;
+}
+
+// Plays bot games with direct placement and returns pieces per second.
+// checksum folds in the scores so runs can be compared for equality.
+template <class Game>
+static double runBotGames(Game& game, int pieces, uint32_t seed, uint64_t& checksum)
+{
+    game.reset(seed);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pieces; i++) {
+        if (game.status.gameOver) game.reset(++seed);
+        BotMove move = findBotMove(game);
+        game.place(move.rotation, move.x);
+        checksum = checksum * 31 + (uint64_t)game.status.score;
+    }
+    return pieces / secondsSince(start);
+}
+
+// The rules as they were before TetrisGame: a runtime-sized array of cells
+// and a fit test that walks all 16 cells of the 4x4 box with bounds checks,
+// and a bot that scans cells the same way. It plays the same games as
+// TetrisGame::place() without cascades (same spawns, specials, scoring and
+// bot choices), so it is the baseline the templated core is measured against.
+class CellArrayGame {
+public:
+    CellArrayGame(int width, int height, bool specials) : w(width), h(height), specials(specials), field(width * height) {}
+
+    void reset(uint32_t seed) {
+        std::fill(field.begin(), field.end(), 0);
+        rng = seed ? seed : 0x9E3779B9u;
+        score = 0;
+        gameOver = false;
+        pieceCounter = 0;
+        spawn(pieceTable.normal.pick(nextRandom()));
+    }
+
+    bool fits(int type, int rotation, int x, int y) const {
+        for (int px = 0; px < 4; px++)
+            for (int py = 0; py < 4; py++) {
+                if (kTetrominoes[type][rotate(px, py, rotation)] == '.') continue;
+                int fx = x + px, fy = y + py;
+                if (fx < 0 || fx >= w || fy < 0 || fy >= h || field[fy * w + fx] != 0) return false;
+            }
+        return true;
+    }
+
+    int dropY(int type, int rotation, int x, int y) const {
+        while (fits(type, rotation, x, y + 1)) y++;
+        return y;
+    }
+
+    // Same features and weights as evaluatePlacement()
+    float evaluate(int type, int rotation, int x, int y) const {
+        int heights[64] = {};
+        bool covered[64] = {};
+        int lines = 0, holes = 0;
+        for (int row = 0; row < h; row++) {
+            bool filled[64];
+            bool full = true;
+            for (int c = 0; c < w; c++) {
+                int px = c - x, py = row - y;
+                bool block = px >= 0 && px < 4 && py >= 0 && py < 4 && kTetrominoes[type][rotate(px, py, rotation)] != '.';
+                filled[c] = block || field[row * w + c] != 0;
+                full = full && filled[c];
+            }
+            if (full) {
+                lines++;
+                continue;
+            }
+            for (int c = 0; c < w; c++) {
+                if (filled[c] && !covered[c]) heights[c] = h - row;
+                if (!filled[c] && covered[c]) holes++;
+                covered[c] = covered[c] || filled[c];
+            }
+        }
+        int aggregate = 0, bumpiness = 0;
+        for (int c = 0; c < w; c++) {
+            aggregate += heights[c];
+            if (c > 0) bumpiness += std::abs(heights[c] - heights[c - 1]);
+        }
+        return -0.51f * aggregate + 0.76f * lines - 0.36f * holes - 0.18f * bumpiness;
+    }
+
+    BotMove findMove() const {
+        BotMove best = { piece.rotation, piece.x, -1e30f };
+        for (int r = 0; r < 4; r++)
+            for (int x = -3; x < w; x++) {
+                if (!fits(piece.type, r, x, piece.y)) continue;
+                float value = evaluate(piece.type, r, x, dropY(piece.type, r, x, piece.y));
+                if (value > best.score) best = { r, x, value };
+            }
+        return best;
+    }
+
+    void place(int rotation, int x) {
+        Piece& p = piece;
+        p.rotation = rotation;
+        p.x = x;
+        p.y = dropY(p.type, rotation, x, p.y);
+        for (int py = 0; py < 4; py++)
+            for (int px = 0; px < 4; px++)
+                if (kTetrominoes[p.type][rotate(px, py, rotation)] != '.') field[(p.y + py) * w + p.x + px] = p.type + 1;
+
+        if (specials) applySpecial();
+        for (int py = 0; py < 4; py++) {
+            int y = p.y + py;
+            if (y < 0 || y >= h) continue;
+            bool full = true;
+            for (int c = 0; c < w && full; c++) full = field[y * w + c] != 0;
+            if (!full) continue;
+            for (int ty = y; ty > 0; ty--)
+                for (int c = 0; c < w; c++) field[ty * w + c] = field[(ty - 1) * w + c];
+            for (int c = 0; c < w; c++) field[c] = 0;
+            score += 100;
+        }
+
+        pieceCounter++;
+        if (specials && pieceCounter % 3 == 0 && pieceTable.special.count)
+            spawn(pieceTable.special.pick(nextRandom()));
+        else
+            spawn(pieceTable.normal.pick(nextRandom()));
+        gameOver = !fits(piece.type, piece.rotation, piece.x, piece.y);
+    }
+
+    Piece piece = { 0, 0, 0, 0 };
+    int score = 0;
+    bool gameOver = false;
+
+private:
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    void spawn(int type) { piece = { type, 0, w / 2 - 2, 0 }; }
+
+    void applySpecial() {
+        const Piece& p = piece;
+        switch (pieceEffect(p.type)) {
+        case EFFECT_ELECTRICAL:
+            for (int y = p.y; y >= p.y - 1; y--) {
+                if (y < 0 || y >= h) continue;
+                for (int c = 0; c < w; c++) field[y * w + c] = 0;
+                score += 100;
+            }
+            break;
+        case EFFECT_FIRE:
+            for (int ex = -2; ex <= 2; ex++)
+                for (int ey = -2; ey <= 2; ey++) {
+                    int nx = p.x + ex, ny = p.y + ey;
+                    if (nx >= 0 && nx < w && ny >= 0 && ny < h && field[ny * w + nx] != 0) {
+                        field[ny * w + nx] = 0;
+                        score += 10;
+                    }
+                }
+            break;
+        default:
+            break;
+        }
+    }
+
+    int w;
+    int h;
+    bool specials;
+    std::vector<int> field;
+    uint32_t rng = 1;
+    int pieceCounter = 0;
+};
+
+static double runCellArrayGames(CellArrayGame& game, int pieces, uint32_t seed, uint64_t& checksum)
+{
+    game.reset(seed);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pieces; i++) {
+        if (game.gameOver) game.reset(++seed);
+        BotMove move = game.findMove();
+        game.place(move.rotation, move.x);
+        checksum = checksum * 31 + (uint64_t)game.score;
+    }
+    return pieces / secondsSince(start);
+}
+
+template <int W, int H, class Rules>
+static void compareCore(const char* name, bool specials, int pieces)
+{
+    TetrisGame<FixedBoard<W, H>, Rules> fixed;
+    DynamicRules rules;
+    rules.enabled = specials;
+    TetrisGame<DynamicBoard, DynamicRules> dynamic(DynamicBoard(W, H), rules);
+    CellArrayGame cells(W, H, specials);
+
+    uint64_t fixedSum = 0;
+    uint64_t dynamicSum = 0;
+    uint64_t cellSum = 0;
+    double fixedRate = runBotGames(fixed, pieces, 42, fixedSum);
+    double dynamicRate = runBotGames(dynamic, pieces, 42, dynamicSum);
+    double cellRate = runCellArrayGames(cells, pieces, 42, cellSum);
+    std::cout << name << " (" << W << "x" << H << (specials ? ", specials" : ", classic") << "): specialized "
+              << (int)fixedRate << " pieces/s, runtime-sized bitmask " << (int)dynamicRate << " pieces/s ("
+              << fixedRate / dynamicRate << "x), cell array " << (int)cellRate << " pieces/s (" << fixedRate / cellRate
+              << "x)" << (fixedSum == dynamicSum && fixedSum == cellSum ? "" : "  (MISMATCH)") << "\n";
+}
+
+// Specialized board/rule-set instantiations against the runtime-sized
+// bitmask build and against the cell array the rules used before, all
+// playing identical seeded bot games. Options: [pieces = 200000]
+static int benchCore(int argc, char** argv)
+{
+    int pieces = argc > 0 ? atoi(argv[0]) : 200000;
+    compareCore<10, 20, SpecialRules>("standard", true, pieces);
+    compareCore<16, 20, SpecialRules>("wide", true, pieces);
+    compareCore<10, 40, SpecialRules>("tall", true, pieces);
+    compareCore<10, 20, ClassicRules>("classic", false, pieces);
+    return 0;
+}
+
+// Cascade gravity on random tall boards full of floating groups. Checks that
+// every board ends stable (nothing left to fall, no full rows, row masks match
+// the cells) and compares the worst case against one 60 Hz tick.
+// Options: [boards = 2000] [fill percent = 60]
+static int benchCascade(int argc, char** argv)
+{
+    int boards = argc > 0 ? atoi(argv[0]) : 2000;
+    int fill = argc > 1 ? atoi(argv[1]) : 60;
+
+    typedef TetrisGame<FixedBoard<10, 40>, SpecialRules> Game;
+    Game game;
+    uint32_t rng = 777;
+    auto random = [&rng]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+
+    double totalUs = 0.0;
+    double worstUs = 0.0;
+    long totalChain = 0;
+    int worstChain = 0;
+    long totalLines = 0;
+    int unstable = 0;
+    for (int b = 0; b < boards; b++) {
+        game.reset(b + 1);
+        const int w = game.board.width();
+        const int h = game.board.height();
+        // Leave the top quarter empty so groups have somewhere to fall from
+        for (int y = h / 4; y < h; y++) {
+            for (int x = 0; x < w; x++)
+                if ((int)(random() % 100) < fill) game.setCell(x, y, 1 + random() % kPieceTypes);
+            game.setCell(random() % w, y, 0); // no full rows to begin with
+        }
+
+        int linesBefore = game.status.linesCleared;
+        auto start = std::chrono::steady_clock::now();
+        int chain = game.runCascade();
+        double us = secondsSince(start) * 1e6;
+        totalUs += us;
+        if (us > worstUs) worstUs = us;
+        totalChain += chain;
+        if (chain > worstChain) worstChain = chain;
+        totalLines += game.status.linesCleared - linesBefore;
+
+        bool ok = game.settle() == 0;
+        const Game::Row* rows = game.board.rowData() + kBoardPad;
+        for (int y = 0; y < h; y++) {
+            if (rows[y] == game.board.fullRow()) ok = false;
+            for (int x = 0; x < w; x++)
+                if (((rows[y] >> (x + kBoardPad)) & 1) != (game.cell(x, y) != 0)) ok = false;
+        }
+        if (!ok) unstable++;
+    }
+
+    const double tickUs = 1e6 / 60.0;
+    std::cout << "cascade: " << boards << " boards 10x40 at " << fill << "% fill\n";
+    std::cout << "  time: avg " << totalUs / boards << " us, max " << worstUs << " us (" << 100.0 * worstUs / tickUs
+              << "% of a 60 Hz tick)\n";
+    std::cout << "  chain steps: avg " << (double)totalChain / boards << ", max " << worstChain << ", lines "
+              << (double)totalLines / boards << " per board\n";
+    std::cout << "  unstable boards: " << unstable << "\n";
+    return unstable == 0 ? 0 : 1;
+}
+
+// Two rollback sessions played by bots over a simulated link with latency,
+// jitter and loss, on a virtual 60 Hz clock. Reports rollback depth and
+// re-simulation cost, and checks both ends finish with the same state. An ack
+// delay holds back the acknowledgements player 0 receives, as from a peer that
+// acknowledges late; every packet must still start at the first frame not
+// acknowledged, or the remote player would wait for frames nobody resends.
+// Options: [latency ms = 80] [loss percent = 5] [frames = 3600] [ack delay ms = 0]
+static int benchRollback(int argc, char** argv)
+{
+    double latency = argc > 0 ? atof(argv[0]) : 80.0;
+    double loss = argc > 1 ? atof(argv[1]) : 5.0;
+    int frames = argc > 2 ? atoi(argv[2]) : 3600;
+    double ackDelay = argc > 3 ? atof(argv[3]) / 1000.0 : 0.0;
+
+    std::unique_ptr<RollbackSession> sessions[2] = {
+        std::unique_ptr<RollbackSession>(new RollbackSession(0, 7)),
+        std::unique_ptr<RollbackSession>(new RollbackSession(1, 7)),
+    };
+    LagSimulator links[2] = { LagSimulator(latency / 2, latency / 8, loss, 11), LagSimulator(latency / 2, latency / 8, loss, 22) };
+    uint8_t previous[2] = { 0, 0 };
+    uint32_t rng = 5;
+    int idle[2] = { 0, 0 };
+    std::vector<uint8_t> datagram;
+    uint8_t buffer[128];
+    std::vector<std::pair<double, int>> heldAcks; // acks for player 0 and when they arrived
+    int ackSeen[2] = { -1, -1 };                  // highest ack each player has received
+    int skipped = 0;                              // packets that left unacknowledged frames out
+
+    auto exchange = [&](double now) {
+        for (int s = 0; s < 2; s++) {
+            InputPacket packet;
+            while (links[s].receive(datagram, now)) {
+                if (!packet.read(datagram.data(), datagram.size())) continue;
+                if (s == 1 && ackDelay > 0) {
+                    heldAcks.push_back(std::make_pair(now, packet.ack));
+                    packet.ack = -1;
+                    size_t released = 0;
+                    for (; released < heldAcks.size() && heldAcks[released].first <= now - ackDelay; released++)
+                        packet.ack = std::max(packet.ack, heldAcks[released].second);
+                    heldAcks.erase(heldAcks.begin(), heldAcks.begin() + released);
+                }
+                ackSeen[1 - s] = std::max(ackSeen[1 - s], packet.ack);
+                sessions[1 - s]->receivePacket(packet);
+            }
+        }
+        for (int s = 0; s < 2; s++) {
+            InputPacket packet = sessions[s]->makePacket();
+            if (packet.firstFrame > ackSeen[s] + 1) skipped++;
+            links[s].send(buffer, packet.write(buffer), now);
+        }
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    int tick = 0;
+    // A session that stops resending can deadlock; give up long after the
+    // slowest link could have finished
+    int tickLimit = frames * 20 + 6000;
+    for (; (sessions[0]->frame() < frames || sessions[1]->frame() < frames) && tick < tickLimit; tick++) {
+        double now = tick / 60.0;
+        exchange(now);
+        for (int s = 0; s < 2; s++) {
+            if (sessions[s]->frame() >= frames) continue;
+            // The bot plays its own board with short random pauses, so the
+            // buttons change irregularly like a person's would
+            const VersusGame& game = sessions[s]->state().players[s];
+            uint8_t input = 0;
+            rng = rng * 1664525u + 1013904223u;
+            if (idle[s] > 0) {
+                idle[s]--;
+            } else {
+                if ((rng >> 24) < 8) idle[s] = (int)((rng >> 8) % 20);
+                input = botInput(game.status.piece, findBotMove(game), previous[s]);
+            }
+            if (sessions[s]->advance(input)) previous[s] = input;
+        }
+    }
+    // Let the last inputs through, then settle the final frames
+    for (int i = 0; i < 600 && (sessions[0]->confirmedFrame() < frames - 1 || sessions[1]->confirmedFrame() < frames - 1); i++, tick++)
+        exchange(tick / 60.0);
+    double wall = secondsSince(wallStart);
+
+    std::cout << "rollback: " << frames << " frames, " << latency << " ms round trip, " << loss << "% loss";
+    if (ackDelay > 0) std::cout << ", acks to player 0 held " << ackDelay * 1000 << " ms";
+    std::cout << "\n";
+    for (int s = 0; s < 2; s++) {
+        sessions[s]->resolve();
+        const RollbackStats& st = sessions[s]->stats;
+        std::cout << "  player " << s << ": " << st.rollbacks << " rollbacks, avg depth " << st.averageDepth() << " frames, max "
+                  << st.maxDepth << ", resim " << st.resimUsPerFrame() << " us/frame, stalls " << st.stalls << ", desyncs "
+                  << st.desyncs << ", dropped " << links[s].dropped << "/" << links[s].sent << " packets\n";
+    }
+    const VersusMatch& a = sessions[0]->state();
+    const VersusMatch& b = sessions[1]->state();
+    bool same = a.checksum() == b.checksum();
+    bool finished = a.frame >= frames && b.frame >= frames;
+    std::cout << "  scores " << a.players[0].status.score << " - " << a.players[1].status.score << ", " << (tick / 60.0)
+              << " s simulated in " << wall << " s, final states " << (same ? "match" : "DIFFER")
+              << (finished ? "" : ", STUCK") << ", " << skipped << " packets skipped unacknowledged frames\n";
+    return same && finished && skipped == 0 && sessions[0]->stats.desyncs == 0 && sessions[1]->stats.desyncs == 0 ? 0 : 1;
+}
+
+// Plays bot games through the terminal renderer and replays its output on a
+// minimal terminal emulator, checking after every frame that the emulated
+// screen matches the back buffer. Reports bytes per frame against repainting
+// the whole screen.
+// Options: [frames = 3600]
+static int benchTerminal(int argc, char** argv)
+{
+    int frames = argc > 0 ? atoi(argv[0]) : 3600;
+
+    typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> Game;
+    std::unique_ptr<Game> game(new Game());
+    game->reset(3);
+    TerminalScreen screen(2 * game->width() + 26, game->height() + 2);
+    TerminalScreen full(screen.width(), screen.height());
+    std::vector<TerminalCell> emulated(screen.width() * screen.height(), TerminalCell{ 0, 0, 0 });
+
+    // Understands exactly what present() emits: cursor moves, colors and UTF-8.
+    // Colors persist between frames like on a real terminal.
+    uint8_t fg = 0, bg = 0;
+    auto emulate = [&](const std::string& out) {
+        int x = 0, y = 0;
+        for (size_t i = 0; i < out.size();) {
+            if (out[i] == '\x1b') {
+                size_t end = out.find_first_of("Hm", i);
+                std::vector<int> args;
+                for (size_t j = i + 2; j < end; j = out.find(';', j) + 1) {
+                    args.push_back(atoi(out.c_str() + j));
+                    if (out.find(';', j) > end) break;
+                }
+                if (out[end] == 'H') {
+                    y = args[0] - 1;
+                    x = args[1] - 1;
+                } else {
+                    fg = (uint8_t)args[2];
+                    bg = (uint8_t)args[5];
+                }
+                i = end + 1;
+                continue;
+            }
+            unsigned char c = out[i];
+            char32_t glyph = c;
+            int extra = c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            if (extra) glyph = c & (extra == 2 ? 0x0F : 0x1F);
+            for (int k = 1; k <= extra; k++) glyph = (glyph << 6) | (out[i + k] & 0x3F);
+            i += 1 + extra;
+            emulated[y * screen.width() + x] = TerminalCell{ glyph, fg, bg };
+            x++;
+        }
+    };
+
+    BotMove move = findBotMove(*game);
+    uint8_t previous = 0;
+    uint64_t bytes = 0, fullBytes = 0, maxBytes = 0;
+    int mismatches = 0;
+    std::string out;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        uint8_t input = botInput(game->status.piece, move, previous);
+        previous = input;
+        game->step(input, 1.0f / 60.0f);
+        for (int i = 0; i < game->status.eventCount; i++)
+            if (game->status.events[i].type == EVENT_LOCK) move = findBotMove(*game);
+        if (game->status.gameOver) {
+            game->reset(f);
+            move = findBotMove(*game);
+        }
+
+        drawTerminalGame(screen, *game);
+        out.clear();
+        size_t n = screen.present(out);
+        bytes += n;
+        if (n > maxBytes) maxBytes = n;
+        emulate(out);
+        for (int y = 0; y < screen.height(); y++)
+            for (int x = 0; x < screen.width(); x++)
+                if (emulated[y * screen.width() + x] != screen.at(x, y)) mismatches++;
+
+        drawTerminalGame(full, *game);
+        full.invalidate();
+        out.clear();
+        fullBytes += full.present(out);
+    }
+    double seconds = secondsSince(start);
+
+    std::cout << "terminal: " << frames << " frames, " << (double)bytes / frames << " bytes/frame (max " << maxBytes << "), "
+              << (double)fullBytes / frames << " bytes/frame repainting everything, " << seconds * 1e6 / frames
+              << " us/frame for both, " << mismatches << " mismatched cells\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Deterministic scene for the software renderer: a bot game after the given
+// number of locks, with stars and a burst of effect particles
+typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> SceneGame;
+
+static void buildScene(SceneGame& game, SoftScene& scene, int locks, uint32_t seed)
+{
+    game.reset(seed);
+    uint8_t previous = 0;
+    BotMove move = findBotMove(game);
+    for (int frame = 0; locks > 0 && !game.status.gameOver && frame < 100000; frame++) {
+        uint8_t input = botInput(game.status.piece, move, previous);
+        previous = input;
+        game.step(input, 1.0f / 60.0f);
+        for (int i = 0; i < game.status.eventCount; i++) {
+            if (game.status.events[i].type != EVENT_LOCK) continue;
+            move = findBotMove(game);
+            locks--;
+        }
+    }
+    scene.game = &game;
+    scene.ghostY = game.ghostY();
+    scene.stars.clear();
+    scene.effects.clear();
+    uint32_t rng = seed * 2654435761u + 1;
+    auto next = [&rng]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+    for (int i = 0; i < 50; i++) {
+        scene.stars.push_back((float)(next() % 400));
+        scene.stars.push_back((float)(next() % 520));
+    }
+    for (int i = 0; i < 40; i++)
+        scene.effects.push_back({ 50.0f + next() % 240, 20.0f + next() % 480, rgba(255, 255, next() % 2 ? 255 : 0) });
+}
+
+// Frames per second of the software renderer at several resolutions.
+// Options: [seconds per resolution = 1]
+static int benchRaster(int argc, char** argv)
+{
+    double duration = argc > 0 ? atof(argv[0]) : 1.0;
+    std::unique_ptr<SceneGame> game(new SceneGame());
+    SoftScene scene;
+    buildScene(*game, scene, 40, 9);
+
+    const int sizes[][2] = { { 400, 520 }, { 800, 1040 }, { 1200, 1560 }, { 1600, 2080 } };
+    for (const auto& size : sizes) {
+        Framebuffer fb(size[0], size[1]);
+        int frames = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (secondsSince(start) < duration) {
+            renderTetrisScene(fb, scene);
+            frames++;
+        }
+        double seconds = secondsSince(start);
+        std::cout << "raster " << size[0] << "x" << size[1] << ": " << (int)(frames / seconds) << " fps, "
+                  << seconds * 1e3 / frames << " ms/frame, "
+                  << (double)size[0] * size[1] * frames / seconds / 1e6 << " Mpixel/s cleared\n";
+    }
+    return 0;
+}
+
+// Renders fixed scenes and compares them with the PPM images in a directory
+// (tests/golden holds the reference ones), writing a *_diff.ppm for each
+// mismatch. A missing image fails; "update" writes all of them after an
+// intended rendering change.
+// Options: <directory> [update]
+static int benchGolden(int argc, char** argv)
+{
+    if (argc < 1) {
+        std::cout << "golden: needs the image directory\n";
+        return 1;
+    }
+    std::string dir = argv[0];
+    bool update = argc > 1 && strcmp(argv[1], "update") == 0;
+
+    struct GoldenScene {
+        const char* name;
+        int locks;
+        uint32_t seed;
+        int width, height;
+    };
+    const GoldenScene scenes[] = {
+        { "start", 0, 1, 400, 520 },
+        { "midgame", 30, 2, 400, 520 },
+        { "midgame_2x", 30, 2, 800, 1040 },
+        { "late", 120, 3, 400, 520 },
+    };
+    std::unique_ptr<SceneGame> game(new SceneGame());
+    int failures = 0;
+    for (const auto& g : scenes) {
+        SoftScene scene;
+        buildScene(*game, scene, g.locks, g.seed);
+        Framebuffer frame(g.width, g.height);
+        renderTetrisScene(frame, scene);
+
+        std::string path = dir + "/" + g.name + ".ppm";
+        if (update) {
+            bool saved = frame.savePpm(path);
+            std::cout << "  " << g.name << ": " << (saved ? "written" : "could not write") << " " << path << "\n";
+            if (!saved) failures++;
+            continue;
+        }
+        Framebuffer golden(1, 1);
+        if (!golden.loadPpm(path)) {
+            std::cout << "  " << g.name << ": MISSING " << path << " (run with update to create it)\n";
+            failures++;
+            continue;
+        }
+        Framebuffer diff(1, 1);
+        long differing = compareImages(frame, golden, 0, &diff);
+        std::cout << "  " << g.name << ": " << (differing ? "DIFFERS" : "matches") << " (" << differing << " pixels)\n";
+        if (differing) {
+            diff.savePpm(dir + "/" + g.name + "_diff.ppm");
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+// Records software rendered frames through the capture ring as fast as the
+// game would produce them (or faster), checking the vectorized color
+// conversion against the plain formula first.
+// Options: [output file = capture.y4m] [frames = 600] [frames per second, 0 = unlimited = 60]
+static int benchCapture(int argc, char** argv)
+{
+    std::string path = argc > 0 ? argv[0] : "capture.y4m";
+    int frames = argc > 1 ? atoi(argv[1]) : 600;
+    double fps = argc > 2 ? atof(argv[2]) : 60.0;
+
+    // Conversion check on random pixels with an odd tail
+    std::vector<uint8_t> pixels(1003 * 4), luma(1003);
+    uint32_t rng = 99;
+    for (auto& p : pixels) {
+        rng = rng * 1664525u + 1013904223u;
+        p = (uint8_t)(rng >> 24);
+    }
+    rgbaToLuma(pixels.data(), luma.data(), 1003);
+    for (int x = 0; x < 1003; x++) {
+        const uint8_t* p = &pixels[x * 4];
+        if (luma[x] != (77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8) {
+            std::cout << "capture: luma conversion differs at pixel " << x << "\n";
+            return 1;
+        }
+    }
+
+    std::unique_ptr<SceneGame> game(new SceneGame());
+    SoftScene scene;
+    buildScene(*game, scene, 0, 4);
+    uint8_t previous = 0;
+    BotMove move = findBotMove(*game);
+    Framebuffer fb(400, 520);
+    {
+        FrameCapture capture(path, fb.width, fb.height);
+        if (!capture.isOpen()) {
+            std::cout << "capture: could not open " << path << "\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            uint8_t input = botInput(game->status.piece, move, previous);
+            previous = input;
+            game->step(input, 1.0f / 60.0f);
+            for (int i = 0; i < game->status.eventCount; i++)
+                if (game->status.events[i].type == EVENT_LOCK) move = findBotMove(*game);
+            if (game->status.gameOver) game->reset(f);
+            scene.ghostY = game->ghostY();
+            renderTetrisScene(fb, scene);
+
+            // What the game thread pays: one copy into a free slot
+            auto submitStart = std::chrono::steady_clock::now();
+            uint8_t* slot = capture.beginFrame();
+            if (slot) {
+                std::memcpy(slot, fb.pixels.data(), fb.pixels.size() * 4);
+                capture.endFrame(false);
+            }
+            capture.addSubmitTime(secondsSince(submitStart));
+            if (fps > 0) std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)((f + 1) * 1e6 / fps)));
+        }
+        capture.finish();
+        std::cout << capture.report() << "\n";
+    }
+    std::cout << "  written to " << path << "\n";
+    return 0;
+}
+
+// Cost of one log call on the game thread: the asynchronous logger against a
+// stream line ending in std::endl, both with a position line like the one the
+// physics demo printed every frame. Calls are timed in bursts that fit the
+// ring, with the logger drained (untimed) in between.
+// Options: [calls = 200000] [threads = 4]
+static int benchLog(int argc, char** argv)
+{
+    int calls = argc > 0 ? atoi(argv[0]) : 200000;
+    int threadCount = argc > 1 ? atoi(argv[1]) : 4;
+    const int burst = Logger::kRingSize / 2;
+    const char* logPath = "bench_log.tmp";
+    const char* streamPath = "bench_stream.tmp";
+
+    Logger& log = Logger::instance();
+    log.open(logPath);
+    log.setRateLimit(0);
+
+    // Each thread logs bursts; the total time covers only the calls
+    auto timeLogger = [&](int threads) {
+        std::vector<double> seconds(threads, 0.0);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back([&, t]() {
+                float x = 400.0f, y = 300.0f;
+                for (int done = 0; done < calls; done += burst) {
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < burst; i++) {
+                        y += 0.1f;
+                        LOG_INFO("ball position: {}, {} (thread {})", x, y, t);
+                    }
+                    seconds[t] += secondsSince(start);
+                    Logger::instance().flush();
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+        double total = 0.0;
+        for (double s : seconds) total += s;
+        return total / threads;
+    };
+
+    uint64_t droppedBefore = log.dropped.load();
+    double loggerSeconds = timeLogger(1);
+    double loggerThreadedSeconds = timeLogger(threadCount);
+    log.flush();
+
+    double streamSeconds;
+    {
+        std::ofstream stream(streamPath);
+        float x = 400.0f, y = 300.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) {
+            y += 0.1f;
+            stream << "ball position: " << x << ", " << y << std::endl;
+        }
+        streamSeconds = secondsSince(start);
+    }
+    double perCall = 1e9 / ((calls + burst - 1) / burst * burst);
+    std::cout << "log: " << loggerSeconds * perCall << " ns/call (" << threadCount << " threads: "
+              << loggerThreadedSeconds * perCall << " ns/call each), std::endl stream " << streamSeconds * 1e9 / calls
+              << " ns/call, " << log.written.load() << " records written, " << log.dropped.load() - droppedBefore << " dropped\n";
+    std::remove(logPath);
+    std::remove(streamPath);
+    return 0;
+}
+
+#ifndef _WIN32
+// Checks a scrape against the Prometheus text format: HELP and TYPE before
+// the samples of each family, families not split, valid names and labels,
+// numeric values, cumulative histogram buckets ending in +Inf == _count.
+static bool checkPrometheusText(const std::string& text, std::string& error)
+{
+    auto validName = [](const std::string& n) {
+        if (n.empty() || !(isalpha((unsigned char)n[0]) || n[0] == '_' || n[0] == ':')) return false;
+        for (char c : n)
+            if (!(isalnum((unsigned char)c) || c == '_' || c == ':')) return false;
+        return true;
+    };
+    std::vector<std::string> seenFamilies;
+    std::string family, familyType;
+    double lastBucket = -1.0;
+    bool sawInf = false;
+    double infCount = 0.0;
+    int lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) {
+            error = "missing final newline";
+            return false;
+        }
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        lineNumber++;
+        auto fail = [&](const std::string& why) {
+            error = "line " + std::to_string(lineNumber) + ": " + why + ": " + line;
+            return false;
+        };
+        if (line.compare(0, 7, "# HELP ") == 0) {
+            std::string name = line.substr(7, line.find(' ', 7) - 7);
+            if (!validName(name)) return fail("bad metric name");
+            for (const auto& f : seenFamilies)
+                if (f == name) return fail("family split or repeated");
+            seenFamilies.push_back(name);
+            family = name;
+            familyType.clear();
+            lastBucket = -1.0;
+            sawInf = false;
+            continue;
+        }
+        if (line.compare(0, 7, "# TYPE ") == 0) {
+            size_t space = line.find(' ', 7);
+            if (space == std::string::npos || line.substr(7, space - 7) != family) return fail("TYPE without HELP");
+            familyType = line.substr(space + 1);
+            if (familyType != "counter" && familyType != "gauge" && familyType != "histogram") return fail("unknown type");
+            continue;
+        }
+        if (familyType.empty()) return fail("sample before TYPE");
+
+        size_t nameEnd = line.find_first_of("{ ");
+        if (nameEnd == std::string::npos) return fail("no value");
+        std::string name = line.substr(0, nameEnd);
+        std::string suffix = name.size() > family.size() ? name.substr(family.size()) : "";
+        if (name.compare(0, family.size(), family) != 0 ||
+            !(name == family || (familyType == "histogram" && (suffix == "_bucket" || suffix == "_sum" || suffix == "_count"))))
+            return fail("sample outside its family");
+        if (familyType == "histogram" && name == family) return fail("histogram sample without suffix");
+        std::string le;
+        size_t valueStart = nameEnd;
+        if (line[nameEnd] == '{') {
+            size_t close = line.find('}', nameEnd);
+            if (close == std::string::npos) return fail("unterminated labels");
+            std::string labels = line.substr(nameEnd + 1, close - nameEnd - 1);
+            size_t l = 0;
+            while (l < labels.size()) {
+                size_t eq = labels.find('=', l);
+                if (eq == std::string::npos || !validName(labels.substr(l, eq - l)) || eq + 1 >= labels.size() || labels[eq + 1] != '"')
+                    return fail("bad label");
+                size_t quote = labels.find('"', eq + 2);
+                if (quote == std::string::npos) return fail("unterminated label value");
+                if (labels.substr(l, eq - l) == "le") le = labels.substr(eq + 2, quote - eq - 2);
+                l = quote + 1;
+                if (l < labels.size()) {
+                    if (labels[l] != ',') return fail("labels not comma separated");
+                    l++;
+                }
+            }
+            valueStart = close + 1;
+        }
+        if (valueStart >= line.size() || line[valueStart] != ' ') return fail("no value");
+        std::string valueText = line.substr(valueStart + 1);
+        char* parsedEnd = nullptr;
+        double value = strtod(valueText.c_str(), &parsedEnd);
+        if (valueText.empty() || *parsedEnd != '\0') return fail("value is not a number");
+
+        if (suffix == "_bucket") {
+            if (le.empty()) return fail("bucket without le");
+            if (sawInf) return fail("bucket after +Inf");
+            if (value < lastBucket) return fail("buckets not cumulative");
+            lastBucket = value;
+            if (le == "+Inf") {
+                sawInf = true;
+                infCount = value;
+            }
+        } else if (suffix == "_count") {
+            if (!sawInf) return fail("histogram without +Inf bucket");
+            if (value != infCount) return fail("_count differs from the +Inf bucket");
+        }
+    }
+    return true;
+}
+
+// Plain HTTP GET from the embedded listener
+static bool scrape(int port, const char* path, std::string& response)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    std::string request = std::string("GET ") + path + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    response.clear();
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, (size_t)n);
+    close(fd);
+    return true;
+}
+#endif
+
+// Metrics registry: the cost of recording every step of bot games, the tick
+// count at a high frame rate and after a stall, and a local scrape of the
+// HTTP endpoint checked against the text format.
+// Options: [pieces = 20000]
+static int benchMetrics(int argc, char** argv)
+{
+    int pieces = argc > 0 ? atoi(argv[0]) : 20000;
+
+    GameMetrics metrics;
+    FrameMetrics frames;
+    std::unique_ptr<SceneGame> game(new SceneGame());
+    uint64_t checksum = 0;
+    double plain = runBotGames(*game, pieces, 11, checksum);
+    game->reset(11);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pieces; i++) {
+        if (game->status.gameOver) game->reset(11 + i);
+        BotMove move = findBotMove(*game);
+        game->place(move.rotation, move.x);
+        metrics.record(game->status);
+        frames.frameSeconds.observe(0.001 * (i % 20));
+        frames.particles.set(i % 100);
+    }
+    double recorded = pieces / secondsSince(start);
+
+    // The tick counter follows simulated time, not frames: two seconds at
+    // 144 frames per second, then a one second stall
+    game->reset(12);
+    const uint64_t ticksBefore = metrics.ticks.value.load();
+    for (int f = 0; f < 288; f++) {
+        game->step(0, 1.0f / 144.0f);
+        metrics.record(game->status);
+    }
+    game->step(0, 1.0f);
+    metrics.record(game->status);
+    const uint64_t ticked = metrics.ticks.value.load() - ticksBefore;
+    const uint64_t expected = 2 * kTicksPerSecond + SceneGame::kMaxTicksPerStep;
+    if (ticked + 1 < expected || ticked > expected + 1) {
+        std::cout << "metrics: " << ticked << " ticks counted, expected " << expected << "\n";
+        return 1;
+    }
+
+    const int adds = 10000000;
+    MetricCounter& counter = MetricsRegistry::instance().counter("bench_adds_total", "Counter adds made by the benchmark");
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < adds; i++) counter.add();
+    double addNs = secondsSince(start) * 1e9 / adds;
+    std::cout << "metrics: " << plain << " pieces/s plain, " << recorded << " pieces/s recorded, counter add " << addNs
+              << " ns\n";
+
+#ifndef _WIN32
+    MetricsServer server;
+    if (!server.start(0)) {
+        std::cout << "metrics: could not open a local port\n";
+        return 1;
+    }
+    std::string response, error;
+    if (!scrape(server.port(), "/metrics", response)) {
+        std::cout << "metrics: scrape failed\n";
+        return 1;
+    }
+    size_t bodyStart = response.find("\r\n\r\n");
+    bool ok = response.compare(0, 15, "HTTP/1.0 200 OK") == 0 && bodyStart != std::string::npos &&
+              response.find("Content-Type: text/plain; version=0.0.4") != std::string::npos;
+    std::string body = ok ? response.substr(bodyStart + 4) : "";
+    if (!ok) error = "bad response header";
+    else if (!checkPrometheusText(body, error)) ok = false;
+    else if (body.find("tetris_pieces_locked_total " + std::to_string(metrics.piecesLocked.value.load())) == std::string::npos)
+        ok = false, error = "locked piece count missing";
+    std::string notFound;
+    if (ok && (!scrape(server.port(), "/", notFound) || notFound.compare(0, 12, "HTTP/1.0 404") != 0))
+        ok = false, error = "unknown path not answered with 404";
+    std::cout << "scrape: " << body.size() << " bytes, " << (ok ? "format ok" : "FAILED: " + error) << "\n";
+    return ok ? 0 : 1;
+#else
+    return 0;
+#endif
+}
+
+// Score store: add() cost on the calling thread while the worker writes,
+// top-N and rank queries over the whole log, reopening (index plus tail),
+// and a writer process killed with SIGKILL in the middle of its writes.
+// Options: [records = 1000000] [file = bench_scores.tmp]
+static int benchScores(int argc, char** argv)
+{
+#ifndef _WIN32
+    int records = argc > 0 ? atoi(argv[0]) : 1000000;
+    std::string path = argc > 1 ? argv[1] : "bench_scores.tmp";
+    auto removeFiles = [&]() {
+        std::remove(path.c_str());
+        std::remove((path + ".idx").c_str());
+    };
+    removeFiles();
+
+    uint32_t rng = 12345;
+    auto randomRecord = [&](int i) {
+        ScoreRecord r;
+        rng = rng * 1664525u + 1013904223u;
+        r.score = (int32_t)(rng >> 12);
+        r.lines = r.score / 1000;
+        r.level = r.lines / 10 + 1;
+        r.time = 1700000000u + i;
+        r.flags = SCORE_BOT;
+        r.setMode("standard");
+        return r;
+    };
+
+    // Bulk: bot farm rate, the worker competes with the caller for the CPU.
+    // Paced: one game over per frame, the case the game loop cares about.
+    int slowAdds = 0;
+    double worstPacedUs = 0.0;
+    double addSeconds, flushSeconds, topUs, rankUs;
+    uint64_t compactions, syncs;
+    {
+        ScoreStore store;
+        if (!store.open(path)) {
+            std::cout << "scores: cannot open " << path << "\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < records; i++) {
+            auto t = std::chrono::steady_clock::now();
+            store.add(randomRecord(i));
+            if (secondsSince(t) > 0.001) slowAdds++;
+        }
+        addSeconds = secondsSince(start);
+        store.flush();
+        flushSeconds = secondsSince(start);
+        for (int i = 0; i < 200; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(2000));
+            auto t = std::chrono::steady_clock::now();
+            store.add(randomRecord(records + i));
+            worstPacedUs = std::max(worstPacedUs, secondsSince(t) * 1e6);
+        }
+        store.flush();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<ScoreRecord> best = store.top(10);
+        topUs = secondsSince(start) * 1e6;
+        start = std::chrono::steady_clock::now();
+        uint64_t rank = store.rank(best.empty() ? 0 : best.back().score);
+        rankUs = secondsSince(start) * 1e6;
+        if (best.size() != 10 || rank > 10) {
+            std::cout << "scores: FAILED top/rank (" << best.size() << " results, rank " << rank << ")\n";
+            return 1;
+        }
+        compactions = store.compactions.load();
+        syncs = store.syncs.load();
+    }
+    std::cout << "scores: " << records << " adds, " << addSeconds * 1e9 / records << " ns/add avg, " << slowAdds
+              << " over 1 ms, written after " << flushSeconds << " s (" << syncs << " syncs, " << compactions << " compactions)\n";
+    std::cout << "paced: 200 adds 2 ms apart, worst " << worstPacedUs << " us\n";
+    std::cout << "queries: top 10 in " << topUs << " us, rank in " << rankUs << " us\n";
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t reopened;
+    {
+        ScoreStore store;
+        store.open(path);
+        reopened = store.count();
+    }
+    std::cout << "reopen: " << reopened << " records in " << secondsSince(start) * 1000.0 << " ms\n";
+    if (reopened != (uint64_t)records + 200) {
+        std::cout << "scores: FAILED, expected " << records + 200 << " records\n";
+        return 1;
+    }
+
+    // A child keeps adding records until it is killed; whatever reached the
+    // file must come back intact, with at most one torn record dropped
+    removeFiles();
+    pid_t child = fork();
+    if (child == 0) {
+        ScoreStore store;
+        store.open(path);
+        for (int i = 0;; i++) store.add(randomRecord(i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    ScoreStore store;
+    bool ok = store.open(path);
+    uint64_t survived = store.count();
+    std::vector<ScoreRecord> recent = store.recent(1000);
+    for (const auto& r : recent)
+        if (r.magic != ScoreStore::kRecordMagic || r.checksum != r.computeChecksum()) ok = false;
+    std::cout << "killed writer: " << survived << " records intact, " << store.recovered << " torn record dropped, "
+              << (ok && survived > 0 ? "ok" : "FAILED") << "\n";
+    store.close();
+    removeFiles();
+    return ok && survived > 0 ? 0 : 1;
+#else
+    (void)argc;
+    (void)argv;
+    std::cout << "scores: the score store needs POSIX mmap\n";
+    return 0;
+#endif
+}
+
+// Profile-guided build report: runs the baseline and the release game
+// binaries on the same seeded bot games (tetris --train) a few times each,
+// alternating, and compares the best time per frame. The checksums of the
+// final scores must match, or the builds did not play the same games.
+// Options: <baseline exe> <release exe> [games = 20] [runs = 3]
+static int benchPgo(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cout << "pgo: needs the baseline and the release executables\n";
+        return 1;
+    }
+    int games = argc > 2 ? atoi(argv[2]) : 20;
+    int runs = argc > 3 ? atoi(argv[3]) : 3;
+
+    struct TrainResult {
+        int games = 0;
+        unsigned long long frames = 0, checksum = 0;
+        double seconds = 0.0, usPerFrame = 0.0;
+    };
+    auto train = [&](const char* exe, TrainResult& result) {
+        std::string command = std::string(exe) + " --train " + std::to_string(games);
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) return false;
+        char line[256];
+        bool found = false;
+        while (fgets(line, sizeof(line), pipe)) {
+            if (sscanf(line, "train: %d games, %llu frames, %lf s, %lf us/frame, checksum %llx", &result.games, &result.frames,
+                       &result.seconds, &result.usPerFrame, &result.checksum) == 5)
+                found = true;
+        }
+        return pclose(pipe) == 0 && found;
+    };
+
+    TrainResult best[2];
+    for (int run = 0; run < runs; run++) {
+        for (int b = 0; b < 2; b++) {
+            TrainResult result;
+            if (!train(argv[b], result)) {
+                std::cout << "pgo: " << argv[b] << " --train failed\n";
+                return 1;
+            }
+            if (run == 0 || result.usPerFrame < best[b].usPerFrame) best[b] = result;
+        }
+    }
+    const char* names[] = { "baseline", "release" };
+    for (int b = 0; b < 2; b++) {
+        printf("%-8s %-32s %llu frames, %.1f us/frame, %.0f frames/s, checksum %016llx\n", names[b], argv[b], best[b].frames,
+               best[b].usPerFrame, best[b].usPerFrame > 0.0 ? 1e6 / best[b].usPerFrame : 0.0, best[b].checksum);
+    }
+    bool same = best[0].checksum == best[1].checksum && best[0].frames == best[1].frames;
+    printf("speedup: %.2fx per frame, %s\n", best[1].usPerFrame > 0.0 ? best[0].usPerFrame / best[1].usPerFrame : 0.0,
+           same ? "same games played" : "GAMES DIFFER");
+    return same ? 0 : 1;
+}
+
+// Debris physics under the worst bursts the game produces: a four-line clear
+// and a Fire explosion every few frames, on the standard field geometry.
+// Reports the update cost per frame against the 60 Hz budget and how many
+// blocks the pool had to skip.
+// Options: [seconds = 10] [burst every N frames = 15]
+static int benchDebris(int argc, char** argv)
+{
+    float seconds = argc > 0 ? (float)atof(argv[0]) : 10.0f;
+    int every = argc > 1 ? std::max(1, atoi(argv[1])) : 15;
+    const int blockSize = 24, offsetX = 50, offsetY = 20, width = 10, height = 20;
+    const float dt = 1.0f / 60.0f;
+    DebrisField debris((float)blockSize, 0.0f, 400.0f, (float)(offsetY + height * blockSize));
+
+    srand(1);
+    auto cellCenter = [&](int x, int y, float& cx, float& cy) {
+        cx = x * blockSize + offsetX + blockSize / 2.0f;
+        cy = y * blockSize + offsetY + blockSize / 2.0f;
+    };
+    int frames = (int)(seconds * 60.0f);
+    int spawned = 0, peak = 0;
+    double total = 0.0, worst = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        if (frame % every == 0) {
+            float cx, cy;
+            for (int y = height - 4; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    cellCenter(x, y, cx, cy);
+                    float side = (x - width / 2 + 0.5f) / width;
+                    spawned += debris.spawn(cx, cy, sf::Color::Cyan, side * 400.0f + (rand() % 101 - 50), -250.0f - rand() % 200,
+                                            (rand() % 1201 - 600) / 100.0f);
+                }
+            }
+            int fx = rand() % width, fy = height / 2 + rand() % (height / 2);
+            for (int y = fy - 1; y <= fy + 1; y++) {
+                for (int x = fx - 1; x <= fx + 1; x++) {
+                    if (x < 0 || x >= width || y >= height) continue;
+                    cellCenter(x, y, cx, cy);
+                    spawned += debris.spawn(cx, cy, sf::Color::Red, (x - fx) * 150.0f, -300.0f + (y - fy) * 100.0f, 4.0f);
+                }
+            }
+        }
+        debris.update(dt);
+        double frameSeconds = secondsSince(start);
+        total += frameSeconds;
+        worst = std::max(worst, frameSeconds);
+        peak = std::max(peak, debris.count());
+    }
+    std::cout << "debris: " << frames << " frames, " << spawned << " blocks spawned, " << debris.dropped
+              << " skipped (pool " << DebrisField::kMaxDebris << "), peak " << peak << " live\n"
+              << "update: mean " << total / frames * 1000.0 << " ms, worst " << worst * 1000.0 << " ms ("
+              << worst / dt * 100.0 << "% of a 60 Hz frame)\n";
+    return worst < dt ? 0 : 1;
+}
+
+// Drops a grid of balls into a box (a Suelo floor and two walls) and times
+// each step under several broadphase and solver settings: the default BB
+// tree, the spatial hash, and the threaded solver at 1, 2, 4... threads.
+// Contacts per second is contact points after each step over step time.
+// Options: [ball counts = 1000,5000,20000,50000] [steps = 120] [iterations = 10] [substeps = 1]
+static int benchPhysics(int argc, char** argv)
+{
+    std::vector<int> counts;
+    const char* list = argc > 0 ? argv[0] : "1000,5000,20000,50000";
+    for (const char* p = list; *p;) {
+        counts.push_back(atoi(p));
+        p = strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+    int steps = argc > 1 ? atoi(argv[1]) : 120;
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    int substeps = argc > 3 ? atoi(argv[3]) : 1;
+    int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    const float radius = 4.0f;
+    const cpFloat dt = 1.0 / 60.0;
+
+    struct Config {
+        std::string name;
+        Broadphase broadphase;
+        int threads;
+    };
+    std::vector<Config> configs = { { "bbtree", BROADPHASE_BBTREE, 0 }, { "hash", BROADPHASE_SPATIAL_HASH, 0 } };
+    for (int t = 1; t <= maxThreads; t *= 2) configs.push_back({ "hash x" + std::to_string(t) + " threads", BROADPHASE_SPATIAL_HASH, t });
+    if ((maxThreads & (maxThreads - 1)) != 0)
+        configs.push_back({ "hash x" + std::to_string(maxThreads) + " threads", BROADPHASE_SPATIAL_HASH, maxThreads });
+
+    std::cout << "physics: " << steps << " steps of " << dt * 1000.0 << " ms, " << iterations << " iterations, " << substeps
+              << " substeps, up to " << maxThreads << " threads\n";
+    for (int count : counts) {
+        // A box about twice as wide as the settled pile is tall
+        int columns = std::max(10, (int)(std::sqrt((double)count) * 2.0));
+        int rows = (count + columns - 1) / columns;
+        float spacing = radius * 2.5f;
+        float width = columns * spacing + spacing;
+        float floorY = rows * spacing + 100.0f;
+        double singleThread = 0.0;
+        for (const Config& config : configs) {
+            PhysicsSettings settings;
+            settings.broadphase = config.broadphase;
+            settings.hashCellSize = radius * 2.0f;
+            settings.hashCells = count * 10;
+            settings.iterations = iterations;
+            settings.substeps = substeps;
+            settings.threads = config.threads;
+
+            // Declared after the space, so they are detached before it is freed
+            PhysicsSpace physics(settings);
+            Suelo floor(physics.getSpace(), cpv(0, floorY), cpv(width, floorY));
+            Suelo left(physics.getSpace(), cpv(0, -1000), cpv(0, floorY));
+            Suelo right(physics.getSpace(), cpv(width, -1000), cpv(width, floorY));
+            std::vector<std::unique_ptr<Ball>> balls;
+            srand(1);
+            balls.reserve(count);
+            for (int i = 0; i < count; i++) {
+                float jitter = (rand() % 100) / 100.0f;
+                cpVect position = cpv(spacing + (i % columns) * spacing + jitter, floorY - 50.0f - (i / columns) * spacing);
+                balls.emplace_back(new Ball(physics.getSpace(), radius, 1.0f, position));
+            }
+
+            double total = 0.0, worst = 0.0;
+            uint64_t contacts = 0;
+            for (int i = 0; i < steps; i++) {
+                auto start = std::chrono::steady_clock::now();
+                physics.step(dt);
+                double seconds = secondsSince(start);
+                total += seconds;
+                worst = std::max(worst, seconds);
+                contacts += physics.contactCount();
+            }
+            if (config.threads == 1) singleThread = total;
+            std::cout << "  " << count << " balls, " << config.name << ": step " << total / steps * 1000.0 << " ms (worst "
+                      << worst * 1000.0 << " ms), " << contacts / steps << " contacts, " << contacts / total / 1e6
+                      << " M contacts/s";
+            if (config.threads > 1 && singleThread > 0.0) std::cout << ", " << singleThread / total << "x vs 1 thread";
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
+
+// Thousands of falling circles as entities of a PhysicsEntityStore: per
+// frame one step, one sync pass and one vertex array, with some entities
+// destroyed and created each frame through their handles. The same scene
+// with Ball objects, positioned one by one through GetShape(), is timed for
+// comparison. Stale handles must be rejected after their slot is reused, and
+// the churn must reuse the bodies reserve() made instead of making more.
+// Options: [entities = 5000] [frames = 300] [replaced per frame = 20]
+static int benchEntities(int argc, char** argv)
+{
+    int count = argc > 0 ? atoi(argv[0]) : 5000;
+    int frames = argc > 1 ? atoi(argv[1]) : 300;
+    int churn = argc > 2 ? atoi(argv[2]) : 20;
+    const float radius = 4.0f;
+    const cpFloat dt = 1.0 / 60.0;
+    int columns = std::max(10, (int)(std::sqrt((double)count) * 2.0));
+    float spacing = radius * 2.5f;
+    float width = columns * spacing + spacing;
+    float floorY = (count / columns + 1) * spacing + 100.0f;
+    auto spawnPosition = [&](int i) {
+        return cpv(spacing + (i % columns) * spacing + (rand() % 100) / 100.0f, floorY - 50.0f - (i / columns) * spacing);
+    };
+    PhysicsSettings settings;
+    settings.broadphase = BROADPHASE_SPATIAL_HASH;
+    settings.hashCellSize = radius * 2.0f;
+    settings.hashCells = count * 10;
+
+    double storeStep = 0.0, storeSync = 0.0, storeWorst = 0.0;
+    size_t vertexCount = 0;
+    bool handlesOk = true, pooled = false;
+    {
+        PhysicsSpace physics(settings);
+        Suelo floor(physics.getSpace(), cpv(0, floorY), cpv(width, floorY));
+        PhysicsEntityStore store(physics.getSpace());
+        store.reserve(count);
+        srand(1);
+        std::vector<EntityHandle> handles;
+        for (int i = 0; i < count; i++)
+            handles.push_back(store.create(radius, 1.0f, spawnPosition(i), sf::Color(rand() % 256, rand() % 256, 255)));
+
+        for (int frame = 0; frame < frames; frame++) {
+            for (int i = 0; i < churn; i++) {
+                int victim = rand() % count;
+                EntityHandle old = handles[victim];
+                store.destroy(old);
+                handles[victim] = store.create(radius, 1.0f, spawnPosition(victim % columns), sf::Color::White);
+                // The new entity took the old slot, the old handle must not reach it
+                if (store.alive(old) || store.body(old) || store.destroy(old)) handlesOk = false;
+            }
+            auto start = std::chrono::steady_clock::now();
+            physics.step(dt);
+            double stepSeconds = secondsSince(start);
+            store.sync();
+            vertexCount = store.buildVertices().size();
+            double frameSeconds = secondsSince(start);
+            storeStep += stepSeconds;
+            storeSync += frameSeconds - stepSeconds;
+            storeWorst = std::max(storeWorst, frameSeconds);
+        }
+        for (const EntityHandle& h : handles) {
+            if (!store.alive(h)) handlesOk = false;
+        }
+        if (store.count() != (size_t)count) handlesOk = false;
+        pooled = store.capacity() == (size_t)count;
+    }
+
+    double ballStep = 0.0, ballSync = 0.0;
+    {
+        PhysicsSpace physics(settings);
+        Suelo floor(physics.getSpace(), cpv(0, floorY), cpv(width, floorY));
+        std::vector<std::unique_ptr<Ball>> balls;
+        srand(1);
+        for (int i = 0; i < count; i++) balls.emplace_back(new Ball(physics.getSpace(), radius, 1.0f, spawnPosition(i)));
+        std::vector<sf::Vector2f> positions(count);
+        for (int frame = 0; frame < frames; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            physics.step(dt);
+            double stepSeconds = secondsSince(start);
+            for (int i = 0; i < count; i++) positions[i] = balls[i]->GetShape().getPosition();
+            ballStep += stepSeconds;
+            ballSync += secondsSince(start) - stepSeconds;
+        }
+    }
+
+    std::cout << "entities: " << count << " circles, " << frames << " frames, " << churn << " replaced per frame, "
+              << vertexCount << " vertices\n"
+              << "store: step " << storeStep / frames * 1000.0 << " ms, sync + vertices " << storeSync / frames * 1000.0
+              << " ms, worst frame " << storeWorst * 1000.0 << " ms\n"
+              << "balls: step " << ballStep / frames * 1000.0 << " ms, GetShape for each " << ballSync / frames * 1000.0
+              << " ms (plus one draw call per ball)\n"
+              << "handles: " << (handlesOk ? "ok" : "FAILED") << ", bodies "
+              << (pooled ? "reused" : "FAILED: allocated during the churn") << "\n";
+    return handlesOk && pooled ? 0 : 1;
+}
+
+// Animated sprites from the example sheets, drawn the way the sprite
+// examples did (an sf::Sprite and an sf::Clock each, one draw call per
+// sprite) and through SpriteAtlas + SpriteBatch (one draw call). Frames go
+// to an offscreen render texture; the frame time includes waiting for the
+// GPU, since the last frame is read back before the clock stops.
+// Options: [sprites = 10000] [frames = 200]
+static int benchSprites(int argc, char** argv)
+{
+    int count = argc > 0 ? atoi(argv[0]) : 10000;
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    const unsigned width = 1280, height = 720;
+
+    SpriteAtlas atlas;
+    sf::Clock packing;
+    if (!addSpriteSheets(atlas) || !atlas.pack()) {
+        std::cerr << "cannot pack assets/images (run from the repository root, with a display)\n";
+        return 1;
+    }
+    float packMs = packing.getElapsedTime().asSeconds() * 1000.0f;
+    sf::RenderTexture target;
+    if (!target.create(width, height)) {
+        std::cerr << "cannot create a render texture\n";
+        return 1;
+    }
+
+    SpriteBatch batch(atlas);
+    const int run = batch.addClip(AnimationClip::fromAtlas(atlas, "pikachu_run", 0.1f));
+    const int stance = batch.addClip(AnimationClip::fromAtlas(atlas, "ken_stance", 0.15f));
+    batch.reserve(count);
+    srand(1);
+    std::vector<sf::Vector2f> positions(count);
+    std::vector<float> starts(count);
+    for (int i = 0; i < count; i++) {
+        positions[i] = sf::Vector2f((float)(rand() % width), (float)(rand() % height));
+        starts[i] = (rand() % 1000) / 1000.0f;
+    }
+    const float dt = 1.0f / 60.0f;
+
+    // Per sprite: the texture rectangle picked by each sprite's own timer,
+    // as in archive_examples/03_1_Pikachu.cpp
+    struct Animated {
+        sf::Sprite sprite;
+        sf::Clock clock;
+        int frame;
+    };
+    std::vector<Animated> sprites(count);
+    for (int i = 0; i < count; i++) {
+        sprites[i].sprite.setTexture(atlas.getTexture());
+        sprites[i].sprite.setPosition(positions[i]);
+        sprites[i].frame = i % 4;
+    }
+    double spriteUpdate = 0.0;
+    uint64_t spriteCalls = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        auto update = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++) {
+            Animated& a = sprites[i];
+            const AnimationClip& clip = batch.clip(i % 4 == 0 ? stance : run);
+            if (a.clock.getElapsedTime().asSeconds() >= clip.frameSeconds) {
+                a.frame = (a.frame + 1) % (int)clip.frames.size();
+                a.clock.restart();
+            }
+            a.sprite.setTextureRect(atlas.rect(clip.frames[a.frame]));
+            a.sprite.move(i % 4 == 0 ? 0.0f : 60.0f * dt, 0.0f);
+        }
+        spriteUpdate += secondsSince(update);
+        target.clear();
+        for (const Animated& a : sprites) {
+            target.draw(a.sprite);
+            spriteCalls++;
+        }
+        target.display();
+    }
+    target.getTexture().copyToImage();
+    double spriteSeconds = secondsSince(start);
+
+    double batchBuild = 0.0;
+    uint64_t batchCalls = 0;
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        auto update = std::chrono::steady_clock::now();
+        batch.setTime(frame * dt);
+        batch.clear();
+        for (int i = 0; i < count; i++) {
+            bool ken = i % 4 == 0;
+            if (!ken) positions[i].x += 60.0f * dt;
+            batch.addAnimated(ken ? stance : run, starts[i], positions[i], ken ? 0 : 1);
+        }
+        batch.build();
+        batchBuild += secondsSince(update);
+        target.clear();
+        batch.draw(target);
+        batchCalls++;
+        target.display();
+    }
+    target.getTexture().copyToImage();
+    double batchSeconds = secondsSince(start);
+
+    std::cout << "sprites: " << count << " animated, " << frames << " frames at " << width << "x" << height << ", atlas "
+              << atlas.getTexture().getSize().x << "x" << atlas.getTexture().getSize().y << " with " << atlas.size()
+              << " frames packed in " << packMs << " ms\n"
+              << "  sf::Sprite each: " << spriteCalls / frames << " draw calls, " << spriteSeconds / frames * 1000.0
+              << " ms per frame (animation update " << spriteUpdate / frames * 1000.0 << " ms)\n"
+              << "  SpriteBatch:     " << batchCalls / frames << " draw call, " << batchSeconds / frames * 1000.0
+              << " ms per frame (animation, layer sort and vertices " << batchBuild / frames * 1000.0 << " ms) ("
+              << spriteSeconds / batchSeconds << "x)\n";
+    return 0;
+}
+
+// archive_examples/08_Tron.cpp's algorithm with the shapes reduced to their
+// positions: the trail is a vector, the head is compared against every
+// segment of both cycles and the opponent is passed by value every tick.
+// The original copies whole sf::RectangleShapes, so it is slower still.
+struct ArchivedCycle {
+    std::vector<sf::Vector2i> body; // body[0] is the head
+    sf::Vector2i dir = sf::Vector2i(0, -1);
+    bool crashed = false;
+
+    void update(ArchivedCycle enemy, int size)
+    {
+        sf::Vector2i head = body[0] + dir;
+        body[0] = head;
+        for (size_t i = 1; i < body.size(); ++i) {
+            if (body[i] == head) crashed = true;
+        }
+        for (size_t i = 0; i < enemy.body.size(); ++i) {
+            if (enemy.body[i] == head) crashed = true;
+        }
+        body.push_back(head);
+        if (head.x >= size) head.x = 0;
+        if (head.x < 0) head.x = size - 1;
+        if (head.y >= size) head.y = 0;
+        if (head.y < 0) head.y = size - 1;
+        body[0] = head;
+    }
+};
+
+// Same seeded steering for both engines: mostly straight with a random turn
+// now and then, avoiding the cell ahead when the engine says it is taken
+template <class Blocked>
+static uint8_t tronSteer(uint32_t& rng, uint8_t dir, int x, int y, int size, bool wrap, Blocked blocked)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    uint32_t r = rng % 64;
+    uint8_t wanted = r == 0 ? (uint8_t)((dir + 1) & 3) : (r == 1 ? (uint8_t)((dir + 3) & 3) : dir);
+    uint8_t options[3] = { wanted, (uint8_t)((wanted + 1) & 3), (uint8_t)((wanted + 3) & 3) };
+    for (uint8_t d : options) {
+        if (d == (dir ^ 2)) continue;
+        int nx = x + tronDx[d], ny = y + tronDy[d];
+        if (wrap) {
+            nx = (nx + size) % size;
+            ny = (ny + size) % size;
+        } else if (nx < 0 || nx >= size || ny < 0 || ny >= size) {
+            continue;
+        }
+        if (!blocked(nx, ny)) return d;
+    }
+    return wanted;
+}
+
+// Ticks per second of the occupancy-grid engine against the archived
+// version on its 90x90 arena, then the engine alone on a large arena with
+// many cycles. A replayed game must end with the same grid.
+// Options: [rounds = 200] [large arena size = 1000] [players = 64]
+static int benchTron(int argc, char** argv)
+{
+    int rounds = argc > 0 ? atoi(argv[0]) : 200;
+    int largeSize = argc > 1 ? atoi(argv[1]) : 1000;
+    int largePlayers = argc > 2 ? atoi(argv[2]) : 64;
+    const int size = 90;
+
+    uint64_t archivedTicks = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        uint32_t rng = round + 1;
+        ArchivedCycle cycles[2];
+        cycles[0].body.push_back(sf::Vector2i(size / 4, size / 2));
+        cycles[1].body.push_back(sf::Vector2i(size - size / 4, size / 2));
+        uint8_t dirs[2] = { TRON_UP, TRON_UP };
+        while (!cycles[0].crashed && !cycles[1].crashed) {
+            for (int p = 0; p < 2; p++) {
+                // The archived engine can only answer by scanning both trails
+                auto blocked = [&](int x, int y) {
+                    for (const ArchivedCycle& c : cycles) {
+                        for (const sf::Vector2i& segment : c.body) {
+                            if (segment.x == x && segment.y == y) return true;
+                        }
+                    }
+                    return false;
+                };
+                dirs[p] = tronSteer(rng, dirs[p], cycles[p].body[0].x, cycles[p].body[0].y, size, true, blocked);
+                cycles[p].dir = sf::Vector2i(tronDx[dirs[p]], tronDy[dirs[p]]);
+            }
+            cycles[0].update(cycles[1], size);
+            cycles[1].update(cycles[0], size);
+            archivedTicks++;
+        }
+    }
+    double archivedSeconds = secondsSince(start);
+
+    uint64_t gridTicks = 0;
+    TronGame game;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        uint32_t rng = round + 1;
+        game.reset(size, size, 2, 0);
+        uint8_t inputs[2];
+        while (!game.over()) {
+            for (int p = 0; p < 2; p++) {
+                const TronPlayer& player = game.players[p];
+                inputs[p] = tronSteer(rng, player.dir, player.x, player.y, size, true,
+                                      [&](int x, int y) { return game.grid.test(x, y); });
+            }
+            game.step(inputs);
+            gridTicks++;
+        }
+    }
+    double gridSeconds = secondsSince(start);
+
+    std::cout << "tron " << size << "x" << size << ", 2 cycles, " << rounds << " rounds:\n"
+              << "  archived: " << archivedTicks << " ticks, " << archivedTicks / archivedSeconds << " ticks/s\n"
+              << "  grid:     " << gridTicks << " ticks, " << gridTicks / gridSeconds << " ticks/s ("
+              << (gridTicks / gridSeconds) / (archivedTicks / archivedSeconds) << "x)\n";
+
+    // Large arena: plays to the end, twice with the same seed
+    std::vector<uint8_t> inputs(largePlayers);
+    uint64_t largeTicks = 0, moves = 0, hashes[2] = { 0, 0 };
+    double largeSeconds = 0.0;
+    for (int run = 0; run < 2; run++) {
+        uint32_t rng = 12345;
+        game.wrap = false;
+        game.reset(largeSize, largeSize, largePlayers, 7);
+        start = std::chrono::steady_clock::now();
+        while (!game.over()) {
+            for (int p = 0; p < largePlayers; p++) {
+                const TronPlayer& player = game.players[p];
+                if (player.alive)
+                    inputs[p] = tronSteer(rng, player.dir, player.x, player.y, largeSize, false,
+                                          [&](int x, int y) { return game.grid.test(x, y); });
+            }
+            game.step(inputs.data());
+            moves += game.claimed.size();
+            if (run == 0) largeTicks++;
+        }
+        if (run == 0) largeSeconds = secondsSince(start);
+        uint64_t hash = 1469598103934665603ull;
+        for (uint64_t w : game.grid.bits) hash = (hash ^ w) * 1099511628211ull;
+        hashes[run] = hash ^ (uint64_t)game.tick;
+    }
+    std::cout << "tron " << largeSize << "x" << largeSize << ", " << largePlayers << " cycles: " << largeTicks << " ticks, "
+              << largeTicks / largeSeconds << " ticks/s, " << moves / 2 / largeSeconds / 1e6 << " M moves/s, grid "
+              << game.grid.bits.size() * 8 / 1024 << " KB, replay " << (hashes[0] == hashes[1] ? "identical" : "DIFFERENT") << "\n";
+    return hashes[0] == hashes[1] ? 0 : 1;
+}
+
+// Voronoi score with one cell at a time, for comparison with TronBot's
+// bitsets: a breadth-first search from every head with a queue and a
+// distance per cell. Same rules: cells reached by both sides at the same
+// distance belong to no one and are not expanded.
+static int scalarVoronoi(const TronGame& game, int player, std::vector<int>& dist, std::vector<int8_t>& owner,
+                         std::vector<int>& queue)
+{
+    const int width = game.width(), height = game.height();
+    dist.assign((size_t)width * height, -1);
+    owner.assign((size_t)width * height, -1);
+    queue.clear();
+    for (int i = 0; i < (int)game.players.size(); i++) {
+        const TronPlayer& p = game.players[i];
+        if (!p.alive) continue;
+        int cell = p.y * width + p.x;
+        dist[cell] = 0;
+        owner[cell] = i == player ? 0 : 1;
+        queue.push_back(cell);
+    }
+    int score = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        if (owner[cell] == 2) continue;
+        int x = cell % width, y = cell / width;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + tronDx[d], ny = y + tronDy[d];
+            if (game.wrap) {
+                nx = nx < 0 ? width - 1 : (nx >= width ? 0 : nx);
+                ny = ny < 0 ? height - 1 : (ny >= height ? 0 : ny);
+            } else if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+            int next = ny * width + nx;
+            if (game.grid.test(nx, ny) && dist[next] < 0) continue;
+            if (dist[next] < 0) {
+                dist[next] = dist[cell] + 1;
+                owner[next] = owner[cell];
+                score += owner[cell] == 0 ? 1 : -1;
+                queue.push_back(next);
+            } else if (dist[next] == dist[cell] + 1 && owner[next] != owner[cell] && owner[next] != 2) {
+                score -= owner[next] == 0 ? 1 : -1;
+                owner[next] = 2;
+            }
+        }
+    }
+    return score;
+}
+
+// Free cells reachable from a player's head, one cell at a time
+static int scalarArea(const TronGame& game, int player, std::vector<int>& dist, std::vector<int>& queue)
+{
+    const int width = game.width(), height = game.height();
+    dist.assign((size_t)width * height, -1);
+    queue.clear();
+    const TronPlayer& p = game.players[player];
+    dist[p.y * width + p.x] = 0;
+    queue.push_back(p.y * width + p.x);
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        int x = cell % width, y = cell / width;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + tronDx[d], ny = y + tronDy[d];
+            if (game.wrap) {
+                nx = nx < 0 ? width - 1 : (nx >= width ? 0 : nx);
+                ny = ny < 0 ? height - 1 : (ny >= height ? 0 : ny);
+            } else if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+            int next = ny * width + nx;
+            if (dist[next] >= 0 || game.grid.test(nx, ny)) continue;
+            dist[next] = dist[cell] + 1;
+            queue.push_back(next);
+        }
+    }
+    return (int)queue.size() - 1;
+}
+
+// Bot matches on the 90x90 arena with a think budget per move, then the
+// Voronoi evaluation on positions from those matches, bitsets against the
+// scalar search. At full tick rate every bot must answer within its share
+// of the 30 ms tick.
+// Options: [budget ms = 2] [rounds = 2]
+static int benchTronBot(int argc, char** argv)
+{
+    double budgetMs = argc > 0 ? atof(argv[0]) : 2.0;
+    int rounds = argc > 1 ? atoi(argv[1]) : 2;
+    const int size = 90;
+    std::vector<TronGame> positions;
+
+    for (int players : { 2, 4 }) {
+        uint64_t ticks = 0, nodes = 0, decisions = 0, depth = 0, late = 0;
+        double seconds = 0.0, worst = 0.0;
+        int wins = 0;
+        for (int round = 0; round < rounds; round++) {
+            TronGame game;
+            game.reset(size, size, players, round + 1);
+            std::vector<TronBot> bots(players, TronBot((int)(budgetMs * 1000.0)));
+            std::vector<uint8_t> inputs(players, TRON_KEEP);
+            while (!game.over()) {
+                for (int p = 0; p < players; p++) {
+                    if (!game.players[p].alive) continue;
+                    inputs[p] = bots[p].choose(game, p);
+                    worst = std::max(worst, bots[p].last.seconds);
+                    if (bots[p].last.seconds * 1000.0 > budgetMs + 1.0) late++;
+                }
+                game.step(inputs.data());
+                ticks++;
+                if (game.tick % 200 == 100) positions.push_back(game);
+            }
+            wins += game.winner() >= 0;
+            for (const TronBot& bot : bots) {
+                nodes += bot.totalNodes;
+                seconds += bot.totalSeconds;
+                decisions += bot.decisions;
+                depth += bot.totalDepth;
+            }
+        }
+        std::cout << "tronbot " << size << "x" << size << ", " << players << " bots, " << budgetMs << " ms per move, " << rounds
+                  << " rounds: " << ticks << " ticks, " << wins << " decided\n"
+                  << "  " << nodes / seconds << " nodes/s, average depth " << (double)depth / decisions << ", worst think "
+                  << worst * 1000.0 << " ms, " << late << " of " << decisions << " moves over budget + 1 ms\n"
+                  << "  fits a 30 ms tick: " << (players * budgetMs <= 30.0 ? "yes" : "no") << " (" << players * budgetMs
+                  << " ms of bot time per tick)\n";
+    }
+
+    // Both evaluations on their own, bitsets against one cell at a time, on
+    // every saved position
+    TronBot bot;
+    std::vector<int> dist, queue;
+    std::vector<int8_t> owner;
+    int mismatches = 0;
+    const int repeats = 20;
+    const double evaluations = (double)repeats * positions.size();
+    auto compare = [&](const char* name, auto bitset, auto scalar) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            for (const TronGame& game : positions) bitset(game);
+        }
+        double bitsetSeconds = secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            for (const TronGame& game : positions) scalar(game);
+        }
+        double scalarSeconds = secondsSince(start);
+        int different = 0;
+        for (const TronGame& game : positions) different += bitset(game) != scalar(game);
+        mismatches += different;
+        std::cout << name << " on " << positions.size() << " positions: bitset " << bitsetSeconds * 1e6 / evaluations << " us, scalar "
+                  << scalarSeconds * 1e6 / evaluations << " us (" << scalarSeconds / bitsetSeconds << "x), "
+                  << (different == 0 ? "same results" : "DIFFERENT results") << "\n";
+    };
+    compare("voronoi", [&](const TronGame& game) { return bot.voronoi(game, 0); },
+            [&](const TronGame& game) { return scalarVoronoi(game, 0, dist, owner, queue); });
+    compare("area", [&](const TronGame& game) { return bot.area(game, 0); },
+            [&](const TronGame& game) { return scalarArea(game, 0, dist, queue); });
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Paces a simulated game loop (a busy frame of work ms, varying by up to a
+// quarter either way) without a window, first with a sleep-for-the-rest
+// limiter like sf::Window::setFramerateLimit, then with the hybrid
+// sleep-then-spin FramePacer. Jitter is the change between consecutive
+// frame intervals; the hybrid pacer should keep it under 0.5 ms on an idle
+// machine, checked on the median since a busy one adds scheduler stalls
+// that neither pacer can hide. Options: [seconds = 5] [hz = 60] [work ms = 4]
+static int benchPacing(int argc, char** argv)
+{
+    double seconds = argc > 0 ? atof(argv[0]) : 5.0;
+    double hz = argc > 1 ? std::max(1.0, atof(argv[1])) : 60.0;
+    double workMs = argc > 2 ? atof(argv[2]) : 4.0;
+    const int frames = std::max(2, (int)(seconds * hz));
+    const double periodMs = 1000.0 / hz;
+
+    uint32_t rng = 1;
+    auto work = [&]() {
+        rng = rng * 1664525u + 1013904223u;
+        double ms = workMs * (0.75 + 0.5 * (rng >> 8) / 16777216.0);
+        auto start = std::chrono::steady_clock::now();
+        while (secondsSince(start) * 1000.0 < ms) {
+        }
+    };
+    // Jitter of each interval, for percentiles: a few scheduler stalls
+    // dominate the mean on a busy machine
+    std::vector<double> jitters;
+    auto percentile = [&](double p) {
+        std::vector<double> sorted = jitters;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+    auto report = [&](const char* name, const FrameStats& stats, double spun, double elapsed) {
+        std::cout << name << ": " << stats.frames << " intervals, mean " << stats.meanMs << " ms (target " << periodMs
+                  << "), stddev " << stats.stddevMs() << " ms, worst " << stats.worstMs << " ms, " << stats.missed
+                  << " missed\n  jitter: mean " << stats.jitterMs() << " ms, median " << percentile(0.5) << " ms, p90 "
+                  << percentile(0.9) << " ms, p99 " << percentile(0.99) << " ms, worst " << stats.worstJitterMs << " ms";
+        if (spun > 0.0) std::cout << ", spinning " << spun / elapsed * 100.0 << "% of the time";
+        std::cout << "\n";
+    };
+
+    // The limiter sleeps whatever is left of the period after the frame,
+    // measured from the previous display
+    FrameStats sleepStats;
+    auto start = std::chrono::steady_clock::now();
+    auto last = start;
+    double previousMs = 0.0;
+    for (int frame = 0; frame < frames; frame++) {
+        work();
+        double left = periodMs - std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - last).count();
+        if (left > 0.0) sf::sleep(sf::microseconds((sf::Int64)(left * 1000.0)));
+        auto now = std::chrono::steady_clock::now();
+        if (frame > 0) {
+            double ms = std::chrono::duration<double, std::milli>(now - last).count();
+            sleepStats.add(ms, previousMs, ms >= periodMs * 1.5);
+            if (frame > 1) jitters.push_back(std::fabs(ms - previousMs));
+            previousMs = ms;
+        }
+        last = now;
+    }
+    report("sleep limiter", sleepStats, 0.0, secondsSince(start));
+
+    FramePacer pacer;
+    pacer.setMode(PACING_HYBRID, hz);
+    jitters.clear();
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        work();
+        pacer.wait();
+        double total = pacer.stats().jitterTotalMs;
+        pacer.presented();
+        if (pacer.stats().frames > 1) jitters.push_back(pacer.stats().jitterTotalMs - total);
+    }
+    report("hybrid pacer", pacer.stats(), pacer.spunSeconds(), secondsSince(start));
+    std::cout << "spin margin settled at " << pacer.spinMarginMs() << " ms\n";
+    double median = percentile(0.5);
+    std::cout << (median < 0.5 ? "ok" : "FAILED") << ": half the hybrid intervals within " << median
+              << " ms of the previous one (goal 0.5 ms)\n";
+    return median < 0.5 ? 0 : 1;
+}
+
+// Perfect clear searches from an empty 10x20 field, the usual opener: the
+// seven pieces of a shuffled bag then the first three of the next (40
+// cells, four lines). Every solution found is replayed through the game to
+// check it ends on an empty field. Then line targets with special pieces on
+// random garbage. Options: [puzzles = 20] [threads = one per core]
+static int benchPuzzle(int argc, char** argv)
+{
+    int count = argc > 0 ? std::max(1, atoi(argv[0])) : 20;
+    int threads = argc > 1 ? atoi(argv[1]) : 0;
+    typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> Game;
+
+    uint32_t rng = 12345;
+    auto next = [&]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+    auto bag = [&](std::vector<int>& pieces, int take) {
+        int order[kNormalPieces] = { 0, 1, 2, 3, 4, 5, 6 };
+        for (int i = kNormalPieces - 1; i > 0; i--) std::swap(order[i], order[next() % (i + 1)]);
+        pieces.insert(pieces.end(), order, order + take);
+    };
+
+    int failures = 0;
+    auto run = [&](const char* name, PuzzleGoal goal, int lines, bool specials) {
+        int solved = 0;
+        uint64_t nodes = 0;
+        double total = 0.0, worst = 0.0;
+        for (int i = 0; i < count; i++) {
+            Game game;
+            std::vector<int> pieces;
+            if (specials) {
+                // Four rows of garbage, then normal pieces with a special every third
+                Puzzle puzzle;
+                for (int y = 0; y < 4; y++) {
+                    std::string row(10, 'X');
+                    for (int holes = 0; holes < 2; holes++) row[next() % 10] = '.';
+                    puzzle.rows.push_back(row);
+                }
+                loadPuzzle(game, puzzle);
+                for (int p = 1; p <= 6; p++) pieces.push_back(p % 3 == 0 ? kNormalPieces + (int)(next() % 4) : (int)(next() % kNormalPieces));
+            } else {
+                bag(pieces, kNormalPieces);
+                bag(pieces, 3);
+            }
+            PuzzleSolver<Game> solver;
+            solver.goal = goal;
+            solver.targetLines = lines;
+            solver.threads = threads;
+            PuzzleResult result = solver.solve(game, pieces);
+            nodes += result.nodes;
+            total += result.seconds;
+            worst = std::max(worst, result.seconds);
+            if (result.solutions.empty()) continue;
+            solved++;
+            Game check = game;
+            bool ok = PuzzleSolver<Game>::replay(check, result.solutions[0]);
+            if (goal == GOAL_LINES) {
+                ok &= check.status.linesCleared >= lines;
+            } else {
+                for (int y = 0; y < check.height(); y++)
+                    for (int x = 0; x < check.width(); x++) ok &= check.cell(x, y) == 0;
+            }
+            if (!ok) {
+                std::string sequence;
+                for (int type : pieces) sequence += puzzlePieceName(type) + " ";
+                std::cout << "  solution for " << sequence << "does not replay\n";
+                failures++;
+            }
+        }
+        std::cout << name << ": " << solved << "/" << count << " solved, mean " << total / count * 1000.0 << " ms, worst "
+                  << worst * 1000.0 << " ms, " << nodes / total / 1e6 << " M nodes/s\n";
+    };
+    run("perfect clear, bag of 7 + 3", GOAL_PERFECT_CLEAR, 0, false);
+    run("4 lines, garbage and specials", GOAL_LINES, 4, true);
+    return failures == 0 ? 0 : 1;
+}
+
+// The fit test as it was with 4x4 tetromino masks only: four rows, always,
+// unrolled. Kept as the reference the compiled piece sets are timed against.
+struct FixedTetrominoMasks {
+    uint8_t rows[kPieceTypes][4][4];
+};
+
+static constexpr FixedTetrominoMasks buildFixedTetrominoMasks()
+{
+    FixedTetrominoMasks masks = {};
+    for (int t = 0; t < kPieceTypes; t++)
+        for (int r = 0; r < 4; r++)
+            for (int py = 0; py < 4; py++)
+                for (int px = 0; px < 4; px++)
+                    if (kTetrominoes[t][rotate(px, py, r)] == 'X') masks.rows[t][r][py] |= (uint8_t)(1 << px);
+    return masks;
+}
+
+static constexpr FixedTetrominoMasks kFixedTetrominoMasks = buildFixedTetrominoMasks();
+
+template <class Game>
+static bool fitsFixedTetromino(const Game& game, int type, int rotation, int x, int y)
+{
+    typedef typename Game::Row Row;
+    const Row* rows = game.board.rowData() + kBoardPad + y;
+    const uint8_t* shape = kFixedTetrominoMasks.rows[type][rotation & 3];
+    int shift = x + kBoardPad;
+    Row hit = (rows[0] & ((Row)shape[0] << shift)) | (rows[1] & ((Row)shape[1] << shift)) |
+              (rows[2] & ((Row)shape[2] << shift)) | (rows[3] & ((Row)shape[3] << shift));
+    return hit == 0;
+}
+
+// Piece sets loaded from definition files against the built-in table: load
+// and compile time, whether the tetromino file compiles to exactly the
+// built-in masks and plays the same seeded games, then fit tests and bot
+// games per second with each set in play. The fit tests also run through
+// the old fixed 4x4 code, the cost the compiled sets have to match.
+// Options: [pieces = 100000] [set files = assets/pieces/tetromino.txt assets/pieces/pentomino.txt]
+static int benchPieces(int argc, char** argv)
+{
+    int pieces = argc > 0 ? std::max(1, atoi(argv[0])) : 100000;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) files.push_back(argv[i]);
+    if (files.empty()) files = { "assets/pieces/tetromino.txt", "assets/pieces/pentomino.txt" };
+    typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> Game;
+
+    struct Set {
+        std::string name;
+        PieceTable table;
+    };
+    std::vector<Set> sets = { { "built-in", kBuiltinPieces } };
+    for (const std::string& file : files) {
+        std::ifstream in(file);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        Set set = { file, PieceTable() };
+        std::string error;
+        const int loads = 200;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (int i = 0; i < loads && ok; i++) {
+            std::istringstream stream(text);
+            ok = parsePieceSet(stream, set.table, error);
+        }
+        if (!in || !ok) {
+            std::cerr << file << ": " << (in ? error : "cannot open") << "\n";
+            return 1;
+        }
+        std::cout << file << ": " << set.table.count << " pieces (" << set.table.special.count << " special), loaded and compiled in "
+                  << secondsSince(start) / loads * 1e6 << " us" << (samePieceTables(set.table, kBuiltinPieces) ? ", same masks as built-in" : "")
+                  << "\n";
+        sets.push_back(set);
+    }
+
+    // Fit queries on a half-filled board, up to one column past either wall
+    Game board;
+    uint32_t rng = 99;
+    auto next = [&]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+    for (int y = 10; y < 20; y++)
+        for (int x = 0; x < 10; x++)
+            if (next() % 100 < 60) board.setCell(x, y, 1);
+    const int queries = 1 << 16;
+    const int rounds = 100;
+    auto makeQueries = [&]() {
+        std::vector<Piece> query(queries);
+        for (Piece& q : query) {
+            q.type = (int)(next() % pieceTable.count);
+            q.rotation = (int)(next() % 4);
+            const PieceShape& shape = pieceShape(q.type, q.rotation);
+            q.x = -shape.left - 1 + (int)(next() % (11 - shape.right + shape.left + 1));
+            q.y = (int)(next() % (20 - shape.bottom));
+        }
+        return query;
+    };
+    auto timeFits = [&](auto fits, const std::vector<Piece>& query) {
+        int hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+            for (const Piece& q : query) hits += fits(q.type, q.rotation, q.x, q.y);
+        double rate = (double)queries * rounds / secondsSince(start);
+        return std::make_pair(rate, hits);
+    };
+
+    bool ok = true;
+    uint64_t builtinSum = 0;
+    pieceTable = kBuiltinPieces;
+    const std::vector<Piece> tetrominoQueries = makeQueries();
+    auto fixed = timeFits([&](int t, int r, int x, int y) { return fitsFixedTetromino(board, t, r, x, y); }, tetrominoQueries);
+    std::cout << "fixed 4x4 code: " << fixed.first / 1e6 << " M fit tests/s\n";
+    for (const Set& set : sets) {
+        pieceTable = set.table;
+        const bool tetrominoes = samePieceTables(set.table, kBuiltinPieces);
+        auto fits = timeFits([&](int t, int r, int x, int y) { return board.fits(t, r, x, y); },
+                             tetrominoes ? tetrominoQueries : makeQueries());
+        if (tetrominoes && fits.second != fixed.second) {
+            std::cout << set.name << ": fit tests disagree with the fixed code (" << fits.second << " vs " << fixed.second << " free)\n";
+            ok = false;
+        }
+        Game game;
+        uint64_t sum = 0;
+        double rate = runBotGames(game, pieces, 42, sum);
+        std::cout << set.name << ": " << fits.first / 1e6 << " M fit tests/s (" << fits.first / fixed.first
+                  << "x the fixed code), bot " << (int)rate << " pieces/s";
+        if (set.name == "built-in") {
+            builtinSum = sum;
+        } else if (tetrominoes) {
+            std::cout << (sum == builtinSum ? ", same games as built-in" : "  (MISMATCH with built-in games)");
+            ok &= sum == builtinSum;
+        }
+        std::cout << "\n";
+    }
+    pieceTable = kBuiltinPieces;
+    return ok ? 0 : 1;
+}
+
+// Seeded games fed through step() at several frame rates, checking that the
+// tick-based gravity and lock delay play them identically. Scripted input
+// changes every 6 ticks, which a frame at 20 or 30 fps (3 or 2 ticks) or at
+// 60 fps and above (one at most) never straddles; held input stays the same
+// for the whole game. Each game runs to game over or a fixed number of ticks.
+// Then checks when pieces lock for several lock delays, and the direct drop
+// distance against probing row by row on random boards.
+// Options: [seconds per game = 60] [games = 20]
+static int benchGravity(int argc, char** argv)
+{
+    const double seconds = argc > 0 ? std::max(1.0, atof(argv[0])) : 60.0;
+    const int games = argc > 1 ? std::max(1, atoi(argv[1])) : 20;
+    const int64_t limitTicks = (int64_t)(seconds * kTicksPerSecond);
+    typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> Game;
+
+    struct Setting {
+        const char* name;
+        int32_t gravity;
+        int lockDelay;
+    };
+    const Setting settings[] = {
+        { "level 1", gravityForLevel(1), kLockDelay },
+        { "level 10", gravityForLevel(10), kLockDelay },
+        { "level 14", gravityForLevel(14), kLockDelay },
+        { "20G", kGravity20G, kLockDelay },
+        { "20G, no lock delay", kGravity20G, 0 },
+    };
+    static const uint8_t scriptInputs[] = { 0, 0, INPUT_LEFT, INPUT_RIGHT, INPUT_ROTATE, INPUT_SOFT_DROP,
+                                            INPUT_LEFT | INPUT_ROTATE, INPUT_RIGHT | INPUT_SOFT_DROP, INPUT_HARD_DROP };
+    static const uint8_t heldInputs[] = { 0, INPUT_LEFT, INPUT_RIGHT, INPUT_SOFT_DROP, INPUT_LEFT | INPUT_SOFT_DROP };
+
+    struct Result {
+        uint64_t checksum = 0;
+        uint64_t locks = 0;
+        int64_t ticks = 0;
+        double seconds = 0.0;
+    };
+    // Input for tick t of game g: a new button combination every 6 ticks
+    auto scripted = [](int g, int64_t t) {
+        uint32_t h = (uint32_t)(t / 6) * 2654435761u ^ (uint32_t)g * 40503u;
+        h ^= h >> 15;
+        h *= 2246822519u;
+        h ^= h >> 13;
+        return scriptInputs[h % sizeof(scriptInputs)];
+    };
+    auto play = [&](const Setting& setting, double fps, bool script) {
+        Result result;
+        std::unique_ptr<Game> game(new Game());
+        const int64_t frameTime = std::llround(kTickTime * kTicksPerSecond / fps);
+        auto start = std::chrono::steady_clock::now();
+        for (int g = 0; g < games; g++) {
+            game->reset(1000 + g);
+            game->gravity = setting.gravity;
+            game->lockDelay = setting.lockDelay;
+            // The game runs a tick for every kTickTime of frame time; the
+            // last frame is cut short so every rate stops on the same tick
+            int64_t elapsed = 0;
+            while (!game->status.gameOver && elapsed < limitTicks * kTickTime) {
+                int64_t time = std::min(frameTime, limitTicks * kTickTime - elapsed);
+                uint8_t input = script ? scripted(g, elapsed / kTickTime) : heldInputs[g % sizeof(heldInputs)];
+                game->step(input, (float)((double)time / kTickTime / kTicksPerSecond));
+                elapsed += time;
+                for (int i = 0; i < game->status.eventCount; i++)
+                    if (game->status.events[i].type == EVENT_LOCK) result.locks++;
+            }
+            result.ticks += elapsed / kTickTime;
+            uint64_t& sum = result.checksum;
+            for (int y = 0; y < game->height(); y++)
+                for (int x = 0; x < game->width(); x++) sum = sum * 31 + (uint64_t)game->cell(x, y);
+            const Piece& p = game->status.piece;
+            for (int v : { game->status.score, game->status.linesCleared, p.type, p.rotation & 3, p.x, p.y, (int)game->status.gameOver })
+                sum = sum * 1000003 + (uint64_t)(int64_t)v;
+        }
+        result.seconds = secondsSince(start);
+        return result;
+    };
+
+    bool ok = true;
+    for (const Setting& setting : settings) {
+        for (int script = 1; script >= 0; script--) {
+            const std::vector<double> rates = script ? std::vector<double>{ 60, 20, 30, 144, 240, 1000 }
+                                                     : std::vector<double>{ 60, 20, 30, 75, 144, 240 };
+            std::cout << setting.name << (script ? ", scripted input:" : ", held input:");
+            Result first;
+            bool allSame = true;
+            for (size_t r = 0; r < rates.size(); r++) {
+                Result result = play(setting, rates[r], script != 0);
+                if (r == 0) first = result;
+                bool same = result.checksum == first.checksum && result.locks == first.locks;
+                allSame = allSame && same;
+                std::cout << " " << rates[r] << " fps" << (same ? "" : " MISMATCH");
+                if (rates[r] == 60)
+                    std::cout << " (" << result.locks * 60.0 * kTicksPerSecond / std::max<int64_t>(1, result.ticks)
+                              << " pieces/min, " << result.seconds * 1e9 / std::max<int64_t>(1, result.ticks) << " ns/tick)";
+            }
+            std::cout << (allSame ? "" : "  -- frame rate changed the game") << "\n";
+            ok = ok && allSame;
+        }
+    }
+
+    // With no input, every piece has to lock lockDelay ticks after the tick
+    // gravity brings it to its landing row, on that tick for a delay of 0
+    typedef TetrisGame<FixedBoard<10, 20>, ClassicRules> ClassicGame;
+    std::unique_ptr<ClassicGame> classic(new ClassicGame());
+    for (const Setting& setting : settings) {
+        if (setting.lockDelay != kLockDelay) continue;
+        std::cout << "lock delay, " << setting.name << ":";
+        for (int delay : { 0, 1, 2, 5, kLockDelay }) {
+            classic->reset(7);
+            classic->gravity = setting.gravity;
+            classic->lockDelay = delay;
+            int wrong = 0;
+            for (int piece = 0; piece < 8 && !classic->status.gameOver; piece++) {
+                const int rows = classic->ghostY() - classic->status.piece.y;
+                const int64_t landing = std::max<int64_t>(1, ((int64_t)rows * kGravityUnit + setting.gravity - 1) / setting.gravity);
+                int64_t ticks = 0;
+                for (bool locked = false; !locked && ticks < 100000; ticks++) {
+                    classic->step(0, 1.0f / kTicksPerSecond);
+                    for (int i = 0; i < classic->status.eventCount; i++) locked |= classic->status.events[i].type == EVENT_LOCK;
+                }
+                if (ticks != landing + delay) wrong++;
+            }
+            std::cout << " " << delay << (wrong ? " WRONG" : " ok");
+            ok = ok && wrong == 0;
+        }
+        std::cout << "\n";
+    }
+
+    // Direct drops against probing row by row, on random boards with holes
+    // and overhangs, checked again after pieces lock and clear lines. The
+    // pentomino U has a gap in one column when it stands on its side.
+    PieceTable pentominoes;
+    std::string error;
+    if (!loadPieceSet("assets/pieces/pentomino.txt", pentominoes, error)) {
+        std::cerr << "assets/pieces/pentomino.txt: " << error << "\n";
+        return 1;
+    }
+    uint32_t rng = 17;
+    auto next = [&]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+    const std::pair<const char*, const PieceTable*> tables[] = { { "built-in", &kBuiltinPieces }, { "pentomino", &pentominoes } };
+    for (const auto& table : tables) {
+        pieceTable = *table.second;
+        int64_t drops = 0;
+        int64_t wrong = 0;
+        for (int b = 0; b < 200; b++) {
+            classic->reset(b + 1);
+            const int top = 4 + (int)(next() % 14);
+            const int fill = 30 + (int)(next() % 50);
+            for (int y = top; y < 20; y++)
+                for (int x = 0; x < 10; x++)
+                    if ((int)(next() % 100) < fill) classic->setCell(x, y, 1);
+            for (int round = 0; round < 4 && !classic->status.gameOver; round++) {
+                for (int t = 0; t < pieceTable.count; t++) {
+                    for (int r = 0; r < 4; r++) {
+                        const PieceShape& shape = pieceShape(t, r);
+                        for (int x = -shape.left; x + shape.right < 10; x++) {
+                            for (int y = -shape.top; y + shape.bottom < 20; y++) {
+                                if (!classic->fits(t, r, x, y)) continue;
+                                int probe = y;
+                                while (classic->fits(t, r, x, probe + 1)) probe++;
+                                wrong += classic->dropY(t, r, x, y) != probe;
+                                drops++;
+                            }
+                        }
+                    }
+                }
+                for (int i = 0; i < 3 && !classic->status.gameOver; i++) {
+                    const int r = (int)(next() % 4);
+                    const PieceShape& shape = pieceShape(classic->status.piece.type, r);
+                    classic->place(r, -shape.left + (int)(next() % (10 - shape.right + shape.left)));
+                }
+            }
+        }
+        std::cout << "drops, " << table.first << " pieces: " << drops << " checked, "
+                  << (wrong ? std::to_string(wrong) + " DIFFER from probing" : "all match probing") << "\n";
+        ok = ok && wrong == 0;
+    }
+    pieceTable = kBuiltinPieces;
+    return ok ? 0 : 1;
+}
+
+struct Benchmark {
+    const char* name;
+    const char* help;
+    int (*run)(int argc, char** argv);
+};
+
+static const Benchmark benchmarks[] = {
+    { "sfx", "sound effect stress test [rate] [seconds]", benchSfx },
+    { "governor", "quality governor under a synthetic load", benchGovernor },
+    { "core", "specialized game variants vs runtime-sized bitmask board and the old cell array [pieces]", benchCore },
+    { "rollback", "versus netcode over a lossy simulated link [latency ms] [loss %] [frames] [ack delay ms]", benchRollback },
+    { "cascade", "cascade gravity on random tall boards [boards] [fill %]", benchCascade },
+    { "raster", "software renderer frames per second at several resolutions [seconds]", benchRaster },
+    { "golden", "software renderer output against saved images <dir> [update]", benchGolden },
+    { "capture", "gameplay recording through the frame ring [file] [frames] [fps, 0 = unlimited]", benchCapture },
+    { "metrics", "engine counters cost and a local scrape checked against the text format [pieces]", benchMetrics },
+    { "scores", "memory-mapped score store: add cost, queries, reopen, killed writer [records] [file]", benchScores },
+    { "pgo", "baseline vs profile-guided game build on seeded bot games <baseline> <release> [games] [runs]", benchPgo },
+    { "log", "asynchronous logger call cost vs std::endl [calls] [threads]", benchLog },
+    { "debris", "falling debris physics cost under repeated clear and explosion bursts [seconds] [every N frames]", benchDebris },
+    { "physics", "Chipmunk step time, contacts per second and thread scaling for falling balls [counts] [steps] [iterations] [substeps]", benchPhysics },
+    { "entities", "physics entity store: step, sync and vertex array for many circles vs Ball [entities] [frames] [replaced per frame]", benchEntities },
+    { "sprites", "atlas sprite batch vs one sf::Sprite per sprite: draw calls and frame time [sprites] [frames]", benchSprites },
+    { "tron", "Tron occupancy-grid engine vs the archived version, then a large arena [rounds] [size] [players]", benchTron },
+    { "tronbot", "Tron bot matches at full tick rate: nodes/s, depth, think time, bitset vs scalar Voronoi [budget ms] [rounds]", benchTronBot },
+    { "pacing", "frame pacing: sleep limiter vs hybrid sleep-then-spin pacer, jitter and missed deadlines [seconds] [hz] [work ms]", benchPacing },
+    { "pieces", "piece sets loaded from files vs the built-in table: compile time, fit tests and bot games per second [pieces] [files]", benchPieces },
+    { "puzzle", "puzzle solver: perfect clear openers and line targets with specials, replayed through the game [puzzles] [threads]", benchPuzzle },
+    { "gravity", "tick-based gravity and lock delay from level 1 to 20G: same games at every frame rate, lock timing, drops [seconds per game] [games]", benchGravity },
+    { "terminal", "ANSI renderer bytes per frame, checked on an emulated terminal [frames]", benchTerminal },
+};
+
+int main(int argc, char** argv)
+{
+    for (const auto& b : benchmarks) {
+        if (argc > 1 && strcmp(argv[1], b.name) == 0)
+            return b.run(argc - 2, argv + 2);
+    }
+
+    std::cout << "Usage: bench.exe <name> [options]\n";
+    for (const auto& b : benchmarks)
+        std::cout << "  " << b.name << "\t" << b.help << "\n";
+    return 1;
+}
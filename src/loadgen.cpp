@@ -0,0 +1,177 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "LatencyStats.hpp"
+#include "Logger.hpp"
+#include "ServerProtocol.hpp"
+#include "TimerWheel.hpp"
+
+// Load generator for the headless server: opens many connections from one
+// thread and plays each like an impatient player, changing the held buttons
+// a few times per second. Measures the round trip from sending an input to
+// the state update that acknowledges it.
+// Usage: loadgen [--host 127.0.0.1] [--port 55000] [--clients 2000]
+//                [--rate <inputs per second per client> = 4] [--seconds 20]
+
+struct Client {
+    int fd = -1;
+    uint32_t seq = 0;
+    int64_t sentUs = 0; // when seq went out, 0 once acknowledged
+    int64_t nextInputUs = 0;
+    uint32_t rng = 1;
+    uint8_t inLen = 0;
+    uint8_t inBuf[kMaxStateSize];
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int)
+{
+    stopping = 1;
+}
+
+int main(int argc, char** argv)
+{
+    const char* host = "127.0.0.1";
+    int port = 55000;
+    int clientCount = 2000;
+    double rate = 4.0;
+    double seconds = 20.0;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0) host = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0) port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--clients") == 0) clientCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0) rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = atof(argv[++i]);
+    }
+    const int64_t inputPeriodUs = (int64_t)(1e6 / (rate > 0.1 ? rate : 0.1));
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+
+    int epollFd = epoll_create1(0);
+    TimerWheel wheel(monotonicUs() / 1000);
+    std::vector<Client> clients(clientCount);
+    int connected = 0;
+    int64_t start = monotonicUs();
+    for (int i = 0; i < clientCount && !stopping; i++) {
+        Client& c = clients[i];
+        c.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (c.fd < 0 || connect(c.fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            LOG_ERROR("connection {} failed: {}", i, strerror(errno));
+            if (c.fd >= 0) close(c.fd);
+            c.fd = -1;
+            break;
+        }
+        int yes = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+        c.rng = (uint32_t)i * 2654435761u + 7;
+        // Spread the first inputs over one period
+        c.nextInputUs = monotonicUs() + (c.rng >> 8) % inputPeriodUs;
+        wheel.schedule(i, c.nextInputUs / 1000);
+        connected++;
+    }
+    LOG_INFO("{} clients connected in {} ms", connected, (monotonicUs() - start) / 1000);
+
+    LatencyStats roundTrip;
+    uint64_t inputs = 0, updates = 0, bytesIn = 0, closed = 0;
+    uint64_t lastInputs = 0, lastUpdates = 0, lastBytes = 0;
+    start = monotonicUs();
+    int64_t lastReport = start;
+    epoll_event events[512];
+    uint8_t buffer[16384];
+
+    while (!stopping) {
+        int timeout = wheel.nextDelay();
+        int n = epoll_wait(epollFd, events, 512, timeout < 0 || timeout > 100 ? 100 : timeout);
+        int64_t now = monotonicUs();
+        for (int e = 0; e < n; e++) {
+            Client& c = clients[events[e].data.u32];
+            ssize_t got = recv(c.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (got <= 0) {
+                if (got < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+                close(c.fd);
+                wheel.cancel((int)events[e].data.u32);
+                c.fd = -1;
+                closed++;
+                continue;
+            }
+            bytesIn += got;
+            for (ssize_t i = 0; i < got; i++) {
+                c.inBuf[c.inLen++] = buffer[i];
+                if (c.inLen < kStateHeaderSize || c.inLen < StateMessage::sizeOf(c.inBuf)) continue;
+                c.inLen = 0;
+                StateMessage msg;
+                if (!msg.read(c.inBuf)) continue;
+                updates++;
+                if (c.sentUs && msg.ackSeq == c.seq) {
+                    roundTrip.add(now - c.sentUs);
+                    c.sentUs = 0;
+                }
+            }
+        }
+
+        now = monotonicUs();
+        wheel.expire(now / 1000, [&](int id) {
+            Client& c = clients[id];
+            c.rng ^= c.rng << 13;
+            c.rng ^= c.rng >> 17;
+            c.rng ^= c.rng << 5;
+            InputMessage input;
+            input.buttons = (uint8_t)(c.rng & 0x1F);
+            input.seq = ++c.seq;
+            uint8_t data[kInputMessageSize];
+            input.write(data);
+            if (send(c.fd, data, sizeof(data), MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)sizeof(data)) {
+                c.sentUs = now;
+                inputs++;
+            }
+            c.nextInputUs += inputPeriodUs;
+            if (c.nextInputUs < now) c.nextInputUs = now + inputPeriodUs;
+            wheel.schedule(id, c.nextInputUs / 1000);
+        });
+
+        if (seconds > 0 && now - start >= seconds * 1e6) stopping = 1;
+        if (now - lastReport >= 5000000 || stopping) {
+            double interval = (now - lastReport) / 1e6;
+            LOG_INFO("{} clients | {} inputs/s, {} updates/s, {} KB/s | round trip avg {} us, p50 <= {} us, p99 <= {} us, max {} us",
+                     connected - closed, (int)((inputs - lastInputs) / interval), (int)((updates - lastUpdates) / interval),
+                     (int)((bytesIn - lastBytes) / interval / 1024), (int)roundTrip.averageUs(), roundTrip.percentileUs(0.5),
+                     roundTrip.percentileUs(0.99), roundTrip.maxUs.load());
+            roundTrip.reset();
+            lastInputs = inputs;
+            lastUpdates = updates;
+            lastBytes = bytesIn;
+            lastReport = now;
+        }
+    }
+
+    for (Client& c : clients)
+        if (c.fd >= 0) close(c.fd);
+    close(epollFd);
+    return 0;
+}
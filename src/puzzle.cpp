@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "PieceSet.hpp"
+#include "PuzzleSolver.hpp"
+#include "TetrisCore.hpp"
+
+// Training puzzle solver: finds how to place a given sequence of pieces on
+// a board to reach a perfect clear or clear a number of lines. The puzzle
+// file format is described next to parsePuzzle in PuzzleSolver.hpp.
+//
+// Usage: puzzle <file> [options]
+//   --pieces <list>    overrides the file's sequence, e.g. IOTLJ or "I O Fire"
+//   --lines <n>        clear n lines instead of a perfect clear
+//   --solutions <n>    stops after n solutions (default 1)
+//   --threads <n>      search threads (default one per core)
+//   --time <seconds>   gives up after that long
+//   --cascade          floating blocks fall after special clears
+//   --classic          no special pieces
+//   --set <file>       pieces from a piece set file (see PieceSet.hpp)
+// Boards 10 wide up to 20 rows use the standard field, 10 wide up to 40 the
+// tall one and 16 wide the wide one. Prints every solution, and the board
+// after each piece of the first one, replayed through the game's own rules.
+
+struct Options {
+    int solutions = 1;
+    int threads = 0;
+    double timeLimit = 0.0;
+    bool cascade = false;
+};
+
+template <class Game>
+static void printBoard(const Game& game)
+{
+    int top = 0;
+    while (top < game.height() - 1) {
+        bool empty = true;
+        for (int x = 0; x < game.width(); x++) empty &= game.cell(x, top) == 0;
+        if (!empty) break;
+        top++;
+    }
+    for (int y = std::max(0, top - 1); y < game.height(); y++) {
+        std::string row;
+        for (int x = 0; x < game.width(); x++) {
+            int value = game.cell(x, y);
+            row += value == 0 ? '.' : value == kGarbageCell ? '#' : puzzlePieceName(value - 1)[0];
+        }
+        std::cout << "  " << row << "\n";
+    }
+}
+
+template <class Game>
+static int solvePuzzle(const Puzzle& puzzle, const Options& options)
+{
+    Game game;
+    if (!loadPuzzle(game, puzzle)) {
+        std::cerr << "the board does not fit a " << game.width() << "x" << game.height() << " field\n";
+        return 1;
+    }
+    game.cascade = options.cascade;
+    for (int type : puzzle.pieces) {
+        if (pieceEffect(type) != EFFECT_NONE && !game.rules.specials()) {
+            std::cerr << puzzlePieceName(type) << " is a special piece and specials are off\n";
+            return 1;
+        }
+    }
+
+    PuzzleSolver<Game> solver;
+    solver.goal = puzzle.lines > 0 ? GOAL_LINES : GOAL_PERFECT_CLEAR;
+    solver.targetLines = puzzle.lines;
+    solver.maxSolutions = options.solutions;
+    solver.threads = options.threads;
+    solver.timeLimit = options.timeLimit;
+    solver.cascade = options.cascade;
+    PuzzleResult result = solver.solve(game, puzzle.pieces);
+
+    std::cout << (puzzle.lines > 0 ? std::to_string(puzzle.lines) + " lines" : std::string("perfect clear")) << " with "
+              << puzzle.pieces.size() << " pieces: " << result.solutions.size() << " solution(s), " << result.nodes
+              << " nodes, " << result.pruned << " pruned, " << result.memoHits << " memo hits, " << result.seconds * 1000.0
+              << " ms" << (result.timedOut ? " (time limit reached)" : "") << "\n";
+    for (size_t i = 0; i < result.solutions.size(); i++) {
+        std::cout << i + 1 << ":";
+        for (const PuzzlePlacement& p : result.solutions[i])
+            std::cout << " " << puzzlePieceName(p.type) << " r" << p.rotation << " x" << p.x << " y" << p.y;
+        std::cout << "\n";
+    }
+    if (result.solutions.empty()) return 2;
+
+    Game replay = game;
+    for (const PuzzlePlacement& p : result.solutions[0]) {
+        if (!PuzzleSolver<Game>::replay(replay, { p })) {
+            std::cerr << "the game does not accept " << puzzlePieceName(p.type) << " at x" << p.x << " y" << p.y << "\n";
+            return 1;
+        }
+        std::cout << "\n" << puzzlePieceName(p.type) << ", " << replay.status.linesCleared << " lines\n";
+        printBoard(replay);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: puzzle <file> [--pieces <list>] [--lines <n>] [--solutions <n>] [--threads <n>] [--time <s>] "
+                     "[--cascade] [--classic] [--set <file>]\n";
+        return 1;
+    }
+    // The piece names of the puzzle come from the set
+    for (int i = 2; i + 1 < argc; i++) {
+        std::string error;
+        if (strcmp(argv[i], "--set") == 0 && !loadPieceSet(argv[++i], pieceTable, error)) {
+            std::cerr << "--set: " << error << "\n";
+            return 1;
+        }
+    }
+    std::ifstream file(argv[1]);
+    if (!file) {
+        std::cerr << "cannot open " << argv[1] << "\n";
+        return 1;
+    }
+    Puzzle puzzle;
+    std::string error;
+    if (!parsePuzzle(file, puzzle, error)) {
+        std::cerr << argv[1] << ": " << error << "\n";
+        return 1;
+    }
+
+    Options options;
+    bool classic = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--cascade") == 0) options.cascade = true;
+        if (strcmp(argv[i], "--classic") == 0) classic = true;
+        if (strcmp(argv[i], "--solutions") == 0 && i + 1 < argc) options.solutions = std::max(1, atoi(argv[++i]));
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.threads = atoi(argv[++i]);
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) options.timeLimit = atof(argv[++i]);
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) puzzle.lines = std::max(0, atoi(argv[++i]));
+        if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+            std::istringstream list("pieces " + std::string(argv[++i]));
+            Puzzle pieces;
+            if (!parsePuzzle(list, pieces, error)) {
+                std::cerr << "--pieces: " << error << "\n";
+                return 1;
+            }
+            puzzle.pieces = pieces.pieces;
+        }
+    }
+
+    const int width = puzzle.rows.empty() ? 10 : (int)puzzle.rows[0].size();
+    const int height = (int)puzzle.rows.size();
+    if (width == 10 && height <= 20)
+        return classic ? solvePuzzle<TetrisGame<FixedBoard<10, 20>, ClassicRules>>(puzzle, options)
+                       : solvePuzzle<TetrisGame<FixedBoard<10, 20>, SpecialRules>>(puzzle, options);
+    if (width == 10 && height <= 40 && !classic) return solvePuzzle<TetrisGame<FixedBoard<10, 40>, SpecialRules>>(puzzle, options);
+    if (width == 16 && height <= 20 && !classic) return solvePuzzle<TetrisGame<FixedBoard<16, 20>, SpecialRules>>(puzzle, options);
+    std::cerr << "no field for a " << width << "x" << height << " board" << (classic ? " in classic mode" : "") << "\n";
+    return 1;
+}
@@ -0,0 +1,466 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LatencyStats.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "ScoreStore.hpp"
+#include "ServerProtocol.hpp"
+#include "TimerWheel.hpp"
+
+// Headless game server (Linux, epoll). Every TCP connection gets its own
+// server-authoritative game ticking at 60 Hz. Connections are spread over
+// worker threads; each worker owns its sessions outright (no locks on the hot
+// path), waits on its own epoll set and schedules the session ticks on a
+// timer wheel. State updates produced during a tick pass are queued per
+// session and written out together afterwards, one send() per session.
+// Usage: server [--port 55000] [--workers <n>] [--seconds <n>] [--metrics <port>] [--scores <file>]
+// --metrics serves the live counters on http://127.0.0.1:<port>/metrics
+// --scores appends every finished game to a score store
+
+METRICS_COUNT_ALLOCATIONS
+
+static std::atomic<bool> stopping{false};
+
+struct ServerStats {
+    LatencyStats tickLag;      // scheduled tick time until the tick ran
+    LatencyStats inputLatency; // input received until the tick that applied it
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> updates{0};
+    std::atomic<uint64_t> writes{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<int> sessions{0};
+    std::atomic<uint64_t> dropped{0}; // sessions closed for not reading their updates
+    GameMetrics game;                 // shared by the workers, plain relaxed adds
+    ScoreStore scores;                // finished games, when --scores is given
+};
+
+struct Session {
+    ServerGame game;
+    std::vector<uint8_t> out; // updates waiting for the socket
+    uint32_t outPos = 0;
+    int fd = -1;
+    int64_t deadlineUs = 0;      // next tick
+    int64_t inputArrivalUs = 0;  // first unapplied input, 0 when none
+    uint32_t inputSeq = 0;
+    uint32_t sentSeq = 0;
+    uint32_t tick = 0;
+    uint32_t gameStartTick = 0;
+    int sentScore = -1;
+    Piece sentPiece = { -1, 0, 0, 0 };
+    uint8_t buttons = 0;
+    uint8_t inLen = 0;
+    uint8_t inBuf[kInputMessageSize]; // partial input message
+    bool boardChanged = true;
+    bool queued = false;  // in the worker's flush list
+    bool blocked = false; // waiting for EPOLLOUT
+};
+
+class Worker {
+public:
+    static const uint32_t kWakeId = 0xFFFFFFFFu;
+    static const size_t kMaxBacklog = 64 * 1024; // unsent bytes before a client is dropped
+
+    explicit Worker(ServerStats& stats)
+        : stats(stats) {
+        epollFd = epoll_create1(0);
+        wakeFd = eventfd(0, EFD_NONBLOCK);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = kWakeId;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    }
+
+    ~Worker() {
+        if (thread.joinable()) thread.join();
+        for (auto& s : sessions)
+            if (s) close(s->fd);
+        close(wakeFd);
+        close(epollFd);
+    }
+
+    void start() {
+        thread = std::thread(&Worker::run, this);
+    }
+
+    void join() {
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {}
+        if (thread.joinable()) thread.join();
+    }
+
+    // Called from the accept thread
+    void add(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending.push_back(fd);
+        }
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) {}
+    }
+
+private:
+    void run() {
+        wheel = TimerWheel(monotonicUs() / 1000);
+        epoll_event events[256];
+        while (!stopping.load(std::memory_order_relaxed)) {
+            int timeout = wheel.nextDelay();
+            int n = epoll_wait(epollFd, events, 256, timeout < 0 ? 100 : timeout);
+            int64_t now = monotonicUs();
+            for (int i = 0; i < n; i++) {
+                uint32_t id = events[i].data.u32;
+                if (id == kWakeId) {
+                    acceptPending(now);
+                    continue;
+                }
+                if (id >= sessions.size() || !sessions[id]) continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeSession(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) readInput(id, now);
+                if (sessions[id] && (events[i].events & EPOLLOUT)) flush(id);
+            }
+
+            wheel.expire(monotonicUs() / 1000, [&](int id) { tick(id); });
+
+            // Batched writes: everything queued during this pass goes out now
+            for (int id : flushList)
+                if (sessions[id]) flush(id);
+            flushList.clear();
+        }
+    }
+
+    void acceptPending(int64_t now) {
+        uint64_t value;
+        if (read(wakeFd, &value, sizeof(value)) < 0) {}
+        std::vector<int> fds;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            fds.swap(pending);
+        }
+        for (int fd : fds) {
+            int id;
+            if (!freeIds.empty()) {
+                id = freeIds.back();
+                freeIds.pop_back();
+            } else {
+                id = (int)sessions.size();
+                sessions.emplace_back();
+            }
+            sessions[id].reset(new Session());
+            Session& s = *sessions[id];
+            s.fd = fd;
+            s.game.reset((uint32_t)(fd * 2654435761u + 1));
+            s.deadlineUs = now + kServerTickUs;
+            wheel.schedule(id, (s.deadlineUs + 999) / 1000);
+
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u32 = (uint32_t)id;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+            stats.sessions++;
+        }
+    }
+
+    void closeSession(int id) {
+        Session& s = *sessions[id];
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, s.fd, nullptr);
+        close(s.fd);
+        wheel.cancel(id);
+        sessions[id].reset();
+        freeIds.push_back(id);
+        stats.sessions--;
+    }
+
+    void readInput(int id, int64_t now) {
+        Session& s = *sessions[id];
+        uint8_t buffer[4096];
+        for (;;) {
+            ssize_t n = recv(s.fd, buffer, sizeof(buffer), 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                closeSession(id);
+                return;
+            }
+            if (n < 0) return;
+            for (ssize_t i = 0; i < n; i++) {
+                s.inBuf[s.inLen++] = buffer[i];
+                if (s.inLen < kInputMessageSize) continue;
+                s.inLen = 0;
+                InputMessage input;
+                if (!input.read(s.inBuf)) {
+                    closeSession(id);
+                    return;
+                }
+                // Buttons are held until the next message replaces them
+                s.buttons = input.buttons;
+                s.inputSeq = input.seq;
+                if (!s.inputArrivalUs) s.inputArrivalUs = now;
+            }
+        }
+    }
+
+    void tick(int id) {
+        Session& s = *sessions[id];
+        int64_t now = monotonicUs();
+        stats.tickLag.add(now > s.deadlineUs ? now - s.deadlineUs : 0);
+        if (s.inputArrivalUs) {
+            stats.inputLatency.add(now - s.inputArrivalUs);
+            s.inputArrivalUs = 0;
+        }
+
+        s.game.step(s.buttons, 1.0f / kTicksPerSecond); // one game tick per server tick
+        s.tick++;
+        const GameStatus& status = s.game.status;
+        stats.game.record(status);
+        for (int i = 0; i < status.eventCount; i++)
+            if (status.events[i].type != EVENT_FROZEN) s.boardChanged = true;
+
+        // Only send what the client does not know yet
+        const Piece& p = status.piece;
+        bool pieceMoved = p.type != s.sentPiece.type || p.rotation != s.sentPiece.rotation || p.x != s.sentPiece.x || p.y != s.sentPiece.y;
+        if (s.boardChanged || pieceMoved || status.score != s.sentScore || s.inputSeq != s.sentSeq || status.gameOver) {
+            StateMessage msg;
+            msg.flags = (s.boardChanged ? STATE_BOARD : 0) | (status.gameOver ? STATE_GAME_OVER : 0);
+            msg.tick = s.tick;
+            msg.ackSeq = s.inputSeq;
+            msg.score = status.score;
+            msg.pieceType = (int8_t)p.type;
+            msg.rotation = (int8_t)(p.rotation & 3);
+            msg.x = (int8_t)p.x;
+            msg.y = (int8_t)p.y;
+            if (s.boardChanged) {
+                const ServerGame::Row* rows = s.game.board.rowData() + kBoardPad;
+                for (int y = 0; y < kServerBoardHeight; y++) msg.rows[y] = (uint16_t)(rows[y] >> kBoardPad);
+            }
+            msg.append(s.out);
+            s.sentPiece = p;
+            s.sentScore = status.score;
+            s.sentSeq = s.inputSeq;
+            s.boardChanged = false;
+            stats.updates.fetch_add(1, std::memory_order_relaxed);
+            if (s.blocked && s.out.size() - s.outPos > kMaxBacklog) {
+                stats.dropped++;
+                closeSession(id);
+                return;
+            }
+            if (!s.queued && !s.blocked) {
+                s.queued = true;
+                flushList.push_back(id);
+            }
+        }
+        if (status.gameOver) {
+            if (stats.scores.isOpen()) {
+                ScoreRecord record;
+                record.time = (uint64_t)time(nullptr);
+                record.score = status.score;
+                record.lines = status.linesCleared;
+                record.level = status.level;
+                record.durationMs = (uint32_t)((int64_t)(s.tick - s.gameStartTick) * kServerTickUs / 1000);
+                record.setMode("server");
+                stats.scores.add(record);
+            }
+            s.gameStartTick = s.tick;
+            s.game.reset(s.tick * 2654435761u + 1);
+            s.boardChanged = true;
+        }
+        stats.ticks.fetch_add(1, std::memory_order_relaxed);
+
+        // Next tick; after a long stall skip ahead instead of bursting
+        s.deadlineUs += kServerTickUs;
+        if (s.deadlineUs < now - 250000) s.deadlineUs = now;
+        wheel.schedule(id, (s.deadlineUs + 999) / 1000);
+    }
+
+    void flush(int id) {
+        Session& s = *sessions[id];
+        s.queued = false;
+        while (s.outPos < s.out.size()) {
+            ssize_t n = send(s.fd, s.out.data() + s.outPos, s.out.size() - s.outPos, MSG_NOSIGNAL);
+            if (n > 0) {
+                s.outPos += (uint32_t)n;
+                stats.writes.fetch_add(1, std::memory_order_relaxed);
+                stats.bytesOut.fetch_add(n, std::memory_order_relaxed);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (s.out.size() - s.outPos > kMaxBacklog) {
+                    stats.dropped++;
+                    closeSession(id);
+                    return;
+                }
+                if (!s.blocked) setWriteInterest(s, id, true);
+                return;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            closeSession(id);
+            return;
+        }
+        s.out.clear();
+        s.outPos = 0;
+        if (s.blocked) setWriteInterest(s, id, false);
+    }
+
+    void setWriteInterest(Session& s, int id, bool enabled) {
+        s.blocked = enabled;
+        epoll_event ev = {};
+        ev.events = enabled ? (uint32_t)(EPOLLIN | EPOLLOUT) : (uint32_t)EPOLLIN;
+        ev.data.u32 = (uint32_t)id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, s.fd, &ev);
+    }
+
+    ServerStats& stats;
+    int epollFd;
+    int wakeFd;
+    std::thread thread;
+    TimerWheel wheel;
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<int> freeIds;
+    std::vector<int> flushList;
+    std::mutex pendingMutex;
+    std::vector<int> pending;
+};
+
+// Resident set size in bytes
+static long residentBytes()
+{
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void onSignal(int)
+{
+    stopping = true;
+}
+
+int main(int argc, char** argv)
+{
+    int port = 55000;
+    int workerCount = (int)std::thread::hardware_concurrency();
+    double seconds = 0.0;
+    int metricsPort = 0;
+    const char* scoresPath = nullptr;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0) port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0) workerCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--metrics") == 0) metricsPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scores") == 0) scoresPath = argv[++i];
+    }
+    if (workerCount < 1) workerCount = 1;
+
+    // One descriptor per session
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        LOG_INFO("file descriptor limit: {}", (uint64_t)limit.rlim_cur);
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 4096) < 0) {
+        perror("listen");
+        return 1;
+    }
+    int acceptEpoll = epoll_create1(0);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    epoll_ctl(acceptEpoll, EPOLL_CTL_ADD, listenFd, &ev);
+
+    ServerStats stats;
+    if (scoresPath && !stats.scores.open(scoresPath)) LOG_ERROR("could not open score store {}", scoresPath);
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    registry.function("server_sessions", "Connected sessions", METRIC_GAUGE, [&]() { return (double)stats.sessions.load(); });
+    registry.function("server_updates_total", "State updates queued", METRIC_COUNTER, [&]() { return (double)stats.updates.load(); });
+    registry.function("server_writes_total", "send() calls", METRIC_COUNTER, [&]() { return (double)stats.writes.load(); });
+    registry.function("server_bytes_out_total", "Bytes sent", METRIC_COUNTER, [&]() { return (double)stats.bytesOut.load(); });
+    registry.function("server_dropped_total", "Sessions closed for not reading their updates", METRIC_COUNTER,
+                      [&]() { return (double)stats.dropped.load(); });
+    MetricsServer metricsServer(registry);
+    if (metricsPort) {
+        if (metricsServer.start(metricsPort)) LOG_INFO("metrics on http://127.0.0.1:{}/metrics", metricsServer.port());
+        else LOG_ERROR("could not open metrics port {}", metricsPort);
+    }
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(new Worker(stats));
+        workers.back()->start();
+    }
+    LOG_INFO("listening on port {} with {} workers, session size {} bytes", port, workerCount, sizeof(Session));
+
+    long baseResident = residentBytes();
+    int64_t start = monotonicUs();
+    int64_t lastReport = start;
+    uint64_t lastTicks = 0, lastUpdates = 0, lastWrites = 0, lastBytes = 0;
+    size_t nextWorker = 0;
+    while (!stopping) {
+        epoll_event events[1];
+        epoll_wait(acceptEpoll, events, 1, 200);
+        for (;;) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) break;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            workers[nextWorker]->add(fd);
+            nextWorker = (nextWorker + 1) % workers.size();
+        }
+
+        int64_t now = monotonicUs();
+        if (seconds > 0 && now - start >= seconds * 1e6) stopping = true;
+        if (now - lastReport >= 5000000 || stopping) {
+            double interval = (now - lastReport) / 1e6;
+            uint64_t ticks = stats.ticks, updates = stats.updates, writes = stats.writes, bytes = stats.bytesOut;
+            int sessions = stats.sessions;
+            long perSession = sessions ? (residentBytes() - baseResident) / sessions : 0;
+            LOG_INFO("{} sessions | {} ticks/s, {} updates/s in {} writes/s, {} KB/s | {} bytes/session resident, dropped {}",
+                     sessions, (int)((ticks - lastTicks) / interval), (int)((updates - lastUpdates) / interval),
+                     (int)((writes - lastWrites) / interval), (int)((bytes - lastBytes) / interval / 1024), perSession,
+                     stats.dropped.load());
+            LOG_INFO("tick lag avg {} us, p99 <= {} us, max {} us | input latency avg {} us, p99 <= {} us",
+                     (int)stats.tickLag.averageUs(), stats.tickLag.percentileUs(0.99), stats.tickLag.maxUs.load(),
+                     (int)stats.inputLatency.averageUs(), stats.inputLatency.percentileUs(0.99));
+            stats.tickLag.reset();
+            stats.inputLatency.reset();
+            lastTicks = ticks;
+            lastUpdates = updates;
+            lastWrites = writes;
+            lastBytes = bytes;
+            lastReport = now;
+        }
+    }
+
+    for (auto& w : workers) w->join();
+    close(listenFd);
+    close(acceptEpoll);
+    return 0;
+}
@@ -0,0 +1,444 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "PieceColors.hpp"
+#include "Replay.hpp"
+#include "ScoreStore.hpp"
+#include "TetrisBot.hpp"
+#include "TetrisCore.hpp"
+
+// Spectator wall for tournaments: a grid of live boards in one window, each
+// played by a bot or by a replay.
+//
+// All boards live in one shared vertex buffer. Every board owns a fixed range
+// of quads in board-local cell units (cells, ghost, piece, border, grid), and
+// is drawn with its own transform, so moving or zooming a board never touches
+// its vertices. A step only rewrites the quads of cells and pieces that
+// changed, and only those ranges are uploaded. Grid lines and particles are
+// left out when a board is drawn too small for them to be seen.
+//
+// Usage: spectator.exe [--boards 64] [--replay <file>] [--record <file>] [--seconds <n>] [--metrics <port>]
+//                      [--scores <file>]
+//   --replay   every fourth board plays this replay instead of a bot
+//   --record   saves the first game of board 0
+//   --seconds  quits after that long and prints frame time statistics
+//   --metrics  serves live counters on http://127.0.0.1:<port>/metrics
+//   --scores   appends every finished bot game to a score store
+// Click a board to watch it alone, click again to go back to the wall.
+
+typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> WallGame;
+
+const int kWidth = 10;
+const int kHeight = 20;
+const int kCellQuads = kWidth * kHeight;
+const int kGhostQuad = kCellQuads;     // 4 quads
+const int kPieceQuad = kCellQuads + 4; // 4 quads
+const int kBorderQuad = kCellQuads + 8; // 4 quads
+const int kGridQuad = kCellQuads + 12; // grid lines last, so they can be left out of the draw
+const int kQuadsPerBoard = kGridQuad + (kWidth - 1) + (kHeight - 1);
+const int kVerticesPerBoard = kQuadsPerBoard * 4;
+
+const float kGridMinPixels = 8.0f;      // cell size needed for grid lines
+const float kParticleMinPixels = 12.0f; // and for line clear particles
+
+const sf::Color kEmptyColor(12, 12, 32);
+
+struct Particle {
+    int board;
+    sf::Vector2f pos; // board cell units
+    sf::Vector2f velocity;
+    sf::Color color;
+    float life;
+};
+
+struct WallBoard {
+    WallGame game;
+    const Replay* replay = nullptr;
+    size_t replayPos = 0;
+    BotMove move = { 0, 0, 0.0f };
+    bool needMove = true;
+    uint8_t previous = 0;
+
+    uint8_t drawnCells[kCellQuads];
+    Piece drawnPiece = { -1, 0, 0, 0 };
+    int drawnGhostY = -1;
+    size_t dirtyBegin = 0; // vertex range waiting for upload, relative to the board
+    size_t dirtyEnd = 0;
+
+    sf::Transform transform;
+    float cellPixels = 0.0f;
+    bool visible = true;
+};
+
+static void setQuad(sf::Vertex* v, float x, float y, float w, float h, sf::Color color)
+{
+    v[0].position = sf::Vector2f(x, y);
+    v[1].position = sf::Vector2f(x + w, y);
+    v[2].position = sf::Vector2f(x + w, y + h);
+    v[3].position = sf::Vector2f(x, y + h);
+    for (int i = 0; i < 4; i++) v[i].color = color;
+}
+
+static void setQuadColor(sf::Vertex* v, sf::Color color)
+{
+    for (int i = 0; i < 4; i++) v[i].color = color;
+}
+
+static void markDirty(WallBoard& board, int firstQuad, int quadCount)
+{
+    size_t begin = firstQuad * 4;
+    size_t end = (firstQuad + quadCount) * 4;
+    if (board.dirtyBegin == board.dirtyEnd) {
+        board.dirtyBegin = begin;
+        board.dirtyEnd = end;
+    } else {
+        board.dirtyBegin = std::min(board.dirtyBegin, begin);
+        board.dirtyEnd = std::max(board.dirtyEnd, end);
+    }
+}
+
+// Writes the four blocks of a piece at (x, y) into consecutive quads
+static void setPieceQuads(sf::Vertex* v, const Piece& p, int y, sf::Color color)
+{
+    int k = 0;
+    for (int py = 0; py < 4; py++) {
+        for (int px = 0; px < 4; px++) {
+            if (!pieceHasBlock(p.type, p.rotation, px, py)) continue;
+            // Blocks above the field are hidden
+            sf::Color c = y + py < 0 ? sf::Color::Transparent : color;
+            setQuad(v + k * 4, p.x + px + 0.05f, y + py + 0.05f, 0.9f, 0.9f, c);
+            k++;
+        }
+    }
+}
+
+// Quads that never change: cell positions, border and grid lines
+static void initBoardVertices(sf::Vertex* v)
+{
+    for (int i = 0; i < kCellQuads; i++)
+        setQuad(v + i * 4, i % kWidth + 0.05f, i / kWidth + 0.05f, 0.9f, 0.9f, kEmptyColor);
+    for (int i = 0; i < 8; i++) setQuad(v + (kGhostQuad + i) * 4, 0, 0, 0, 0, sf::Color::Transparent);
+    const float t = 0.08f;
+    sf::Color border(200, 200, 200);
+    setQuad(v + (kBorderQuad + 0) * 4, -t, -t, kWidth + 2 * t, t, border);
+    setQuad(v + (kBorderQuad + 1) * 4, -t, kHeight, kWidth + 2 * t, t, border);
+    setQuad(v + (kBorderQuad + 2) * 4, -t, 0, t, kHeight, border);
+    setQuad(v + (kBorderQuad + 3) * 4, kWidth, 0, t, kHeight, border);
+    int q = kGridQuad;
+    for (int x = 1; x < kWidth; x++) setQuad(v + (q++) * 4, x - 0.02f, 0, 0.04f, kHeight, sf::Color(70, 70, 70));
+    for (int y = 1; y < kHeight; y++) setQuad(v + (q++) * 4, 0, y - 0.02f, kWidth, 0.04f, sf::Color(70, 70, 70));
+}
+
+// Places the boards in the grid that gives them the largest cells, or one
+// board alone when it is focused
+static void layoutBoards(std::vector<WallBoard>& boards, int focused, float width, float height)
+{
+    const float margin = 1.0f; // cells of space around each board
+    int count = (int)boards.size();
+    int bestCols = 1;
+    float bestCell = 0.0f;
+    for (int cols = 1; cols <= count; cols++) {
+        int rows = (count + cols - 1) / cols;
+        float cell = std::min(width / (cols * (kWidth + 2 * margin)), height / (rows * (kHeight + 2 * margin)));
+        if (cell > bestCell) {
+            bestCell = cell;
+            bestCols = cols;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        WallBoard& b = boards[i];
+        float cell = bestCell;
+        float left = (i % bestCols) * (kWidth + 2 * margin) * cell + margin * cell;
+        float top = (i / bestCols) * (kHeight + 2 * margin) * cell + margin * cell;
+        b.visible = focused < 0 || focused == i;
+        if (focused == i) {
+            cell = height / (kHeight + 2 * margin);
+            left = (width - kWidth * cell) / 2;
+            top = margin * cell;
+        }
+        b.transform = sf::Transform();
+        b.transform.translate(std::floor(left), std::floor(top)).scale(cell, cell);
+        b.cellPixels = cell;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int boardCount = 64;
+    double seconds = 0.0;
+    int metricsPort = 0;
+    std::string replayPath, recordPath, scoresPath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--boards") == 0) boardCount = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--replay") == 0) replayPath = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--metrics") == 0) metricsPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scores") == 0) scoresPath = argv[++i];
+    }
+
+    ScoreStore scores;
+    if (!scoresPath.empty() && !scores.open(scoresPath)) LOG_ERROR("could not open score store {}", scoresPath);
+
+    GameMetrics gameMetrics;
+    FrameMetrics frameMetrics;
+#ifndef _WIN32
+    MetricsServer metricsServer;
+    if (metricsPort && !metricsServer.start(metricsPort)) LOG_ERROR("could not open metrics port {}", metricsPort);
+#else
+    if (metricsPort) LOG_WARN("the metrics endpoint is not available on Windows");
+#endif
+
+    Replay replay;
+    bool haveReplay = !replayPath.empty() && replay.load(replayPath);
+    if (!replayPath.empty() && !haveReplay) LOG_WARN("could not load replay {}", replayPath);
+    Replay recording;
+    bool recordingDone = recordPath.empty();
+
+    std::vector<WallBoard> boards(boardCount);
+    for (int i = 0; i < boardCount; i++) {
+        WallBoard& b = boards[i];
+        if (haveReplay && i % 4 == 3) {
+            b.replay = &replay;
+            b.game.reset(replay.seed);
+        } else {
+            b.game.reset(1000 + i);
+        }
+        std::memset(b.drawnCells, 0, sizeof(b.drawnCells));
+    }
+    recording.seed = 1000;
+
+    int screenWidth = 1280;
+    int screenHeight = 720;
+    sf::RenderWindow window(sf::VideoMode(screenWidth, screenHeight), "Tetris - Spectator Wall");
+    window.setFramerateLimit(60);
+    int focused = -1;
+    layoutBoards(boards, focused, screenWidth, screenHeight);
+
+    // CPU copy of the shared vertex buffer; falls back to drawing ranges of
+    // it directly when vertex buffers are not supported
+    std::vector<sf::Vertex> vertices((size_t)boardCount * kVerticesPerBoard);
+    for (int i = 0; i < boardCount; i++) initBoardVertices(&vertices[(size_t)i * kVerticesPerBoard]);
+    bool useBuffer = sf::VertexBuffer::isAvailable();
+    sf::VertexBuffer buffer(sf::Quads, sf::VertexBuffer::Stream);
+    if (useBuffer) useBuffer = buffer.create(vertices.size()) && buffer.update(vertices.data());
+
+    std::vector<Particle> particles;
+    sf::VertexArray particleQuads(sf::Quads);
+
+    sf::Font font;
+    bool fontLoaded = font.loadFromFile("assets/fonts/Minecraft.ttf");
+    sf::Text statsText;
+    if (fontLoaded) statsText.setFont(font);
+    statsText.setCharacterSize(14);
+    statsText.setFillColor(sf::Color(0, 255, 0));
+    statsText.setPosition(5, 2);
+
+    uint32_t rng = 12345;
+    sf::Clock clock;
+    sf::Clock runClock;
+    float fps = 60.0f;
+    double frameTotalMs = 0.0;
+    double frameWorstMs = 0.0;
+    long frames = 0;
+    long framesOverBudget = 0;
+    long uploadedVertices = 0;
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) window.close();
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) window.close();
+            if (event.type == sf::Event::Resized) {
+                screenWidth = event.size.width;
+                screenHeight = event.size.height;
+                window.setView(sf::View(sf::FloatRect(0, 0, screenWidth, screenHeight)));
+                layoutBoards(boards, focused, screenWidth, screenHeight);
+            }
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                if (focused >= 0) {
+                    focused = -1;
+                } else {
+                    for (int i = 0; i < boardCount; i++) {
+                        sf::Vector2f topLeft = boards[i].transform.transformPoint(sf::Vector2f(0, 0));
+                        sf::Vector2f bottomRight = boards[i].transform.transformPoint(sf::Vector2f(kWidth, kHeight));
+                        if (event.mouseButton.x >= topLeft.x && event.mouseButton.x < bottomRight.x &&
+                            event.mouseButton.y >= topLeft.y && event.mouseButton.y < bottomRight.y)
+                            focused = i;
+                    }
+                }
+                particles.clear();
+                layoutBoards(boards, focused, screenWidth, screenHeight);
+            }
+        }
+
+        float deltaTime = clock.restart().asSeconds();
+        if (deltaTime > 0.0f) fps += (1.0f / deltaTime - fps) * 0.1f;
+        sf::Clock frameClock;
+
+        // Step every game and rewrite the quads that changed
+        size_t frameUploads = 0;
+        for (int i = 0; i < boardCount; i++) {
+            WallBoard& b = boards[i];
+            WallGame& game = b.game;
+            uint8_t input;
+            if (b.replay) {
+                input = b.replayPos < b.replay->inputs.size() ? b.replay->inputs[b.replayPos++] : 0;
+            } else {
+                if (b.needMove) {
+                    b.move = findBotMove(game);
+                    b.needMove = false;
+                }
+                input = botInput(game.status.piece, b.move, b.previous);
+            }
+            b.previous = input;
+            if (i == 0 && !recordingDone) recording.inputs.push_back(input);
+            game.step(input, Replay::kStepTime);
+
+            const GameStatus& status = game.status;
+            gameMetrics.record(status);
+            // Cells only change when a piece locks, so quiet steps skip the compare
+            bool fieldChanged = status.eventCount > 0;
+            for (int e = 0; e < status.eventCount; e++) {
+                const GameEvent& ev = status.events[e];
+                if (ev.type == EVENT_LOCK) b.needMove = true;
+                if (ev.type == EVENT_LINE && b.visible && b.cellPixels >= kParticleMinPixels) {
+                    for (int x = 0; x < kWidth; x++) {
+                        rng = rng * 1664525u + 1013904223u;
+                        float angle = (rng >> 8) % 628 / 100.0f;
+                        particles.push_back({ i, sf::Vector2f(x + 0.5f, ev.y + 0.5f), sf::Vector2f(std::cos(angle) * 4, std::sin(angle) * 4), sf::Color::White, 0.5f });
+                    }
+                }
+            }
+            bool restarted = false;
+            if ((b.replay && b.replayPos >= b.replay->inputs.size()) || status.gameOver) {
+                if (status.gameOver && !b.replay && scores.isOpen()) {
+                    ScoreRecord record;
+                    record.time = (uint64_t)time(nullptr);
+                    record.score = status.score;
+                    record.lines = status.linesCleared;
+                    record.level = status.level;
+                    record.flags = SCORE_BOT;
+                    record.setMode("spectator");
+                    scores.add(record);
+                }
+                if (i == 0 && !recordingDone) {
+                    recording.save(recordPath);
+                    recordingDone = true;
+                }
+                if (b.replay) {
+                    b.replayPos = 0;
+                    game.reset(b.replay->seed);
+                } else {
+                    game.reset(1000 + i + (uint32_t)frames);
+                }
+                b.needMove = true;
+                restarted = true;
+            }
+
+            sf::Vertex* v = &vertices[(size_t)i * kVerticesPerBoard];
+            if (fieldChanged || restarted) {
+                for (int c = 0; c < kCellQuads; c++) {
+                    int value = game.cell(c % kWidth, c / kWidth);
+                    if (value == b.drawnCells[c]) continue;
+                    setQuadColor(v + c * 4, value ? pieceColor(value) : kEmptyColor);
+                    b.drawnCells[c] = (uint8_t)value;
+                    markDirty(b, c, 1);
+                }
+            }
+            const Piece& p = status.piece;
+            int ghostY = game.ghostY();
+            if (p.type != b.drawnPiece.type || p.rotation != b.drawnPiece.rotation || p.x != b.drawnPiece.x ||
+                p.y != b.drawnPiece.y || ghostY != b.drawnGhostY) {
+                sf::Color color = pieceColor(p.type + 1);
+                setPieceQuads(v + kPieceQuad * 4, p, p.y, color);
+                setPieceQuads(v + kGhostQuad * 4, p, ghostY, sf::Color(color.r, color.g, color.b, 60));
+                b.drawnPiece = p;
+                b.drawnGhostY = ghostY;
+                markDirty(b, kGhostQuad, 8);
+            }
+
+            // Upload only the changed range of this board
+            if (b.dirtyEnd > b.dirtyBegin) {
+                size_t first = (size_t)i * kVerticesPerBoard + b.dirtyBegin;
+                size_t count = b.dirtyEnd - b.dirtyBegin;
+                if (useBuffer) buffer.update(&vertices[first], count, (unsigned)first);
+                frameUploads += count;
+                b.dirtyBegin = b.dirtyEnd = 0;
+            }
+        }
+        uploadedVertices += frameUploads;
+
+        // Particles, only ever spawned on boards big enough to show them
+        particleQuads.clear();
+        for (auto& pt : particles) {
+            pt.life -= deltaTime;
+            pt.pos += pt.velocity * deltaTime;
+            const WallBoard& b = boards[pt.board];
+            sf::Vector2f center = b.transform.transformPoint(pt.pos);
+            float r = 2.0f;
+            sf::Color c = pt.color;
+            c.a = (sf::Uint8)(255 * std::max(0.0f, pt.life * 2.0f));
+            particleQuads.append(sf::Vertex(center + sf::Vector2f(-r, -r), c));
+            particleQuads.append(sf::Vertex(center + sf::Vector2f(r, -r), c));
+            particleQuads.append(sf::Vertex(center + sf::Vector2f(r, r), c));
+            particleQuads.append(sf::Vertex(center + sf::Vector2f(-r, r), c));
+        }
+        particles.erase(std::remove_if(particles.begin(), particles.end(), [](const Particle& p) { return p.life <= 0; }), particles.end());
+
+        // One draw call per board, all from the same buffer
+        window.clear(sf::Color(0, 0, 20));
+        int drawCalls = 0;
+        for (int i = 0; i < boardCount; i++) {
+            const WallBoard& b = boards[i];
+            if (!b.visible) continue;
+            size_t first = (size_t)i * kVerticesPerBoard;
+            size_t count = (b.cellPixels >= kGridMinPixels ? kQuadsPerBoard : kGridQuad) * 4;
+            sf::RenderStates states(b.transform);
+            if (useBuffer) window.draw(buffer, first, count, states);
+            else window.draw(&vertices[first], count, sf::Quads, states);
+            drawCalls++;
+        }
+        if (particleQuads.getVertexCount()) {
+            window.draw(particleQuads);
+            drawCalls++;
+        }
+
+        if (fontLoaded) {
+            statsText.setString("FPS: " + std::to_string((int)fps) + "  boards: " + std::to_string(boardCount) +
+                                "  draw calls: " + std::to_string(drawCalls) + "  vertices updated: " + std::to_string(frameUploads) +
+                                (useBuffer ? "" : "  (no vertex buffer)"));
+            window.draw(statsText);
+        }
+
+        // Frame cost without the frame limiter sleep
+        double frameMs = frameClock.getElapsedTime().asSeconds() * 1000.0;
+        frameTotalMs += frameMs;
+        frameWorstMs = std::max(frameWorstMs, frameMs);
+        frameMetrics.frameSeconds.observe(frameMs / 1000.0);
+        frameMetrics.particles.set((int64_t)particles.size());
+        if (frameMs > 1000.0 / 60.0) framesOverBudget++;
+        frames++;
+        window.display();
+
+        if (seconds > 0 && runClock.getElapsedTime().asSeconds() >= seconds) window.close();
+    }
+
+    if (!recordingDone && !recording.inputs.empty()) recording.save(recordPath);
+    if (frames) {
+        std::cout << frames << " frames with " << boardCount << " boards: frame cost avg " << frameTotalMs / frames << " ms, max "
+                  << frameWorstMs << " ms, " << framesOverBudget << " over 16.7 ms, " << (double)uploadedVertices / frames
+                  << " vertices uploaded per frame (of " << vertices.size() << ")\n";
+    }
+    return 0;
+}
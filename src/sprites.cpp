@@ -0,0 +1,129 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "SpriteAtlas.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteSheets.hpp"
+
+// The sprite examples on the atlas: Pikachu (arrow keys, as in
+// archive_examples/03_1_Pikachu.cpp) among a crowd of running Pikachus and
+// Kens. Every frame comes from one texture and the whole crowd is one draw
+// call, ordered by layer: Kens behind, Pikachus, the player on top.
+// + and - add or remove 1000 sprites.
+// Options:
+//   --count <n>          sprites in the crowd (default 1000)
+//   --save-atlas <file>  also writes the packed atlas to file (PNG) and file.txt
+//   --atlas <file>       uses an atlas written by --save-atlas instead of packing
+
+struct Walker {
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    float start; // on the shared clock, so the crowd does not move in step
+    int clip;
+};
+
+int main(int argc, char** argv)
+{
+    int count = 1000;
+    const char* savePath = nullptr;
+    const char* atlasPath = nullptr;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0) count = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--save-atlas") == 0) savePath = argv[++i];
+        else if (strcmp(argv[i], "--atlas") == 0) atlasPath = argv[++i];
+    }
+
+    const unsigned width = 800, height = 600;
+    sf::RenderWindow window(sf::VideoMode(width, height), "Sprites");
+    window.setFramerateLimit(60);
+
+    SpriteAtlas atlas;
+    if (atlasPath) {
+        if (!atlas.loadFromFile(atlasPath, std::string(atlasPath) + ".txt")) {
+            LOG_ERROR("cannot load the atlas {}", atlasPath);
+            return 1;
+        }
+    } else {
+        sf::Clock packing;
+        if (!addSpriteSheets(atlas) || !atlas.pack()) {
+            LOG_ERROR("cannot pack assets/images into an atlas");
+            return 1;
+        }
+        LOG_INFO("packed {} frames into {}x{} in {} ms", atlas.size(), atlas.getTexture().getSize().x,
+                 atlas.getTexture().getSize().y, packing.getElapsedTime().asMilliseconds());
+    }
+    if (savePath && !atlas.saveToFile(savePath, std::string(savePath) + ".txt")) LOG_WARN("cannot save the atlas to {}", savePath);
+
+    SpriteBatch batch(atlas);
+    const int pikachuRun = batch.addClip(AnimationClip::fromAtlas(atlas, "pikachu_run", 0.1f));
+    const int kenStance = batch.addClip(AnimationClip::fromAtlas(atlas, "ken_stance", 0.15f));
+    if (batch.clip(pikachuRun).frames.empty() || batch.clip(kenStance).frames.empty()) {
+        LOG_ERROR("the atlas has no pikachu_run or ken_stance frames");
+        return 1;
+    }
+
+    std::vector<Walker> crowd;
+    auto spawn = [&](int n) {
+        for (int i = 0; i < n; i++) {
+            Walker w;
+            w.clip = rand() % 4 == 0 ? kenStance : pikachuRun;
+            w.position = sf::Vector2f((float)(rand() % width), (float)(rand() % height));
+            w.velocity = w.clip == kenStance ? sf::Vector2f() : sf::Vector2f(40.0f + rand() % 80, 0.0f);
+            w.start = (rand() % 1000) / 1000.0f;
+            crowd.push_back(w);
+        }
+    };
+    spawn(count);
+    batch.reserve(crowd.size() + 1);
+
+    sf::Vector2f player(400, 300);
+    const float speed = 150.0f;
+    sf::Clock clock, frameClock;
+    float fpsTimer = 0.0f;
+    int frames = 0;
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) window.close();
+            if (event.type != sf::Event::KeyPressed) continue;
+            if (event.key.code == sf::Keyboard::Escape) window.close();
+            if (event.key.code == sf::Keyboard::Add || event.key.code == sf::Keyboard::Equal) spawn(1000);
+            if ((event.key.code == sf::Keyboard::Subtract || event.key.code == sf::Keyboard::Hyphen) && !crowd.empty())
+                crowd.resize(crowd.size() - std::min<size_t>(1000, crowd.size()));
+        }
+
+        float dt = frameClock.restart().asSeconds();
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) player.x -= speed * dt;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) player.x += speed * dt;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) player.y -= speed * dt;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) player.y += speed * dt;
+
+        batch.setTime(clock.getElapsedTime().asSeconds());
+        batch.clear();
+        for (Walker& w : crowd) {
+            w.position += w.velocity * dt;
+            if (w.position.x > width) w.position.x = -64.0f;
+            batch.addAnimated(w.clip, w.start, w.position, w.clip == kenStance ? 0 : 1);
+        }
+        batch.addAnimated(pikachuRun, 0.0f, player, 2, sf::Color(255, 200, 200), 2.0f);
+
+        window.clear(sf::Color(30, 30, 40));
+        batch.draw(window);
+        window.display();
+
+        frames++;
+        fpsTimer += dt;
+        if (fpsTimer >= 1.0f) {
+            window.setTitle("Sprites - " + std::to_string(batch.size()) + " sprites, 1 draw call, " +
+                            std::to_string(frames) + " fps");
+            fpsTimer = 0.0f;
+            frames = 0;
+        }
+    }
+    return 0;
+}
@@ -5,16 +5,29 @@
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include "BlockSkin.hpp"
+#include "CpuMeter.hpp"
+#include "Debris.hpp"
+#include "FrameCapture.hpp"
+#include "GameWindow.hpp"
+#include "GpuReadback.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "PieceColors.hpp"
+#include "PieceSet.hpp"
+#include "QualityGovernor.hpp"
+#include "ScoreStore.hpp"
+#include "SoundEffects.hpp"
+#include "SpriteBatch.hpp"
+#include "TetrisBot.hpp"
+#include "TetrisCore.hpp"
 
 // Classic Tetris minimal implementation
 
-struct Piece {
-    int type;
-    int rotation;
-    int x;
-    int y;
-};
-
 struct Effect {
     sf::Vector2f pos;
     sf::Color color;
@@ -23,62 +36,149 @@ struct Effect {
 
 enum GameState { MENU, PLAYING, GAME_OVER };
 
-int main()
+typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> StandardGame;
+
+METRICS_COUNT_ALLOCATIONS
+
+int main(int argc, char** argv)
 {
-    const int screenWidth = 400;
-    const int screenHeight = 520;
+    // --cpu-stats prints the process CPU usage every few seconds
+    // --synthetic-load <ms> burns that much CPU per frame to exercise the quality governor
+    // --check-layers reads the cached layers back after every starfield change
+    //     and checks the field layer against the background outside the field
+    // --mode <name> picks the board size and rule set (standard, wide, tall, classic)
+    // --cascade makes floating blocks fall after special clears
+    // --gravity <rows per tick> a fixed fall speed instead of the level's, up
+    //     to 20 (20G: pieces drop onto the stack as they appear)
+    // --lock-delay <ticks> how long a piece rests on the stack before locking
+    //     (default 30, ticks are 1/60 s); --lock-resets <n> how many moves or
+    //     rotations start that wait over (default 15)
+    // --pieces <file> plays a piece set from a definition file (see PieceSet.hpp),
+    //     e.g. assets/pieces/pentomino.txt, instead of the built-in tetrominoes
+    // --debris turns cleared and exploded blocks into falling physics debris (F5 toggles)
+    // --skin <bevel|flat|file.png> block textures: beveled (default), plain
+    //     colors, or a PNG of square tiles side by side in cell value order
+    // --capture <file.y4m|file.rgba> records every frame to a video file
+    // --pacing <hybrid|vsync|uncapped> how frames are spaced: an exact 60 Hz
+    //     period (sleep, then spin; default), the display's vsync, or no cap
+    // --metrics <port> serves live counters on http://127.0.0.1:<port>/metrics
+    // --scores <file> keeps high scores and game history there (default scores.dat)
+    // --train <games> has the bot play that many seeded games as fast as possible
+    //     through the normal update and draw code, then prints the timings
+    //     (the training run of the profile-guided build, see the makefile)
+    bool cpuStats = false;
+    bool checkLayers = false;
+    const char* capturePath = nullptr;
+    const char* scoresPath = "scores.dat";
+    const char* skinName = "bevel";
+    PacingMode pacing = PACING_HYBRID;
+    bool cascade = false;
+    double gravityRows = 0.0;
+    int lockDelay = kLockDelay;
+    int lockResets = kLockResets;
+    bool debrisMode = false;
+    float syntheticLoadMs = 0.0f;
+    int metricsPort = 0;
+    int trainGames = 0;
+    const GameVariant* variant = &gameVariants[0];
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cpu-stats") == 0) cpuStats = true;
+        if (strcmp(argv[i], "--check-layers") == 0) checkLayers = true;
+        if (strcmp(argv[i], "--cascade") == 0) cascade = true;
+        if (strcmp(argv[i], "--debris") == 0) debrisMode = true;
+        if (strcmp(argv[i], "--gravity") == 0 && i + 1 < argc) gravityRows = atof(argv[++i]);
+        if (strcmp(argv[i], "--lock-delay") == 0 && i + 1 < argc) lockDelay = std::max(0, atoi(argv[++i]));
+        if (strcmp(argv[i], "--lock-resets") == 0 && i + 1 < argc) lockResets = std::max(0, atoi(argv[++i]));
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+        if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) metricsPort = atoi(argv[++i]);
+        if (strcmp(argv[i], "--scores") == 0 && i + 1 < argc) scoresPath = argv[++i];
+        if (strcmp(argv[i], "--skin") == 0 && i + 1 < argc) skinName = argv[++i];
+        if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!loadPieceSet(argv[++i], pieceTable, error)) {
+                std::cerr << "Cannot load piece set " << argv[i] << ": " << error << "\n";
+                return 1;
+            }
+        }
+        if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc && !parsePacingMode(argv[++i], pacing)) {
+            std::cerr << "Unknown pacing " << argv[i] << ", use hybrid, vsync or uncapped\n";
+            return 1;
+        }
+        if (strcmp(argv[i], "--train") == 0 && i + 1 < argc) trainGames = atoi(argv[++i]);
+        if (strcmp(argv[i], "--synthetic-load") == 0 && i + 1 < argc) syntheticLoadMs = (float)atof(argv[++i]);
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            variant = findGameVariant(argv[++i]);
+            if (!variant) {
+                std::cerr << "Unknown mode " << argv[i] << ". Available modes:\n";
+                for (const auto& v : gameVariants) std::cerr << "  " << v.name << " - " << v.description << "\n";
+                return 1;
+            }
+        }
+    }
 
-    const int fieldWidth = 10;
-    const int fieldHeight = 20;
-    const int blockSize = 24;
+    // The bot needs the concrete board type, so training uses the standard mode
+    StandardGame* botGame = nullptr;
+    std::unique_ptr<GameCore> game;
+    if (trainGames > 0) {
+        botGame = new StandardGame();
+        game.reset(botGame);
+        variant = &gameVariants[0];
+    } else {
+        game = variant->create();
+    }
+    const GameStatus& status = game->status;
+    game->cascade = cascade;
+    game->gravity = (int32_t)(std::min(std::max(gravityRows, 0.0), 20.0) * kGravityUnit);
+    game->lockDelay = lockDelay;
+    game->lockResets = lockResets;
+
+    const int fieldWidth = game->width();
+    const int fieldHeight = game->height();
+    const int blockSize = std::min(24, 480 / fieldHeight);
     const int offsetX = 50;
-    const int offsetY = (screenHeight - fieldHeight * blockSize) / 2;
+    const int hudX = offsetX + fieldWidth * blockSize + 10;
 
-    std::vector<int> field(fieldWidth * fieldHeight, 0);
-
-    // Tetromino definitions (4x4)
-    std::string tetromino[11];
-    tetromino[0] = "..X...X...X...X."; // I
-    tetromino[1] = "..X..XX...X....."; // T
-    tetromino[2] = ".X..XX..X......."; // S
-    tetromino[3] = "..X..XX..X......"; // Z
-    tetromino[4] = ".XX..XX........."; // O
-    tetromino[5] = ".X...X...XX....."; // L
-    tetromino[6] = "..X...X..XX....."; // J
-    tetromino[7] = "..X..XX..X......"; // Frozen (same as Z for simplicity)
-    tetromino[8] = ".XX..XX........."; // Electrical (same as O)
-    tetromino[9] = "..X..XX...X....."; // Fire (same as T)
-    tetromino[10] = "..X...X...X...X."; // Ghost (same as I)
-
-    auto rotate = [](int px, int py, int r) {
-        switch (r % 4) {
-        case 0: return py * 4 + px;
-        case 1: return 12 + py - (px * 4);
-        case 2: return 15 - py * 4 - px;
-        case 3: return 3 - py + (px * 4);
-        }
-        return 0;
-    };
+    const int screenWidth = std::max(400, hudX + 100);
+    const int screenHeight = 520;
+    const int offsetY = (screenHeight - fieldHeight * blockSize) / 2;
 
-    auto doesPieceFit = [&](int tetrominoIndex, int rotation, int posX, int posY) {
-        for (int px = 0; px < 4; px++)
-            for (int py = 0; py < 4; py++) {
-                int pi = rotate(px, py, rotation);
-                int fi = (posY + py) * fieldWidth + (posX + px);
-
-                if (posX + px >= 0 && posX + px < fieldWidth && posY + py >= 0 && posY + py < fieldHeight) {
-                    if (tetromino[tetrominoIndex][pi] == 'X' && field[fi] != 0)
-                        return false;
-                } else {
-                    if (tetromino[tetrominoIndex][pi] == 'X')
-                        return false;
-                }
-            }
-        return true;
-    };
+    GameWindow window(screenWidth, screenHeight, "Tetris", trainGames > 0 ? PACING_UNCAPPED : pacing);
 
-    sf::RenderWindow window(sf::VideoMode(screenWidth, screenHeight), "Tetris");
-    window.setFramerateLimit(60);
+    GameMetrics gameMetrics;
+    FrameMetrics frameMetrics;
+#ifndef _WIN32
+    MetricsServer metricsServer;
+    if (metricsPort) {
+        if (metricsServer.start(metricsPort)) LOG_INFO("metrics on http://127.0.0.1:{}/metrics", metricsServer.port());
+        else LOG_ERROR("could not open metrics port {}", metricsPort);
+    }
+#else
+    if (metricsPort) LOG_WARN("the metrics endpoint is not available on Windows");
+#endif
+
+    // High scores survive the session; records are written by the store's
+    // own thread, so game over never waits for the disk
+    ScoreStore scores;
+    if (trainGames == 0 && !scores.open(scoresPath)) LOG_WARN("scores will not be saved, cannot open {}", scoresPath);
+    sf::Clock gameClock;
+    int piecesPlaced = 0;
+    std::string gameOverInfo;
+
+    // Gameplay recording: frames are read back asynchronously and written by
+    // a worker thread, dropping frames rather than slowing the game down
+    std::unique_ptr<FrameCapture> capture;
+    std::unique_ptr<GpuReadback> readback;
+    if (capturePath) {
+        capture.reset(new FrameCapture(capturePath, screenWidth, screenHeight));
+        if (capture->isOpen()) {
+            readback.reset(new GpuReadback(screenWidth, screenHeight));
+            if (!readback->isAvailable()) LOG_WARN("cannot read frames back, nothing will be captured");
+            else if (!readback->isAsynchronous()) LOG_WARN("no pixel buffer objects, capture reads back synchronously");
+        } else {
+            LOG_ERROR("could not open {} for capture", capturePath);
+            capture.reset();
+        }
+    }
 
     // Stars for space background
     std::vector<sf::Vector2f> stars;
@@ -86,6 +186,77 @@ int main()
         stars.push_back(sf::Vector2f(rand() % screenWidth, rand() % screenHeight));
     }
 
+    // Frame-budget governor, lowers effect quality when frames get slow
+    QualityGovernor governor;
+
+    // Cached layers. The starfield only changes with the quality level and the
+    // locked blocks only change when a piece locks, so they live in render
+    // textures and only the cells that changed since the last frame are redrawn.
+    sf::RenderTexture backgroundLayer;
+    backgroundLayer.create(screenWidth, screenHeight);
+    int drawnStars = -1;
+    auto drawBackgroundLayer = [&](int starCount) {
+        backgroundLayer.clear(sf::Color(0, 0, 20)); // Dark blue space background
+        for (int i = 0; i < starCount && i < (int)stars.size(); i++) {
+            sf::CircleShape s(1);
+            s.setPosition(stars[i]);
+            s.setFillColor(sf::Color::White);
+            backgroundLayer.draw(s);
+        }
+        backgroundLayer.display();
+        drawnStars = starCount;
+    };
+    drawBackgroundLayer(governor.settings().starCount);
+
+    sf::RenderTexture fieldLayer;
+    fieldLayer.create(screenWidth, screenHeight);
+    fieldLayer.draw(sf::Sprite(backgroundLayer.getTexture()));
+    fieldLayer.display();
+    std::vector<int> drawnField(fieldWidth * fieldHeight, 0); // what fieldLayer shows
+
+    // Pixels outside the field where fieldLayer differs from backgroundLayer
+    auto layerMismatches = [&]() {
+        const sf::Image field = fieldLayer.getTexture().copyToImage();
+        const sf::Image background = backgroundLayer.getTexture().copyToImage();
+        const sf::IntRect cells(offsetX, offsetY, fieldWidth * blockSize, fieldHeight * blockSize);
+        int mismatches = 0;
+        for (int y = 0; y < screenHeight; y++)
+            for (int x = 0; x < screenWidth; x++)
+                if (!cells.contains(x, y) && field.getPixel(x, y) != background.getPixel(x, y)) mismatches++;
+        return mismatches;
+    };
+
+    // Border and grid are drawn over the pieces
+    sf::RenderTexture gridLayer;
+    gridLayer.create(screenWidth, screenHeight);
+    bool drawnGrid = false;
+    auto drawGridLayer = [&](bool gridLines) {
+        gridLayer.clear(sf::Color::Transparent);
+        sf::RectangleShape border(sf::Vector2f(fieldWidth * blockSize, fieldHeight * blockSize));
+        border.setPosition(offsetX, offsetY);
+        border.setFillColor(sf::Color::Transparent);
+        border.setOutlineThickness(2);
+        border.setOutlineColor(sf::Color::White);
+        gridLayer.draw(border);
+        if (gridLines) {
+            for (int i = 1; i < fieldWidth; i++) {
+                sf::RectangleShape line(sf::Vector2f(1, fieldHeight * blockSize));
+                line.setPosition(i * blockSize + offsetX, offsetY);
+                line.setFillColor(sf::Color(100, 100, 100));
+                gridLayer.draw(line);
+            }
+            for (int i = 1; i < fieldHeight; i++) {
+                sf::RectangleShape line(sf::Vector2f(fieldWidth * blockSize, 1));
+                line.setPosition(offsetX, i * blockSize + offsetY);
+                line.setFillColor(sf::Color(100, 100, 100));
+                gridLayer.draw(line);
+            }
+        }
+        gridLayer.display();
+        drawnGrid = gridLines;
+    };
+    drawGridLayer(governor.settings().gridLines);
+
     // Background music
     sf::Music music;
     if (music.openFromFile("assets/music/space.ogg")) {
@@ -93,30 +264,25 @@ int main()
         music.play();
     }
 
-    // block rectangles
-    sf::RectangleShape block(sf::Vector2f(blockSize - 1, blockSize - 1));
-
-    // Colors for pieces
-    sf::Color colors[12] = {
-        sf::Color::Black,
-        sf::Color::Cyan,       // I
-        sf::Color(128, 0, 128), // T
-        sf::Color::Green,      // S
-        sf::Color::Red,        // Z
-        sf::Color::Yellow,     // O
-        sf::Color(255, 165, 0), // L
-        sf::Color::Blue,       // J
-        sf::Color::Magenta,    // Frozen
-        sf::Color::Yellow,     // Electrical
-        sf::Color::Red,        // Fire
-        sf::Color::Green       // Ghost
-    };
+    // Sound effects (buffers are prepared here, before the game loop)
+    SoundEffects sfx;
+
+    // Block textures share one atlas, so the field cells redrawn in a frame
+    // and the falling piece are one draw call each
+    BlockSkin skin;
+    if (!skin.load(skinName, blockSize)) {
+        LOG_WARN("cannot load block skin {}, using bevel", skinName);
+        skin.load("bevel", blockSize);
+    }
+    SpriteBatch fieldBatch(skin.getAtlas());
+    SpriteBatch pieceBatch(skin.getAtlas());
+    std::vector<sf::Vertex> backgroundPatches; // starfield under the field cells being redrawn
 
     // Load font
     sf::Font font;
     bool fontLoaded = font.loadFromFile("assets/fonts/Minecraft.ttf");
     if (!fontLoaded) {
-        std::cerr << "Warning: font not loaded. Expected assets/fonts/Minecraft.ttf\n";
+        LOG_WARN("font not loaded, expected assets/fonts/Minecraft.ttf");
     }
 
     // Button for menu and game over
@@ -145,93 +311,181 @@ int main()
         pauseText.setFillColor(sf::Color::White);
     }
 
-    // Game variables
+    // Debug overlay (F3): frame rate, frame cost, effects and quality level.
+    // F4 cycles a synthetic per-frame load to exercise the governor.
+    bool showDebug = false;
+    float fps = 0.0f;
+    sf::Text debugText;
+    if (fontLoaded) debugText.setFont(font);
+    debugText.setCharacterSize(14);
+    debugText.setPosition(5, 2);
+    debugText.setFillColor(sf::Color(0, 255, 0));
+
+    // HUD text, the strings are only rebuilt when the values change
+    sf::Text scoreText, linesText, levelText;
+    sf::Text* hudTexts[3] = { &scoreText, &linesText, &levelText };
+    for (int i = 0; i < 3; i++) {
+        if (fontLoaded) hudTexts[i]->setFont(font);
+        hudTexts[i]->setCharacterSize(20);
+        hudTexts[i]->setPosition(hudX, 50 + i * 30);
+        hudTexts[i]->setFillColor(sf::Color::White);
+    }
+
+    // Game variables (the rules themselves live in the game core)
     GameState state = MENU;
-    Piece currentPiece;
-    int score = 0;
-    int linesCleared = 0;
-    int level = 1;
-    float speed = 0.5f;
-    float speedCounter = 0.0f;
     bool isPaused = false;
     std::vector<Effect> effects;
-
-    // Special pieces
-    int pieceCounter = 0;
-    bool isFrozen = false;
-    float freezeTimer = 0.0f;
-    const float freezeDuration = 3.0f; // seconds
+    DebrisField debris((float)blockSize, 0.0f, (float)screenWidth, (float)(offsetY + fieldHeight * blockSize));
     int ghostShadowY = 0;
+    int chainCount = 0;      // last cascade chain length
+    float chainTimer = 0.0f; // seconds left on the chain banner
+
+    // Damage tracking: the frame is only redrawn when something visible changed
+    bool needsRedraw = true;
+    bool fieldChanged = true;
+    Piece drawnPiece = { -1, 0, 0, 0 };
+    int drawnGhostY = -1;
+    int drawnScore = -1;
+    int drawnLines = -1;
+    size_t drawnEffects = 0;
+    bool drawnDebris = false;
+    bool drawnChain = false;
+
+    CpuMeter cpuMeter;
+    sf::Clock clock;
 
-    // Input timing
-    float moveDelay = 0.12f;
-    float moveTimer = 0.0f;
-    bool rotatePrev = false;
-    bool spacePrev = false;
+    // Spawns one effect particle on a field cell, thinned out by the quality level.
+    // In debris mode the block that was there flies off instead, in its own
+    // color (blockValue); particleColor is used for the plain particle.
+    float particleBudget = 0.0f;
+    auto spawnEffect = [&](int x, int y, sf::Color particleColor, int blockValue) {
+        const QualitySettings& quality = governor.settings();
+        particleBudget += quality.particleFraction;
+        if (particleBudget < 1.0f) return;
+        particleBudget -= 1.0f;
+        if (debrisMode && blockValue != 0) {
+            float cx = x * blockSize + offsetX + blockSize / 2.0f;
+            float cy = y * blockSize + offsetY + blockSize / 2.0f;
+            float side = (x - fieldWidth / 2 + 0.5f) / fieldWidth; // blocks fly away from the center
+            float vx = side * 400.0f + (rand() % 101 - 50);
+            float vy = -250.0f - rand() % 200;
+            float spin = (rand() % 1201 - 600) / 100.0f;
+            debris.spawn(cx, cy, pieceColor(blockValue), vx, vy, spin);
+            return;
+        }
+        effects.push_back({sf::Vector2f(x * blockSize + offsetX + blockSize / 2, y * blockSize + offsetY + blockSize / 2), particleColor, 0.5f * quality.effectLife});
+    };
 
-    sf::Clock clock;
+    // Training: fixed seeds and step, the bot's current target and a checksum
+    // of the final scores, which must match between builds
+    uint32_t trainSeed = 1;
+    int trainPlayed = 0;
+    uint64_t trainChecksum = 0, trainFrames = 0;
+    BotMove botMove = { 0, 0, 0.0f };
+    bool botNeedsMove = true;
+    uint8_t botPrevious = 0;
 
     auto resetGame = [&]() {
-        field.assign(fieldWidth * fieldHeight, 0);
-        currentPiece.type = rand() % 7;
-        currentPiece.rotation = 0;
-        currentPiece.x = fieldWidth / 2 - 2;
-        currentPiece.y = 0;
-        score = 0;
-        linesCleared = 0;
-        level = 1;
-        speedCounter = 0.0f;
-        pieceCounter = 0;
-        isFrozen = false;
-        freezeTimer = 0.0f;
+        game->reset(trainGames > 0 ? trainSeed++ : (uint32_t)rand());
+        botNeedsMove = true;
         isPaused = false;
         effects.clear();
+        debris.clear();
+        chainTimer = 0.0f;
         state = PLAYING;
+        fieldChanged = true;
+        gameClock.restart();
+        piecesPlaced = 0;
+    };
+
+    auto saveScore = [&]() {
+        if (!scores.isOpen()) return;
+        ScoreRecord record;
+        record.time = (uint64_t)time(NULL);
+        record.score = status.score;
+        record.lines = status.linesCleared;
+        record.level = status.level;
+        record.durationMs = (uint32_t)gameClock.getElapsedTime().asMilliseconds();
+        record.pieces = (uint32_t)piecesPlaced;
+        record.setMode(variant->name);
+        scores.add(record);
+        std::vector<ScoreRecord> best = scores.top(1);
+        gameOverInfo = "Best: " + std::to_string(best.empty() ? status.score : best[0].score) + "\nRank: " +
+                       std::to_string(scores.rank(status.score)) + " of " + std::to_string(scores.count());
     };
 
     srand((unsigned)time(NULL));
 
-    // Game loop
-    while (window.isOpen()) {
-        float deltaTime = clock.restart().asSeconds();
-        speedCounter += deltaTime;
-        moveTimer += deltaTime;
+    auto handleEvent = [&](const sf::Event& event) {
+        if (event.type == sf::Event::Closed)
+            window.close();
 
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-
-            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) window.close();
-
-            // Mouse click for buttons
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-                if (state == MENU) {
-                    sf::FloatRect buttonBounds = button.getGlobalBounds();
-                    if (buttonBounds.contains(mousePos.x, mousePos.y)) {
-                        resetGame();
-                    }
-                } else if (state == GAME_OVER) {
-                    sf::FloatRect buttonBounds = button.getGlobalBounds();
-                    if (buttonBounds.contains(mousePos.x, mousePos.y)) {
-                        resetGame();
-                    }
-                } else if (state == PLAYING) {
-                    sf::FloatRect pauseBounds = pauseButton.getGlobalBounds();
-                    if (pauseBounds.contains(mousePos.x, mousePos.y)) {
-                        isPaused = !isPaused;
-                    }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) window.close();
+
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+            showDebug = !showDebug;
+            window.getPacer().resetStats();
+            needsRedraw = true;
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) {
+            syntheticLoadMs = syntheticLoadMs >= 32.0f ? 0.0f : (syntheticLoadMs == 0.0f ? 8.0f : syntheticLoadMs * 2.0f);
+            needsRedraw = true;
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5) {
+            debrisMode = !debrisMode;
+            if (!debrisMode) debris.clear();
+            needsRedraw = true;
+        }
+
+        // The window contents may have been lost
+        if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) needsRedraw = true;
+
+        // Mouse click for buttons
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            sf::Vector2i mousePos = sf::Mouse::getPosition(window);
+            if (state == MENU) {
+                sf::FloatRect buttonBounds = button.getGlobalBounds();
+                if (buttonBounds.contains(mousePos.x, mousePos.y)) {
+                    resetGame();
+                    needsRedraw = true;
+                }
+            } else if (state == GAME_OVER) {
+                sf::FloatRect buttonBounds = button.getGlobalBounds();
+                if (buttonBounds.contains(mousePos.x, mousePos.y)) {
+                    resetGame();
+                    needsRedraw = true;
+                }
+            } else if (state == PLAYING) {
+                sf::FloatRect pauseBounds = pauseButton.getGlobalBounds();
+                if (pauseBounds.contains(mousePos.x, mousePos.y)) {
+                    isPaused = !isPaused;
+                    needsRedraw = true;
                 }
             }
         }
+    };
 
-        // Handle freeze
-        if (state == PLAYING && isFrozen) {
-            freezeTimer -= deltaTime;
-            if (freezeTimer <= 0) {
-                isFrozen = false;
-            }
+    if (trainGames > 0) resetGame();
+    auto trainStart = std::chrono::steady_clock::now();
+
+    // Game loop
+    while (window.isOpen()) {
+        sf::Event event;
+
+        // Menu, pause and game over with nothing animating: block until the
+        // next input event instead of redrawing the same frame
+        if (!needsRedraw && !capture && effects.empty() && debris.empty() && (state != PLAYING || isPaused)) {
+            if (window.waitEvent(event)) handleEvent(event);
+            window.getPacer().restart();
+            clock.restart();
+        }
+
+        float deltaTime = clock.restart().asSeconds();
+        if (deltaTime > 0.0f) fps += (1.0f / deltaTime - fps) * 0.1f;
+        if (trainGames > 0) deltaTime = 1.0f / 60.0f;
+
+        while (window.pollEvent(event)) {
+            handleEvent(event);
         }
 
         // Update effects
@@ -239,166 +493,174 @@ int main()
             e.life -= deltaTime;
         }
         effects.erase(std::remove_if(effects.begin(), effects.end(), [](const Effect& e) { return e.life <= 0; }), effects.end());
-
-        // Calculate ghost shadow
-        if (state == PLAYING && currentPiece.type == 10) { // Ghost
-            ghostShadowY = currentPiece.y;
-            while (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x, ghostShadowY + 1)) {
-                ghostShadowY++;
-            }
-        }
-
-        // Real-time input handling (allows holding keys)
-        if (state == PLAYING && !isFrozen && !isPaused) {
-            if (moveTimer >= moveDelay) {
-                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
-                    if (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x - 1, currentPiece.y)) currentPiece.x -= 1;
-                    moveTimer = 0.0f;
-                } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-                    if (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x + 1, currentPiece.y)) currentPiece.x += 1;
-                    moveTimer = 0.0f;
+        if (chainTimer > 0.0f) chainTimer -= deltaTime;
+        if (!isPaused) debris.update(deltaTime);
+
+        // Update the game with the keys held this frame (allows holding keys)
+        if (state == PLAYING && !isPaused) {
+            uint8_t input = 0;
+            if (botGame) {
+                if (botNeedsMove) {
+                    botMove = findBotMove(*botGame);
+                    botNeedsMove = false;
                 }
+                input = botInput(status.piece, botMove, botPrevious);
+                botPrevious = input;
+            } else {
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) input |= INPUT_LEFT;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) input |= INPUT_RIGHT;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) input |= INPUT_ROTATE;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) input |= INPUT_SOFT_DROP;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) input |= INPUT_HARD_DROP;
             }
-
-            // Rotation: detect edge (press)
-            bool rotateNow = sf::Keyboard::isKeyPressed(sf::Keyboard::Up);
-            if (rotateNow && !rotatePrev) {
-                if (doesPieceFit(currentPiece.type, currentPiece.rotation + 1, currentPiece.x, currentPiece.y)) currentPiece.rotation += 1;
+            // Cleared cells are colored from what is on screen; the blocks of a
+            // piece that locked during this step are not drawn yet
+            const int steppedPiece = status.piece.type + 1;
+            auto clearedBlock = [&](int x, int y) {
+                if (x < 0 || x >= fieldWidth || y < 0 || y >= fieldHeight) return 0;
+                int value = drawnField[y * fieldWidth + x];
+                return value > 0 ? value : steppedPiece;
+            };
+            game->step(input, deltaTime);
+            gameMetrics.record(status);
+
+            // Sounds and particles for what happened during the step
+            bool lineSound = false;
+            bool fireSound = false;
+            for (int i = 0; i < status.eventCount; i++) {
+                const GameEvent& e = status.events[i];
+                switch (e.type) {
+                case EVENT_LOCK:
+                    fieldChanged = true;
+                    piecesPlaced++;
+                    botNeedsMove = true;
+                    break;
+                case EVENT_LINE:
+                    for (int x = 0; x < fieldWidth; x++) spawnEffect(x, e.y, sf::Color::White, clearedBlock(x, e.y));
+                    lineSound = true;
+                    break;
+                case EVENT_FROZEN:
+                    sfx.trigger(SFX_FROZEN);
+                    break;
+                case EVENT_ELECTRICAL:
+                    for (int x = 0; x < fieldWidth; x++) spawnEffect(x, e.y, sf::Color::Yellow, clearedBlock(x, e.y));
+                    sfx.trigger(SFX_ELECTRICAL);
+                    break;
+                case EVENT_FIRE:
+                    spawnEffect(e.x, e.y, sf::Color::Red, clearedBlock(e.x, e.y));
+                    fireSound = true;
+                    break;
+                case EVENT_CASCADE:
+                    // Steps arrive in order, the banner shows the last one
+                    chainCount = e.x;
+                    chainTimer = 1.0f;
+                    break;
+                case EVENT_GAME_OVER:
+                    state = GAME_OVER;
+                    if (trainGames == 0) saveScore();
+                    break;
+                default:
+                    break;
+                }
             }
-            rotatePrev = rotateNow;
+            if (lineSound) sfx.trigger(SFX_LINE_CLEAR);
+            if (fireSound) sfx.trigger(SFX_FIRE);
 
-            // Soft drop (hold Down)
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
-                if (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x, currentPiece.y + 1)) currentPiece.y += 1;
-            }
+            if (pieceEffect(status.piece.type) == EFFECT_GHOST) ghostShadowY = game->ghostY();
+        }
 
-            // Hard drop (Space) detect edge
-            bool spaceNow = sf::Keyboard::isKeyPressed(sf::Keyboard::Space);
-            if (spaceNow && !spacePrev) {
-                while (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x, currentPiece.y + 1)) currentPiece.y++;
-                speedCounter = speed; // force lock next update
+        if (trainGames > 0) {
+            trainFrames++;
+            if (state == GAME_OVER) {
+                trainChecksum = trainChecksum * 31 + (uint64_t)status.score;
+                if (++trainPlayed >= trainGames) window.close();
+                else resetGame();
             }
-            spacePrev = spaceNow;
         }
 
-        // Gravity
-        if (state == PLAYING && !isFrozen && !isPaused && speedCounter >= speed) {
-            if (doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x, currentPiece.y + 1)) {
-                currentPiece.y += 1;
-            } else {
-                // Lock piece
-                for (int px = 0; px < 4; px++) {
-                    for (int py = 0; py < 4; py++) {
-                        int pi = rotate(px, py, currentPiece.rotation);
-                        if (tetromino[currentPiece.type][pi] == 'X') {
-                            int fi = (currentPiece.y + py) * fieldWidth + (currentPiece.x + px);
-                            if (fi >= 0 && fi < (int)field.size())
-                                field[fi] = currentPiece.type + 1;
-                        }
-                    }
-                }
-
-                // Special effects
-                if (currentPiece.type == 7) { // Frozen
-                    isFrozen = true;
-                    freezeTimer = freezeDuration;
-                } else if (currentPiece.type == 8) { // Electrical
-                    // Clear two rows where the piece landed
-                    int row1 = currentPiece.y;
-                    int row2 = currentPiece.y - 1;
-                    if (row1 >= 0 && row1 < fieldHeight) {
-                        for (int x = 0; x < fieldWidth; x++) {
-                            field[row1 * fieldWidth + x] = 0;
-                        }
-                        score += 100; // Points for clearing a row
-                        // Add spark effects
-                        for (int x = 0; x < fieldWidth; x++) {
-                            effects.push_back({{x * blockSize + offsetX + blockSize / 2, row1 * blockSize + offsetY + blockSize / 2}, sf::Color::Yellow, 0.5f});
-                        }
-                    }
-                    if (row2 >= 0 && row2 < fieldHeight) {
-                        for (int x = 0; x < fieldWidth; x++) {
-                            field[row2 * fieldWidth + x] = 0;
-                        }
-                        score += 100; // Points for clearing a row
-                        // Add spark effects
-                        for (int x = 0; x < fieldWidth; x++) {
-                            effects.push_back({{x * blockSize + offsetX + blockSize / 2, row2 * blockSize + offsetY + blockSize / 2}, sf::Color::Yellow, 0.5f});
-                        }
-                    }
-                } else if (currentPiece.type == 9) { // Fire
-                    // Explode blocks around the piece
-                    int blocksCleared = 0;
-                    for (int ex = -2; ex <= 2; ex++) {
-                        for (int ey = -2; ey <= 2; ey++) {
-                            int nx = currentPiece.x + ex;
-                            int ny = currentPiece.y + ey;
-                            if (nx >= 0 && nx < fieldWidth && ny >= 0 && ny < fieldHeight && field[ny * fieldWidth + nx] != 0) {
-                                field[ny * fieldWidth + nx] = 0;
-                                blocksCleared++;
-                                // Add fire effects
-                                effects.push_back({{nx * blockSize + offsetX + blockSize / 2, ny * blockSize + offsetY + blockSize / 2}, sf::Color::Red, 0.5f});
-                            }
-                        }
-                    }
-                    score += blocksCleared * 10; // Points for each block cleared
-                }
-
-                // Check lines
-                for (int py = 0; py < 4; py++) {
-                    int y = currentPiece.y + py;
-                    if (y >= 0 && y < fieldHeight) {
-                        bool line = true;
-                        for (int x = 0; x < fieldWidth; x++) {
-                            if (field[y * fieldWidth + x] == 0) { line = false; break; }
-                        }
-                        if (line) {
-                            // remove line
-                            for (int ty = y; ty > 0; ty--) {
-                                for (int x = 0; x < fieldWidth; x++) {
-                                    field[ty * fieldWidth + x] = field[(ty - 1) * fieldWidth + x];
-                                }
-                            }
-                            for (int x = 0; x < fieldWidth; x++) {
-                                field[x] = 0;
-                            }
-                            score += 100;
-                            linesCleared++;
-                            level = linesCleared / 10 + 1;
-                            speed = 0.5f / (level * 0.5f + 0.5f);
-                            // Add line clear effects
-                            for (int x = 0; x < fieldWidth; x++) {
-                                effects.push_back({{x * blockSize + offsetX + blockSize / 2, y * blockSize + offsetY + blockSize / 2}, sf::Color::White, 0.5f});
-                            }                    }
-                }            }
-                // Next piece
-                pieceCounter++;
-                if (pieceCounter % 3 == 0) {
-                    // Special piece
-                    currentPiece.type = 7 + (rand() % 4); // 7-10
-                } else {
-                    currentPiece.type = rand() % 7; // 0-6
-                }
-                currentPiece.rotation = 0;
-                currentPiece.x = fieldWidth / 2 - 2;
-                currentPiece.y = 0;
+        if (cpuStats && cpuMeter.elapsed() >= 5.0) {
+            const char* names[] = { "menu", "playing", "game over" };
+            LOG_INFO("cpu: {}% ({})", cpuMeter.sample() * 100.0, isPaused ? "paused" : names[state]);
+        }
 
-                if (!doesPieceFit(currentPiece.type, currentPiece.rotation, currentPiece.x, currentPiece.y)) state = GAME_OVER;
+        // Work out what changed since the last presented frame
+        if (fieldChanged) needsRedraw = true;
+        const Piece& currentPiece = status.piece;
+        if (state == PLAYING && (currentPiece.type != drawnPiece.type || currentPiece.rotation != drawnPiece.rotation ||
+                                 currentPiece.x != drawnPiece.x || currentPiece.y != drawnPiece.y || ghostShadowY != drawnGhostY))
+            needsRedraw = true;
+        if (status.score != drawnScore || status.linesCleared != drawnLines) needsRedraw = true;
+        if (!effects.empty() || drawnEffects != 0) needsRedraw = true;
+        if (!debris.empty() || drawnDebris) needsRedraw = true;
+        if (chainTimer > 0.0f || drawnChain) needsRedraw = true;
+        if (showDebug || syntheticLoadMs > 0.0f) needsRedraw = true;
+        if (capture) needsRedraw = true; // a video needs every frame
+
+        if (!needsRedraw) {
+            // Nothing to present: keep the update rate without touching the GPU
+            window.getPacer().skipFrame();
+            continue;
+        }
+        needsRedraw = false;
+        drawnPiece = currentPiece;
+        drawnGhostY = ghostShadowY;
+        drawnEffects = effects.size();
+        drawnDebris = !debris.empty();
+        drawnChain = chainTimer > 0.0f;
+
+        // Apply the current quality level to the cached layers
+        const QualitySettings& quality = governor.settings();
+        bool starsChanged = quality.starCount != drawnStars;
+        if (starsChanged) {
+            // Stars outside the field only reach fieldLayer through a full
+            // copy; the cells are patched back in below
+            drawBackgroundLayer(quality.starCount);
+            fieldLayer.clear();
+            fieldLayer.draw(sf::Sprite(backgroundLayer.getTexture()));
+            drawnField.assign(fieldWidth * fieldHeight, -1);
+            fieldChanged = true;
+        }
+        if (quality.gridLines != drawnGrid) drawGridLayer(quality.gridLines);
+
+        // Redraw only the field cells that changed
+        if (fieldChanged) {
+            backgroundPatches.clear();
+            fieldBatch.clear();
+            for (int i = 0; i < fieldWidth * fieldHeight; i++) {
+                int x = i % fieldWidth;
+                int y = i / fieldWidth;
+                int value = game->cell(x, y);
+                if (value == drawnField[i]) continue;
+                // The background texture lines up with the screen, so the
+                // patch uses the same coordinates for position and texture
+                float left = (float)(x * blockSize + offsetX), top = (float)(y * blockSize + offsetY), size = (float)blockSize;
+                sf::Vector2f corners[4] = { { left, top }, { left + size, top }, { left + size, top + size }, { left, top + size } };
+                for (const sf::Vector2f& c : corners) backgroundPatches.emplace_back(c, c);
+                if (value != 0) fieldBatch.add(skin.region(value), corners[0], 0, sf::Color::White, skin.scale());
+                drawnField[i] = value;
             }
+            if (!backgroundPatches.empty())
+                fieldLayer.draw(backgroundPatches.data(), backgroundPatches.size(), sf::Quads, &backgroundLayer.getTexture());
+            fieldBatch.draw(fieldLayer);
+            fieldLayer.display();
+            fieldChanged = false;
+        }
+        if (starsChanged && checkLayers) {
+            int mismatches = layerMismatches();
+            if (mismatches) LOG_ERROR("field layer differs from the background in {} pixels after {} stars", mismatches, drawnStars);
+            else LOG_INFO("field layer matches the background with {} stars", drawnStars);
+        }
 
-            speedCounter = 0.0f;
+        if (status.score != drawnScore || status.linesCleared != drawnLines) {
+            scoreText.setString("Score: " + std::to_string(status.score));
+            linesText.setString("Lines: " + std::to_string(status.linesCleared));
+            levelText.setString("Level: " + std::to_string(status.level));
+            drawnScore = status.score;
+            drawnLines = status.linesCleared;
         }
 
         // Render
-        window.clear(sf::Color(0, 0, 20)); // Dark blue space background
-
-        // Draw stars
-        for (auto& star : stars) {
-            sf::CircleShape s(1);
-            s.setPosition(star);
-            s.setFillColor(sf::Color::White);
-            window.draw(s);
-        }
+        window.draw(sf::Sprite(fieldLayer.getTexture()));
 
         if (state == MENU) {
             if (fontLoaded) {
@@ -419,55 +681,29 @@ int main()
                 window.draw(buttonText);
             }
         } else {
-            // Draw field
-            for (int x = 0; x < fieldWidth; x++) {
-                for (int y = 0; y < fieldHeight; y++) {
-                    if (field[y * fieldWidth + x] != 0) {
-                        sf::RectangleShape block(sf::Vector2f(blockSize, blockSize));
-                        block.setPosition(x * blockSize + offsetX, y * blockSize + offsetY);
-                        block.setFillColor(colors[field[y * fieldWidth + x]]);
-                        window.draw(block);
-                    }
-                }
-            }
-
             if (state == PLAYING) {
-                // Draw current piece
-                for (int px = 0; px < 4; px++) {
-                    for (int py = 0; py < 4; py++) {
-                        int pi = rotate(px, py, currentPiece.rotation);
-                        if (tetromino[currentPiece.type][pi] == 'X') {
+                // Current piece on layer 0, the ghost piece's shadow over it
+                pieceBatch.clear();
+                for (int px = 0; px < kPieceBox; px++) {
+                    for (int py = 0; py < kPieceBox; py++) {
+                        if (pieceHasBlock(currentPiece.type, currentPiece.rotation, px, py)) {
                             int x = currentPiece.x + px;
                             int y = currentPiece.y + py;
-                            sf::RectangleShape block(sf::Vector2f(blockSize, blockSize));
-                            block.setPosition(x * blockSize + offsetX, y * blockSize + offsetY);
-                            block.setFillColor(colors[currentPiece.type + 1]);
-                            window.draw(block);
-                        }
-                    }
-                }
-
-                // Draw ghost piece
-                if (currentPiece.type == 10) { // Ghost
-                    for (int px = 0; px < 4; px++) {
-                        for (int py = 0; py < 4; py++) {
-                            int pi = rotate(px, py, currentPiece.rotation);
-                            if (tetromino[currentPiece.type][pi] == 'X') {
-                                int x = currentPiece.x + px;
-                                int y = ghostShadowY + py;
-                                sf::RectangleShape block(sf::Vector2f(blockSize, blockSize));
-                                block.setPosition(x * blockSize + offsetX, y * blockSize + offsetY);
-                                block.setFillColor(sf::Color(255, 255, 255, 100)); // Semi-transparent white
-                                window.draw(block);
+                            sf::Vector2f position(x * blockSize + offsetX, y * blockSize + offsetY);
+                            pieceBatch.add(skin.region(currentPiece.type + 1), position, 0, sf::Color::White, skin.scale());
+                            if (pieceEffect(currentPiece.type) == EFFECT_GHOST) {
+                                position.y = (ghostShadowY + py) * blockSize + offsetY;
+                                pieceBatch.add(skin.ghostRegion(), position, 1, sf::Color(255, 255, 255, 100), skin.scale());
                             }
                         }
                     }
                 }
+                pieceBatch.draw(window);
 
                 // Draw pause button
-                pauseButton.setPosition(300, 200);
+                pauseButton.setPosition(hudX, 200);
                 pauseText.setString(isPaused ? "Resume" : "Pause");
-                pauseText.setPosition(305, 205);
+                pauseText.setPosition(hudX + 5, 205);
                 window.draw(pauseButton);
                 window.draw(pauseText);
 
@@ -487,61 +723,35 @@ int main()
                 c.setFillColor(e.color);
                 window.draw(c);
             }
+            debris.draw(window);
 
-            // Draw border
-            sf::RectangleShape border(sf::Vector2f(fieldWidth * blockSize, fieldHeight * blockSize));
-            border.setPosition(offsetX, offsetY);
-            border.setFillColor(sf::Color::Transparent);
-            border.setOutlineThickness(2);
-            border.setOutlineColor(sf::Color::White);
-            window.draw(border);
-
-            // Draw grid
-            for (int i = 1; i < fieldWidth; i++) {
-                sf::RectangleShape line(sf::Vector2f(1, fieldHeight * blockSize));
-                line.setPosition(i * blockSize + offsetX, offsetY);
-                line.setFillColor(sf::Color(100, 100, 100));
-                window.draw(line);
-            }
-            for (int i = 1; i < fieldHeight; i++) {
-                sf::RectangleShape line(sf::Vector2f(fieldWidth * blockSize, 1));
-                line.setPosition(offsetX, i * blockSize + offsetY);
-                line.setFillColor(sf::Color(100, 100, 100));
-                window.draw(line);
-            }
+            // Draw border and grid
+            window.draw(sf::Sprite(gridLayer.getTexture()));
 
             // Draw score
             if (fontLoaded) {
-                sf::Text scoreText("Score: " + std::to_string(score), font, 20);
-                scoreText.setPosition(300, 50);
-                scoreText.setFillColor(sf::Color::White);
                 window.draw(scoreText);
-
-                sf::Text linesText("Lines: " + std::to_string(linesCleared), font, 20);
-                linesText.setPosition(300, 80);
-                linesText.setFillColor(sf::Color::White);
                 window.draw(linesText);
-
-                sf::Text levelText("Level: " + std::to_string(linesCleared / 10 + 1), font, 20);
-                levelText.setPosition(300, 110);
-                levelText.setFillColor(sf::Color::White);
                 window.draw(levelText);
 
-                if (state == PLAYING && currentPiece.type >= 7) {
-                    std::string name;
-                    if (currentPiece.type == 7) name = "Frozen";
-                    else if (currentPiece.type == 8) name = "Electrical";
-                    else if (currentPiece.type == 9) name = "Fire";
-                    else name = "Ghost";
+                const char* name = specialPieceName(currentPiece.type);
+                if (state == PLAYING && name) {
                     sf::Text specialLabel("Special:", font, 20);
-                    specialLabel.setPosition(300, 140);
+                    specialLabel.setPosition(hudX, 140);
                     specialLabel.setFillColor(sf::Color::White);
                     window.draw(specialLabel);
                     sf::Text specialName(name, font, 20);
-                    specialName.setPosition(300, 170);
+                    specialName.setPosition(hudX, 170);
                     specialName.setFillColor(sf::Color::White);
                     window.draw(specialName);
                 }
+
+                if (state == PLAYING && chainTimer > 0.0f) {
+                    sf::Text chainText("CHAIN x" + std::to_string(chainCount), font, 24);
+                    chainText.setPosition(hudX, 210);
+                    chainText.setFillColor(sf::Color(255, 160, 0));
+                    window.draw(chainText);
+                }
             }
 
             if (state == GAME_OVER) {
@@ -551,6 +761,12 @@ int main()
                     gameOverText.setFillColor(sf::Color::Red);
                     window.draw(gameOverText);
 
+                    if (!gameOverInfo.empty()) {
+                        sf::Text infoText(gameOverInfo, font, 18);
+                        infoText.setPosition(125, 295);
+                        window.draw(infoText);
+                    }
+
                     button.setPosition(150, 350);
                     buttonText.setString("Restart");
                     buttonText.setPosition(160, 360);
@@ -560,9 +776,55 @@ int main()
             }
         }
 
+        if (syntheticLoadMs > 0.0f) {
+            sf::Clock spin;
+            while (spin.getElapsedTime().asSeconds() * 1000.0f < syntheticLoadMs) {
+            }
+        }
+
+        // Frame cost without the frame limiter sleep
+        float frameSeconds = clock.getElapsedTime().asSeconds();
+        governor.addFrame(frameSeconds);
+        frameMetrics.frameSeconds.observe(frameSeconds);
+        frameMetrics.particles.set((int64_t)effects.size());
+
+        if (showDebug) {
+            debugText.setString("FPS: " + std::to_string((int)(fps + 0.5f)) +
+                                "  frame: " + std::to_string((int)(frameSeconds * 1000.0f)) + " ms" +
+                                "  load: " + std::to_string((int)syntheticLoadMs) + " ms\n" +
+                                "jitter: " + std::to_string(window.frameStats().jitterMs()).substr(0, 4) + " ms" +
+                                "  missed: " + std::to_string(window.frameStats().missed) + "\n" +
+                                "effects: " + std::to_string(effects.size()) +
+                                "  debris: " + std::to_string(debris.count()) +
+                                "  quality: " + std::to_string(governor.level()) + "/" + std::to_string(QualityGovernor::kLevels - 1) +
+                                (capture ? "\ncapture: " + std::to_string(capture->written.load()) + " written, " +
+                                               std::to_string(capture->dropped.load()) + " dropped"
+                                         : std::string()));
+            window.draw(debugText);
+        }
+
+        if (readback) {
+            window.setActive(true); // the layers above may have left their own context current
+            readback->capture(*capture);
+        }
+
         window.display();
     }
 
+    if (capture) {
+        capture->finish();
+        uint64_t frames = capture->submitFrames.load(), done = capture->written.load();
+        LOG_INFO("capture: {} frames written, {} dropped", done, capture->dropped.load());
+        LOG_INFO("capture: {} us/frame on the game thread, {} us/frame convert + write",
+                 frames ? capture->submitUs.load() / frames : 0, done ? capture->workerUs.load() / done : 0);
+    }
+    if (trainGames > 0) {
+        // One line for the makefile's report and bench pgo to parse
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - trainStart).count();
+        printf("train: %d games, %llu frames, %.3f s, %.1f us/frame, checksum %016llx\n", trainPlayed,
+               (unsigned long long)trainFrames, seconds, trainFrames ? seconds * 1e6 / trainFrames : 0.0,
+               (unsigned long long)trainChecksum);
+    }
     return 0;
 }
 
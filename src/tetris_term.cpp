@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "PieceSet.hpp"
+#include "TerminalRenderer.hpp"
+#include "TetrisBot.hpp"
+#include "TetrisCore.hpp"
+
+// Terminal front end: the same game core as tetris.exe, drawn with ANSI
+// escape codes so games can be played or watched over SSH on machines with
+// no display. Only the characters that changed are sent each frame.
+//
+// Usage: tetris_term [--mode <name>] [--cascade] [--bot] [--seconds <n>] [--full-redraw] [--pieces <file>]
+//                    [--gravity <rows per tick>] [--lock-delay <ticks>] [--lock-resets <n>]
+//   --bot          the placement bot plays (standard mode only)
+//   --seconds      quits after that long
+//   --full-redraw  repaints the whole screen every frame, for comparing bandwidth
+//   --pieces       plays a piece set from a definition file (see PieceSet.hpp)
+//   --gravity      fixed fall speed instead of the level's, up to 20 (20G)
+//   --lock-delay   ticks (1/60 s) a piece rests on the stack before locking
+//   --lock-resets  moves or rotations on the stack that start that wait over
+// Keys: arrows or WASD, space hard drop, p pause, r restart, q quit.
+// Prints the bytes written per frame on exit.
+
+typedef TetrisGame<FixedBoard<10, 20>, SpecialRules> StandardGame;
+
+// Terminals only report presses (and auto-repeat), never releases, so a
+// movement key counts as held until its repeats stop for this long
+const float kHoldTime = 0.15f;
+const float kStepTime = 1.0f / 60.0f;
+
+int main(int argc, char** argv)
+{
+    bool cascade = false;
+    bool bot = false;
+    bool fullRedraw = false;
+    double seconds = 0.0;
+    double gravityRows = 0.0;
+    int lockDelay = kLockDelay;
+    int lockResets = kLockResets;
+    const GameVariant* variant = &gameVariants[0];
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cascade") == 0) cascade = true;
+        if (strcmp(argv[i], "--bot") == 0) bot = true;
+        if (strcmp(argv[i], "--full-redraw") == 0) fullRedraw = true;
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+        if (strcmp(argv[i], "--gravity") == 0 && i + 1 < argc) gravityRows = atof(argv[++i]);
+        if (strcmp(argv[i], "--lock-delay") == 0 && i + 1 < argc) lockDelay = std::max(0, atoi(argv[++i]));
+        if (strcmp(argv[i], "--lock-resets") == 0 && i + 1 < argc) lockResets = std::max(0, atoi(argv[++i]));
+        if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!loadPieceSet(argv[++i], pieceTable, error)) {
+                std::cerr << "Cannot load piece set " << argv[i] << ": " << error << "\n";
+                return 1;
+            }
+        }
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            variant = findGameVariant(argv[++i]);
+            if (!variant) {
+                std::cerr << "Unknown mode " << argv[i] << ". Available modes:\n";
+                for (const auto& v : gameVariants) std::cerr << "  " << v.name << " - " << v.description << "\n";
+                return 1;
+            }
+        }
+    }
+
+    // The bot needs the concrete board type
+    StandardGame* botGame = nullptr;
+    std::unique_ptr<GameCore> game;
+    if (bot) {
+        botGame = new StandardGame();
+        game.reset(botGame);
+    } else {
+        game = variant->create();
+    }
+    game->cascade = cascade;
+    game->gravity = (int32_t)(std::min(std::max(gravityRows, 0.0), 20.0) * kGravityUnit);
+    game->lockDelay = lockDelay;
+    game->lockResets = lockResets;
+    srand((unsigned)time(NULL));
+    game->reset((uint32_t)rand());
+
+    TerminalScreen screen(2 * game->width() + 26, game->height() + 2);
+    RawTerminal terminal;
+    if (!terminal.isTerminal() && !bot) {
+        std::cerr << "stdin is not a terminal, use --bot to watch without input\n";
+        return 1;
+    }
+
+    float holdLeft = 0.0f, holdRight = 0.0f, holdDown = 0.0f;
+    bool rotatePressed = false, dropPressed = false;
+    bool paused = false;
+    bool running = true;
+    BotMove move = { 0, 0, 0.0f };
+    bool needMove = true;
+    uint8_t previous = 0;
+
+    std::string out;
+    std::string message;
+    uint64_t totalBytes = 0, frames = 0, maxBytes = 0;
+    uint64_t secondBytes = 0, secondFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto nextFrame = start;
+    auto lastReport = start;
+
+    while (running) {
+        // Keys waiting since the last frame; arrows arrive as ESC [ A..D
+        uint8_t c;
+        int escape = 0;
+        while (terminal.readByte(c)) {
+            if (escape == 1) {
+                escape = c == '[' ? 2 : 0;
+                continue;
+            }
+            if (escape == 2) {
+                escape = 0;
+                if (c == 'A') c = 'w';
+                else if (c == 'B') c = 's';
+                else if (c == 'C') c = 'd';
+                else if (c == 'D') c = 'a';
+                else continue;
+            }
+            switch (c) {
+            case 27: escape = 1; break;
+            case 'a': case 'A': holdLeft = kHoldTime; holdRight = 0.0f; break;
+            case 'd': case 'D': holdRight = kHoldTime; holdLeft = 0.0f; break;
+            case 's': case 'S': holdDown = kHoldTime; break;
+            case 'w': case 'W': rotatePressed = true; break;
+            case ' ': dropPressed = true; break;
+            case 'p': case 'P': paused = !paused; break;
+            case 'r': case 'R':
+                game->reset((uint32_t)rand());
+                needMove = true;
+                break;
+            case 'q': case 'Q': case 3: running = false; break;
+            default: break;
+            }
+        }
+
+        if (!paused && !game->status.gameOver) {
+            uint8_t input = 0;
+            if (bot) {
+                if (needMove) {
+                    move = findBotMove(*botGame);
+                    needMove = false;
+                }
+                input = botInput(game->status.piece, move, previous);
+            } else {
+                if (holdLeft > 0.0f) input |= INPUT_LEFT;
+                if (holdRight > 0.0f) input |= INPUT_RIGHT;
+                if (holdDown > 0.0f) input |= INPUT_SOFT_DROP;
+                // Presses last one step, so a repeat is seen as a new press
+                if (rotatePressed && !(previous & INPUT_ROTATE)) input |= INPUT_ROTATE;
+                if (dropPressed && !(previous & INPUT_HARD_DROP)) input |= INPUT_HARD_DROP;
+                if (input & INPUT_ROTATE) rotatePressed = false;
+                if (input & INPUT_HARD_DROP) dropPressed = false;
+            }
+            previous = input;
+            game->step(input, kStepTime);
+            for (int i = 0; i < game->status.eventCount; i++)
+                if (game->status.events[i].type == EVENT_LOCK) needMove = true;
+        }
+        holdLeft -= kStepTime;
+        holdRight -= kStepTime;
+        holdDown -= kStepTime;
+        if (bot && game->status.gameOver) {
+            game->reset((uint32_t)rand());
+            needMove = true;
+        }
+
+        // Draw and send only the difference
+        auto now = std::chrono::steady_clock::now();
+        double sinceReport = std::chrono::duration<double>(now - lastReport).count();
+        if (sinceReport >= 1.0) {
+            message = std::to_string(secondFrames ? secondBytes / secondFrames : 0) + " bytes/frame";
+            secondBytes = secondFrames = 0;
+            lastReport = now;
+        }
+        drawTerminalGame(screen, *game, paused ? "PAUSED" : message);
+        if (fullRedraw) screen.invalidate();
+        out.clear();
+        size_t bytes = screen.present(out);
+        if (bytes) RawTerminal::write(out);
+        totalBytes += bytes;
+        secondBytes += bytes;
+        if (bytes > maxBytes) maxBytes = bytes;
+        frames++;
+        secondFrames++;
+
+        if (seconds > 0 && std::chrono::duration<double>(now - start).count() >= seconds) running = false;
+        nextFrame += std::chrono::microseconds(16667);
+        if (nextFrame < now) nextFrame = now;
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    // Leave the alternate screen before printing
+    terminal.restore();
+    std::cerr << frames << " frames, " << (frames ? totalBytes / frames : 0) << " bytes/frame on average, " << maxBytes
+              << " max, " << totalBytes << " total\n";
+    return 0;
+}
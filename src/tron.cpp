@@ -0,0 +1,142 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "TronBot.hpp"
+#include "TronCore.hpp"
+#include "TronRenderer.hpp"
+
+// Tron light cycles on the headless engine of TronCore.hpp, the portable
+// successor of archive_examples/08_Tron.cpp: red (WASD) against blue (arrow
+// keys) on a 90x90 arena. R starts the next round after a crash.
+// Options:
+//   --size <cells>   arena width and height (default 90)
+//   --cell <pixels>  size of a cell on screen (default 7)
+//   --tick <ms>      time between moves (default 30)
+//   --walls          the border is a wall instead of wrapping around
+//   --players <n>    cycles in the arena (default 2)
+//   --bots <n>       how many of them TronBot drives (default 0); the
+//                    others are humans, at most 2 (red, then blue)
+//   --bot-ms <ms>    think time per bot per tick (default: 80% of the tick
+//                    shared among the bots)
+
+int main(int argc, char** argv)
+{
+    int size = 90;
+    int cellSize = 7;
+    float tickSeconds = 0.03f;
+    bool walls = false;
+    int playerCount = 2;
+    int botCount = 0;
+    float botMs = 0.0f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--walls") == 0) walls = true;
+        if (i + 1 >= argc) continue;
+        if (strcmp(argv[i], "--size") == 0) size = std::max(8, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--cell") == 0) cellSize = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--tick") == 0) tickSeconds = (float)atof(argv[++i]) / 1000.0f;
+        else if (strcmp(argv[i], "--players") == 0) playerCount = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--bots") == 0) botCount = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--bot-ms") == 0) botMs = (float)atof(argv[++i]);
+    }
+    if (playerCount > size * size) {
+        LOG_WARN("a {}x{} arena fits {} cycles, not {}", size, size, size * size, playerCount);
+        playerCount = size * size;
+    }
+    botCount = std::min(botCount, playerCount);
+    if (playerCount - botCount > 2) {
+        LOG_WARN("only 2 players can use the keyboard; the other {} cycles are bots", playerCount - botCount - 2);
+        botCount = playerCount - 2;
+    }
+    const int humans = playerCount - botCount;
+    if (botMs <= 0.0f && botCount > 0) botMs = tickSeconds * 1000.0f * 0.8f / botCount;
+    std::vector<TronBot> bots(botCount, TronBot((int)(botMs * 1000.0f)));
+
+    sf::RenderWindow window(sf::VideoMode(size * cellSize, size * cellSize), "Tron");
+    window.setFramerateLimit(120);
+
+    TronGame game;
+    game.wrap = !walls;
+    TronRenderer renderer(size, size, cellSize);
+    uint32_t round = 1;
+    std::vector<int> scores(playerCount, 0);
+    game.reset(size, size, playerCount, round);
+    renderer.reset(game);
+
+    // The last key pressed wins until the next tick, as in the original.
+    // Humans are the first players, the bots come after them.
+    std::vector<uint8_t> inputs(playerCount, TRON_KEEP);
+    auto press = [&](int player, uint8_t dir) {
+        if (player < humans) inputs[player] = dir;
+    };
+    sf::Clock clock;
+    float accumulator = 0.0f;
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) window.close();
+            if (event.type != sf::Event::KeyPressed) continue;
+            switch (event.key.code) {
+            case sf::Keyboard::W: press(0, TRON_UP); break;
+            case sf::Keyboard::D: press(0, TRON_RIGHT); break;
+            case sf::Keyboard::S: press(0, TRON_DOWN); break;
+            case sf::Keyboard::A: press(0, TRON_LEFT); break;
+            case sf::Keyboard::Up: press(1, TRON_UP); break;
+            case sf::Keyboard::Right: press(1, TRON_RIGHT); break;
+            case sf::Keyboard::Down: press(1, TRON_DOWN); break;
+            case sf::Keyboard::Left: press(1, TRON_LEFT); break;
+            case sf::Keyboard::R:
+                if (game.over()) {
+                    game.reset(size, size, playerCount, ++round);
+                    renderer.reset(game);
+                    std::fill(inputs.begin(), inputs.end(), (uint8_t)TRON_KEEP);
+                    accumulator = 0.0f;
+                }
+                break;
+            case sf::Keyboard::Escape: window.close(); break;
+            default: break;
+            }
+        }
+
+        accumulator += clock.restart().asSeconds();
+        while (accumulator >= tickSeconds && !game.over()) {
+            accumulator -= tickSeconds;
+            for (int b = 0; b < botCount; b++) {
+                if (game.players[humans + b].alive) inputs[humans + b] = bots[b].choose(game, humans + b);
+            }
+            game.step(inputs.data());
+            renderer.add(game);
+            std::fill(inputs.begin(), inputs.end(), (uint8_t)TRON_KEEP);
+            if (game.over()) {
+                int winner = game.winner();
+                if (winner >= 0) scores[winner]++;
+                if (playerCount == 2) {
+                    LOG_INFO("round {}: {} after {} ticks, red {} blue {}. Press R for the next round", round,
+                             winner == 0 ? "red wins" : (winner == 1 ? "blue wins" : "draw"), game.tick, scores[0], scores[1]);
+                    window.setTitle("Tron - Red " + std::to_string(scores[0]) + " : " + std::to_string(scores[1]) + " Blue");
+                } else {
+                    LOG_INFO("round {}: {} after {} ticks. Press R for the next round", round,
+                             winner >= 0 ? "player " + std::to_string(winner + 1) + " wins" : std::string("draw"), game.tick);
+                    window.setTitle("Tron - round " + std::to_string(round));
+                }
+                for (int b = 0; b < botCount; b++) {
+                    const TronBot& bot = bots[b];
+                    uint64_t decisions = std::max<uint64_t>(bot.decisions, 1);
+                    LOG_INFO("player {} (bot): {} nodes/s, average depth {}, {} ms per move of {}", humans + b + 1,
+                             (uint64_t)(bot.totalNodes / std::max(bot.totalSeconds, 1e-9)), (double)bot.totalDepth / decisions,
+                             bot.totalSeconds * 1000.0 / decisions, botMs);
+                }
+            }
+        }
+        if (game.over()) accumulator = 0.0f;
+
+        window.clear(sf::Color::Black);
+        renderer.draw(window);
+        window.display();
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "PieceColors.hpp"
+#include "Versus.hpp"
+
+// Two-player versus over UDP with rollback netcode. Start one instance per
+// player, on the same machine or on two machines of a LAN:
+//   versus.exe --player 0
+//   versus.exe --player 1
+// Options:
+//   --peer <address>  the other player's machine (default 127.0.0.1)
+//   --port <n>        player 0 listens on n, player 1 on n + 1 (default 54000)
+//   --seed <n>        both players must use the same seed (default 1)
+//   --latency <ms> --jitter <ms> --loss <percent>
+//                     delay or drop our outgoing packets to test bad networks
+
+static double nowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv)
+{
+    int player = 0;
+    std::string peer = "127.0.0.1";
+    unsigned short basePort = 54000;
+    uint32_t seed = 1;
+    double latencyMs = 0.0, jitterMs = 0.0, lossPercent = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) break;
+        if (strcmp(argv[i], "--player") == 0) player = atoi(argv[++i]) ? 1 : 0;
+        else if (strcmp(argv[i], "--peer") == 0) peer = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0) basePort = (unsigned short)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latency") == 0) latencyMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--jitter") == 0) jitterMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--loss") == 0) lossPercent = atof(argv[++i]);
+    }
+
+    sf::UdpSocket socket;
+    if (socket.bind(basePort + player) != sf::Socket::Done) {
+        LOG_ERROR("could not bind UDP port {}", basePort + player);
+        return 1;
+    }
+    socket.setBlocking(false);
+    sf::IpAddress peerAddress(peer);
+    unsigned short peerPort = basePort + (1 - player);
+
+    // About 250 KB of snapshots, keep it off the stack
+    std::unique_ptr<RollbackSession> sessionPtr(new RollbackSession(player, seed));
+    RollbackSession& session = *sessionPtr;
+    LagSimulator lag(latencyMs, jitterMs, lossPercent, seed + player);
+
+    const int fieldWidth = 10;
+    const int fieldHeight = 20;
+    const int blockSize = 24;
+    const int boardGap = 160;
+    const int offsetX = 40;
+    const int offsetY = 40;
+    sf::RenderWindow window(sf::VideoMode(2 * fieldWidth * blockSize + boardGap + 2 * offsetX, fieldHeight * blockSize + 2 * offsetY),
+                            player == 0 ? "Tetris Versus - Player 1" : "Tetris Versus - Player 2");
+    window.setVerticalSyncEnabled(true);
+
+    sf::Font font;
+    bool fontLoaded = font.loadFromFile("assets/fonts/Minecraft.ttf");
+    if (!fontLoaded) LOG_WARN("font not loaded, expected assets/fonts/Minecraft.ttf");
+    sf::Text infoText;
+    if (fontLoaded) infoText.setFont(font);
+    infoText.setCharacterSize(14);
+    infoText.setFillColor(sf::Color(0, 255, 0));
+    infoText.setPosition(offsetX + fieldWidth * blockSize + 10, offsetY);
+
+    // Fixed 60 Hz simulation; rendering follows whatever the display does
+    const double frameTime = VersusMatch::kFrameTime;
+    double accumulator = 0.0;
+    double last = nowSeconds();
+    std::vector<uint8_t> datagram(sf::UdpSocket::MaxDatagramSize);
+    std::vector<uint8_t> delayed;
+    uint8_t buffer[128];
+
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) window.close();
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) window.close();
+        }
+
+        double now = nowSeconds();
+        accumulator += now - last;
+        last = now;
+        if (accumulator > 0.25) accumulator = 0.25; // do not spiral after a hitch
+
+        // Network in: everything that arrived since the last frame
+        std::size_t received;
+        sf::IpAddress sender;
+        unsigned short senderPort;
+        while (socket.receive(datagram.data(), datagram.size(), received, sender, senderPort) == sf::Socket::Done) {
+            InputPacket packet;
+            if (senderPort == peerPort && packet.read(datagram.data(), received)) session.receivePacket(packet);
+        }
+
+        // Simulate; local input is never delayed, the remote one is predicted
+        while (accumulator >= frameTime) {
+            uint8_t input = 0;
+            if (window.hasFocus() && !session.state().over()) {
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) input |= INPUT_LEFT;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) input |= INPUT_RIGHT;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) input |= INPUT_ROTATE;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) input |= INPUT_SOFT_DROP;
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) input |= INPUT_HARD_DROP;
+            }
+            if (!session.advance(input)) {
+                accumulator = 0.0; // too far ahead of the other player, wait for them
+                break;
+            }
+            accumulator -= frameTime;
+        }
+
+        // Network out: our unacknowledged inputs, through the lag simulator
+        lag.send(buffer, session.makePacket().write(buffer), now);
+        while (lag.receive(delayed, now)) socket.send(delayed.data(), delayed.size(), peerAddress, peerPort);
+
+        // Render both boards, ours on the left
+        const VersusMatch& match = session.state();
+        window.clear(sf::Color(0, 0, 20));
+        sf::RectangleShape block(sf::Vector2f(blockSize - 1, blockSize - 1));
+        for (int side = 0; side < 2; side++) {
+            const VersusGame& game = match.players[side == 0 ? player : 1 - player];
+            float left = offsetX + side * (fieldWidth * blockSize + boardGap);
+
+            sf::RectangleShape border(sf::Vector2f(fieldWidth * blockSize, fieldHeight * blockSize));
+            border.setPosition(left, offsetY);
+            border.setFillColor(sf::Color::Transparent);
+            border.setOutlineThickness(2);
+            border.setOutlineColor(sf::Color::White);
+            window.draw(border);
+
+            for (int y = 0; y < fieldHeight; y++) {
+                for (int x = 0; x < fieldWidth; x++) {
+                    int value = game.cell(x, y);
+                    if (!value) continue;
+                    block.setPosition(left + x * blockSize, offsetY + y * blockSize);
+                    block.setFillColor(pieceColor(value));
+                    window.draw(block);
+                }
+            }
+
+            const Piece& p = game.status.piece;
+            if (!game.status.gameOver) {
+                block.setFillColor(pieceColor(p.type + 1));
+                for (int py = 0; py < 4; py++) {
+                    for (int px = 0; px < 4; px++) {
+                        if (!pieceHasBlock(p.type, p.rotation, px, py) || p.y + py < 0) continue;
+                        block.setPosition(left + (p.x + px) * blockSize, offsetY + (p.y + py) * blockSize);
+                        window.draw(block);
+                    }
+                }
+            }
+        }
+
+        if (fontLoaded) {
+            const RollbackStats& stats = session.stats;
+            const GameStatus& mine = match.players[player].status;
+            const GameStatus& theirs = match.players[1 - player].status;
+            std::string info = "You: " + std::to_string(mine.score) + "\nThem: " + std::to_string(theirs.score) +
+                               "\n\nframe " + std::to_string(match.frame) +
+                               "\npredicted " + std::to_string(session.prediction()) +
+                               "\nrollbacks " + std::to_string(stats.rollbacks) +
+                               "\navg depth " + std::to_string(stats.averageDepth()).substr(0, 4) +
+                               "\nmax depth " + std::to_string(stats.maxDepth) +
+                               "\nresim " + std::to_string(stats.resimUsPerFrame()).substr(0, 5) + " us/f" +
+                               "\nstalls " + std::to_string(stats.stalls);
+            if (stats.desyncs) info += "\nDESYNC x" + std::to_string(stats.desyncs);
+            if (match.over()) info += mine.gameOver && !theirs.gameOver ? "\n\nYOU LOSE" : (theirs.gameOver && !mine.gameOver ? "\n\nYOU WIN" : "\n\nDRAW");
+            infoText.setString(info);
+            window.draw(infoText);
+        }
+        window.display();
+    }
+
+    const RollbackStats& stats = session.stats;
+    std::cout << "frames " << stats.frames << ", rollbacks " << stats.rollbacks << ", avg depth " << stats.averageDepth()
+              << ", max depth " << stats.maxDepth << ", resim " << stats.resimUsPerFrame() << " us/frame, stalls "
+              << stats.stalls << ", desyncs " << stats.desyncs << ", lag simulator dropped " << lag.dropped << "/" << lag.sent << "\n";
+    return 0;
+}